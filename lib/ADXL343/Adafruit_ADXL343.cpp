@@ -185,6 +185,108 @@ bool Adafruit_ADXL343::getXYZ(int16_t &x, int16_t &y, int16_t &z) {
   return true;
 }
 
+/**************************************************************************/
+/*!
+    @brief  Starts reading the x, y, and z data registers in the background
+            (DMA or the I2C interrupt on the Teensy, see
+            Adafruit_BusIO_Register::read_async) so other work can go on
+            meanwhile. finishXYZ() gets the result. Nothing else may use the
+            bus until then.
+    @return True if the read was started
+*/
+/**************************************************************************/
+bool Adafruit_ADXL343::startXYZ(void) {
+  Adafruit_BusIO_Register reg_obj = Adafruit_BusIO_Register(
+      i2c_dev, spi_dev, AD8_HIGH_TOREAD_AD7_HIGH_TOINC, ADXL3XX_REG_DATAX0, 6);
+  _xyz_started = reg_obj.read_async((uint8_t *)_xyz, 6);
+  return _xyz_started;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Waits for the read startXYZ() started and returns it
+    @param x reference to return x acceleration data
+    @param y reference to return y acceleration data
+    @param z reference to return z acceleration data
+    @return False if no read was started, or it failed
+*/
+/**************************************************************************/
+bool Adafruit_ADXL343::finishXYZ(int16_t &x, int16_t &y, int16_t &z) {
+  if (!_xyz_started)
+    return false;
+  _xyz_started = false;
+  if (spi_dev)
+    spi_dev->wait();
+  if (i2c_dev && !i2c_dev->wait())
+    return false;
+  x = _xyz[0];
+  y = _xyz[1];
+  z = _xyz[2];
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the FIFO mode. Stream mode keeps the newest 32 samples, so
+            a late read loses the oldest ones instead of the newest.
+
+    @param mode The FIFO mode
+    @param watermark Number of samples that sets the watermark interrupt,
+                     0 to 31
+
+    @return True if the operation was successful, otherwise false.
+*/
+/**************************************************************************/
+bool Adafruit_ADXL343::setFifoMode(adxl3xx_fifo_mode_t mode,
+                                   uint8_t watermark) {
+  Adafruit_BusIO_Register fifo_ctl = Adafruit_BusIO_Register(
+      i2c_dev, spi_dev, AD8_HIGH_TOREAD_AD7_HIGH_TOINC, ADXL3XX_REG_FIFO_CTL,
+      1);
+  _fifo_overflows = 0;
+  return fifo_ctl.write(mode << 6 | (watermark & 0x1F));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the FIFO mode
+
+    @return The current FIFO mode, a chip that lost power is back in bypass
+*/
+/**************************************************************************/
+adxl3xx_fifo_mode_t Adafruit_ADXL343::getFifoMode(void) {
+  return (adxl3xx_fifo_mode_t)(readRegister(ADXL3XX_REG_FIFO_CTL) >> 6);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Drains the FIFO, oldest sample first. Each sample is its own 6
+            byte read of the data registers (that is what pops the FIFO), all
+            through the same register object, with ADXL3XX_FIFO_POP_US
+            between them.
+
+    @param xyz Filled with up to max_samples raw X, Y, Z samples
+    @param max_samples Size of xyz
+
+    @return The number of samples read, or -1 on a bus error
+*/
+/**************************************************************************/
+int Adafruit_ADXL343::readFifo(int16_t (*xyz)[3], uint8_t max_samples) {
+  uint8_t entries = readRegister(ADXL3XX_REG_FIFO_STATUS) & 0x3F;
+  if (entries >= ADXL3XX_FIFO_DEPTH)
+    _fifo_overflows++; // full, in stream mode the oldest are being dropped
+
+  uint8_t n = entries < max_samples ? entries : max_samples;
+  Adafruit_BusIO_Register data = Adafruit_BusIO_Register(
+      i2c_dev, spi_dev, AD8_HIGH_TOREAD_AD7_HIGH_TOINC, ADXL3XX_REG_DATAX0, 6);
+  for (uint8_t i = 0; i < n; i++) {
+    if (i)
+      delayMicroseconds(ADXL3XX_FIFO_POP_US);
+    if (!data.read((uint8_t *)xyz[i], 6))
+      return -1;
+  }
+  return n;
+}
+
 /**************************************************************************/
 /*!
  *   @brief  Instantiates a new ADXL343 class
@@ -72,6 +72,9 @@
 #define ADXL3XX_REG_FIFO_STATUS (0x39) /**< FIFO status */
 /*=========================================================================*/
 
+#define ADXL3XX_FIFO_DEPTH (32) /**< FIFO levels */
+#define ADXL3XX_FIFO_POP_US (5) /**< min time from one FIFO read to the next */
+
 /*=========================================================================
     REGISTERS
     -----------------------------------------------------------------------*/
@@ -128,6 +131,14 @@ typedef enum {
   ADXL34X_RANGE_2_G = 0b00   /**< +/- 2g (default value) */
 } adxl34x_range_t;
 
+/** Used with register 0x38 (ADXL3XX_REG_FIFO_CTL) to set the FIFO mode */
+typedef enum {
+  ADXL3XX_FIFO_BYPASS = 0b00,  /**< no FIFO (default value) */
+  ADXL3XX_FIFO_FIFO = 0b01,    /**< collects until full, then stops */
+  ADXL3XX_FIFO_STREAM = 0b10,  /**< keeps the newest 32, oldest dropped */
+  ADXL3XX_FIFO_TRIGGER = 0b11, /**< stream until a trigger, then fill */
+} adxl3xx_fifo_mode_t;
+
 /** Possible interrupts sources on the ADXL343. */
 union int_config {
   uint8_t value; /**< Composite 8-bit value of the bitfield.*/
@@ -186,6 +197,15 @@ public:
   int16_t getY(void);
   int16_t getZ(void);
   bool getXYZ(int16_t &x, int16_t &y, int16_t &z);
+  bool startXYZ(void);
+  bool finishXYZ(int16_t &x, int16_t &y, int16_t &z);
+
+  bool setFifoMode(adxl3xx_fifo_mode_t mode, uint8_t watermark = 0);
+  adxl3xx_fifo_mode_t getFifoMode(void);
+  int readFifo(int16_t (*xyz)[3], uint8_t max_samples);
+  /** @brief Reads that found the FIFO full, samples may have been lost
+      @return Number of full FIFOs since setFifoMode() */
+  uint32_t getFifoOverflows(void) { return _fifo_overflows; }
 
 protected:
   Adafruit_SPIDevice *spi_dev = NULL; ///< BusIO SPI device
@@ -195,6 +215,10 @@ protected:
   SPIClass *_spi = NULL;  ///< SPI hardware interface
   int32_t _sensorID;      ///< User-set sensor identifier
   adxl34x_range_t _range; ///< cache of range
+  uint32_t _spiFreq = 1000000; ///< hardware SPI clock
+  uint32_t _fifo_overflows = 0; ///< see getFifoOverflows()
+  int16_t _xyz[3] = {0, 0, 0};  ///< startXYZ() reads into this
+  bool _xyz_started = false;    ///< startXYZ() ran since the last finishXYZ()
   uint8_t _clk,           ///< SPI software clock
       _do,                ///< SPI software data out
       _di,                ///< SPI software data in
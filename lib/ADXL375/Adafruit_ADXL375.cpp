@@ -51,11 +51,15 @@ Adafruit_ADXL375::Adafruit_ADXL375(int32_t sensorID, TwoWire *wireBus)
     @param theSPI SPIClass instance to use for SPI communication.
     @param sensorID An optional ID # so you can track this sensor, it will tag
            sensorEvents you create.
+    @param frequency SPI clock, the 3200 and 1600 Hz data rates need 2 MHz
+           or more
 */
 /**************************************************************************/
 Adafruit_ADXL375::Adafruit_ADXL375(uint8_t cs, SPIClass *theSPI,
-                                   int32_t sensorID)
-    : Adafruit_ADXL343(cs, theSPI, sensorID) {}
+                                   int32_t sensorID, uint32_t frequency)
+    : Adafruit_ADXL343(cs, theSPI, sensorID) {
+  _spiFreq = frequency;
+}
 
 /**************************************************************************/
 /*!
@@ -101,7 +105,7 @@ bool Adafruit_ADXL375::begin(uint8_t i2caddr) {
     if (_spi) {
       // hardware spi
       spi_dev = new Adafruit_SPIDevice(_cs,
-                                       1000000,               // frequency
+                                       _spiFreq,              // frequency
                                        SPI_BITORDER_MSBFIRST, // bit order
                                        SPI_MODE3,             // data mode
                                        _spi);                 // hardware SPI
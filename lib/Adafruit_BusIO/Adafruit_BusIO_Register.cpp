@@ -206,33 +206,72 @@ bool Adafruit_BusIO_Register::read(uint8_t *buffer, uint8_t len) {
     return _i2cdevice->write_then_read(addrbuffer, _addrwidth, buffer, len);
   }
   if (_spidevice) {
-    if (_spiregtype == ADDRESSED_OPCODE_BIT0_LOW_TO_WRITE) {
-      // very special case!
+    uint8_t addrlen = spiAddress(addrbuffer);
+    return _spidevice->write_then_read(addrbuffer, addrlen, buffer, len);
+  }
+  return false;
+}
 
-      // pass the special opcode address which we set as the high byte of the
-      // regaddr
-      addrbuffer[0] =
-          (uint8_t)(_address >> 8) | 0x01; // set bottom bit high to read
-      // the 'actual' reg addr is the second byte then
-      addrbuffer[1] = (uint8_t)(_address & 0xFF);
-      // the address appears to be a byte longer
-      return _spidevice->write_then_read(addrbuffer, _addrwidth + 1, buffer,
-                                         len);
-    }
-    if (_spiregtype == ADDRBIT8_HIGH_TOREAD) {
-      addrbuffer[0] |= 0x80;
-    }
-    if (_spiregtype == ADDRBIT8_HIGH_TOWRITE) {
-      addrbuffer[0] &= ~0x80;
-    }
-    if (_spiregtype == AD8_HIGH_TOREAD_AD7_HIGH_TOINC) {
-      addrbuffer[0] |= 0x80 | 0x40;
-    }
-    return _spidevice->write_then_read(addrbuffer, _addrwidth, buffer, len);
+/*!
+ *    @brief  read() without waiting for it, see
+ * Adafruit_SPIDevice::write_then_read_async() and
+ * Adafruit_I2CDevice::write_then_read_async()
+ *    @param  buffer Pointer to buffer of data to read into, has to stay around
+ * until the read is done
+ *    @param  len Number of bytes to read
+ *    @param  callback Called when the bytes are in buffer, can be nullptr
+ *    @param  context Passed to callback
+ *    @return False if the read couldn't be started
+ */
+bool Adafruit_BusIO_Register::read_async(uint8_t *buffer, uint8_t len,
+                                         BusIO_AsyncCallback callback,
+                                         void *context) {
+  uint8_t addrbuffer[2] = {(uint8_t)(_address & 0xFF),
+                           (uint8_t)(_address >> 8)};
+
+  if (_i2cdevice) {
+    return _i2cdevice->write_then_read_async(addrbuffer, _addrwidth, buffer,
+                                             len, callback, context);
+  }
+  if (_spidevice) {
+    uint8_t addrlen = spiAddress(addrbuffer);
+    return _spidevice->write_then_read_async(addrbuffer, addrlen, buffer, len,
+                                             callback, context);
   }
   return false;
 }
 
+/*!
+ *    @brief  Turns the register address into what is sent over SPI to read
+ * it, for the register's Adafruit_BusIO_SPIRegType
+ *    @param  addrbuffer The address, little endian, changed in place
+ *    @return Number of address bytes to send
+ */
+uint8_t Adafruit_BusIO_Register::spiAddress(uint8_t *addrbuffer) {
+  if (_spiregtype == ADDRESSED_OPCODE_BIT0_LOW_TO_WRITE) {
+    // very special case!
+
+    // pass the special opcode address which we set as the high byte of the
+    // regaddr
+    addrbuffer[0] =
+        (uint8_t)(_address >> 8) | 0x01; // set bottom bit high to read
+    // the 'actual' reg addr is the second byte then
+    addrbuffer[1] = (uint8_t)(_address & 0xFF);
+    // the address appears to be a byte longer
+    return _addrwidth + 1;
+  }
+  if (_spiregtype == ADDRBIT8_HIGH_TOREAD) {
+    addrbuffer[0] |= 0x80;
+  }
+  if (_spiregtype == ADDRBIT8_HIGH_TOWRITE) {
+    addrbuffer[0] &= ~0x80;
+  }
+  if (_spiregtype == AD8_HIGH_TOREAD_AD7_HIGH_TOINC) {
+    addrbuffer[0] |= 0x80 | 0x40;
+  }
+  return _addrwidth;
+}
+
 /*!
  *    @brief  Read 2 bytes of data from the register location
  *    @param  value Pointer to uint16_t variable to read into
@@ -58,6 +58,9 @@ public:
                           uint8_t address_width = 1);
 
   bool read(uint8_t *buffer, uint8_t len);
+  bool read_async(uint8_t *buffer, uint8_t len,
+                  BusIO_AsyncCallback callback = nullptr,
+                  void *context = nullptr);
   bool read(uint8_t *value);
   bool read(uint16_t *value);
   uint32_t read(void);
@@ -75,6 +78,8 @@ public:
   void println(Stream *s = &Serial);
 
 private:
+  uint8_t spiAddress(uint8_t *addrbuffer);
+
   Adafruit_I2CDevice *_i2cdevice;
   Adafruit_SPIDevice *_spidevice;
   Adafruit_BusIO_SPIRegType _spiregtype;
@@ -99,6 +99,7 @@ bool Adafruit_I2CDevice::detected(void) {
 bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
                                const uint8_t *prefix_buffer,
                                size_t prefix_len) {
+  wait(); // an async transfer still has the bus
   if ((len + prefix_len) > maxBufferSize()) {
     // currently not guaranteed to work if more than 32 bytes!
     // we will need to find out if some platforms have larger
@@ -178,6 +179,7 @@ bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
  *    @return True if read was successful, otherwise false.
  */
 bool Adafruit_I2CDevice::read(uint8_t *buffer, size_t len, bool stop) {
+  wait();
   size_t pos = 0;
   while (pos < len) {
     size_t read_len =
@@ -315,3 +317,169 @@ bool Adafruit_I2CDevice::setSpeed(uint32_t desiredclk) {
   return false;
 #endif
 }
+
+#ifdef BUSIO_HAS_ASYNC_I2C
+// the device whose async transfer is running on Wire, Wire1, Wire2
+static Adafruit_I2CDevice *async_active[3];
+static IMXRT_LPI2C_t *const async_ports[3] = {&IMXRT_LPI2C1, &IMXRT_LPI2C3,
+                                              &IMXRT_LPI2C4};
+static const IRQ_NUMBER_t async_irqs[3] = {IRQ_LPI2C1, IRQ_LPI2C3,
+                                           IRQ_LPI2C4};
+
+#define ASYNC_I2C_ERRORS                                                       \
+  (LPI2C_MSR_NDF | LPI2C_MSR_ALF | LPI2C_MSR_FEF | LPI2C_MSR_PLTF)
+#endif
+
+/*!
+ *    @brief  write_then_read() without waiting for it. On the Teensy 4 the
+ * transfer is run by the LPI2C interrupt and the call returns right away, the
+ * read bytes are in read_buffer when callback runs (in the interrupt). Poll
+ * busy() or wait() for it instead, if you like. Elsewhere it is a blocking
+ * write_then_read() that runs the callback before returning. Until it is done
+ * nothing else may use the bus: blocking calls on this device wait for it, but
+ * other devices on the same bus don't know about it
+ *    @param  write_buffer Pointer to buffer of data to write from, copied
+ * before this returns
+ *    @param  write_len Number of bytes from buffer to write.
+ *    @param  read_buffer Pointer to buffer of data to read into, has to stay
+ * around until the transfer is done
+ *    @param  read_len Number of bytes from buffer to read.
+ *    @param  callback Called when the transfer is done, can be nullptr. wait()
+ * says whether it worked
+ *    @param  context Passed to callback
+ *    @return False if write_len + read_len is over I2CDEVICE_ASYNC_MAX, or the
+ * transfer couldn't be started (nothing was sent then)
+ */
+bool Adafruit_I2CDevice::write_then_read_async(
+    const uint8_t *write_buffer, size_t write_len, uint8_t *read_buffer,
+    size_t read_len, BusIO_AsyncCallback callback, void *context) {
+  if (write_len + read_len > I2CDEVICE_ASYNC_MAX)
+    return false;
+  wait();
+
+#ifdef BUSIO_HAS_ASYNC_I2C
+  int bus = _wire == &Wire ? 0 : _wire == &Wire1 ? 1 : _wire == &Wire2 ? 2 : -1;
+  if (bus >= 0) {
+    IMXRT_LPI2C_t *port = async_ports[bus];
+    if (port->MSR & LPI2C_MSR_MBF)
+      return false; // a blocking transfer didn't finish
+
+    uint8_t n = 0;
+    if (write_len) {
+      _async_cmds[n++] = LPI2C_MTDR_CMD_START | (_addr << 1);
+      for (size_t i = 0; i < write_len; i++)
+        _async_cmds[n++] = LPI2C_MTDR_CMD_TRANSMIT | write_buffer[i];
+    }
+    if (read_len) {
+      _async_cmds[n++] = LPI2C_MTDR_CMD_START | (_addr << 1) | 1;
+      _async_cmds[n++] = LPI2C_MTDR_CMD_RECEIVE | (read_len - 1);
+    }
+    _async_cmds[n++] = LPI2C_MTDR_CMD_STOP;
+    _async_ncmds = n;
+    _async_next = 0;
+    _async_read_buffer = read_buffer;
+    _async_read_len = read_len;
+    _async_received = 0;
+    _async_callback = callback;
+    _async_context = context;
+    _async_error = false;
+    _async_port = port;
+
+    // the ISR is Wire's slave one otherwise, Wire doesn't use it as master
+    static void (*const isrs[3])(void) = {&asyncIsr1, &asyncIsr3, &asyncIsr4};
+    async_active[bus] = this;
+    attachInterruptVector(async_irqs[bus], isrs[bus]);
+    NVIC_ENABLE_IRQ(async_irqs[bus]);
+
+    port->MCR |= LPI2C_MCR_RTF | LPI2C_MCR_RRF;
+    port->MSR = LPI2C_MSR_EPF | LPI2C_MSR_SDF | ASYNC_I2C_ERRORS;
+    port->MFCR = LPI2C_MFCR_RXWATER(0) | LPI2C_MFCR_TXWATER(1);
+    _async_busy = true;
+    port->MIER = LPI2C_MIER_TDIE | LPI2C_MIER_RDIE | LPI2C_MIER_SDIE |
+                 LPI2C_MIER_NDIE | LPI2C_MIER_ALIE | LPI2C_MIER_FEIE |
+                 LPI2C_MIER_PLTIE; // TDF is set, the ISR starts the transfer
+    return true;
+  }
+#endif
+
+  _async_error = !write_then_read(write_buffer, write_len, read_buffer,
+                                  read_len);
+  if (_async_error)
+    return false;
+  if (callback)
+    callback(context);
+  return true;
+}
+
+/*!
+ *    @brief  Blocks until the async transfer in flight, if any, is done
+ *    @return False if the last async transfer failed (NACK, lost the bus)
+ */
+bool Adafruit_I2CDevice::wait(void) {
+  while (_async_busy)
+    yield();
+  return !_async_error;
+}
+
+#ifdef BUSIO_HAS_ASYNC_I2C
+/*!
+ *    @brief  LPI2C1 (Wire) interrupt while an async transfer runs
+ */
+void Adafruit_I2CDevice::asyncIsr1(void) { async_active[0]->asyncService(); }
+/*!
+ *    @brief  LPI2C3 (Wire1) interrupt while an async transfer runs
+ */
+void Adafruit_I2CDevice::asyncIsr3(void) { async_active[1]->asyncService(); }
+/*!
+ *    @brief  LPI2C4 (Wire2) interrupt while an async transfer runs
+ */
+void Adafruit_I2CDevice::asyncIsr4(void) { async_active[2]->asyncService(); }
+
+/*!
+ *    @brief  Moves the async transfer along: commands into the 4 word
+ * transmit FIFO, bytes out of the receive FIFO, done on the STOP
+ */
+void Adafruit_I2CDevice::asyncService(void) {
+  IMXRT_LPI2C_t *port = _async_port;
+  uint32_t status = port->MSR;
+
+  if (status & ASYNC_I2C_ERRORS) {
+    // like Wire does on a NACK: drop what is queued and send the STOP
+    port->MCR |= LPI2C_MCR_RTF | LPI2C_MCR_RRF;
+    port->MSR = ASYNC_I2C_ERRORS;
+    if (status & LPI2C_MSR_MBF)
+      port->MTDR = LPI2C_MTDR_CMD_STOP;
+    _async_error = true;
+    asyncDone();
+    return;
+  }
+
+  while (_async_received < _async_read_len) {
+    uint32_t data = port->MRDR;
+    if (data & LPI2C_MRDR_RXEMPTY)
+      break;
+    _async_read_buffer[_async_received++] = data;
+  }
+
+  while (_async_next < _async_ncmds && (port->MFSR & 0x7) < 4)
+    port->MTDR = _async_cmds[_async_next++];
+  if (_async_next == _async_ncmds)
+    port->MIER &= ~LPI2C_MIER_TDIE;
+
+  if (status & LPI2C_MSR_SDF) {
+    port->MSR = LPI2C_MSR_SDF;
+    _async_error = _async_received < _async_read_len;
+    asyncDone();
+  }
+}
+
+/*!
+ *    @brief  Hands the bus back to Wire and runs the callback
+ */
+void Adafruit_I2CDevice::asyncDone(void) {
+  _async_port->MIER = 0;
+  _async_busy = false;
+  if (_async_callback)
+    _async_callback(_async_context);
+}
+#endif
@@ -4,6 +4,21 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+#if defined(__IMXRT1062__) // Teensy 4.x, interrupt driven LPI2C transfers
+#define BUSIO_HAS_ASYNC_I2C
+#endif
+
+#ifndef BUSIO_ASYNC_CALLBACK
+#define BUSIO_ASYNC_CALLBACK
+/**! Called when an async transfer is done, from the bus interrupt on the
+ * Teensy. Gets the context the transfer was started with **/
+typedef void (*BusIO_AsyncCallback)(void *context);
+#endif
+
+/**! Largest write + read of one async transfer. Register bursts, not FIFO
+ * drains **/
+#define I2CDEVICE_ASYNC_MAX 32
+
 ///< The class which defines how we will talk to this device over I2C
 class Adafruit_I2CDevice {
 public:
@@ -21,6 +36,15 @@ public:
                        bool stop = false);
   bool setSpeed(uint32_t desiredclk);
 
+  bool write_then_read_async(const uint8_t *write_buffer, size_t write_len,
+                             uint8_t *read_buffer, size_t read_len,
+                             BusIO_AsyncCallback callback = nullptr,
+                             void *context = nullptr);
+  /*! @brief  Whether an async transfer is still running
+      @return True until its callback has run */
+  bool busy(void) { return _async_busy; }
+  bool wait(void);
+
   /*!   @brief  How many bytes we can read in a transaction
    *    @return The size of the Wire receive/transmit buffer */
   size_t maxBufferSize() { return _maxBufferSize; }
@@ -31,6 +55,25 @@ private:
   bool _begun;
   size_t _maxBufferSize;
   bool _read(uint8_t *buffer, size_t len, bool stop);
+
+  volatile bool _async_busy = false;
+  volatile bool _async_error = false;
+#ifdef BUSIO_HAS_ASYNC_I2C
+  static void asyncIsr1(void);
+  static void asyncIsr3(void);
+  static void asyncIsr4(void);
+  void asyncService(void);
+  void asyncDone(void);
+  IMXRT_LPI2C_t *_async_port = nullptr;
+  // START + address, the write bytes, START + address, RECEIVE, STOP
+  uint16_t _async_cmds[I2CDEVICE_ASYNC_MAX + 4];
+  uint8_t _async_ncmds, _async_next;
+  uint8_t *_async_read_buffer;
+  size_t _async_read_len;
+  volatile size_t _async_received;
+  BusIO_AsyncCallback _async_callback;
+  void *_async_context;
+#endif
 };
 
 #endif // Adafruit_I2CDevice_h
@@ -316,6 +316,7 @@ void Adafruit_SPIDevice::setChipSelect(int value) {
  *            SPI) with asserting the CS pin
  */
 void Adafruit_SPIDevice::beginTransactionWithAssertingCS() {
+  wait(); // an async transfer still has the bus and CS
   beginTransaction();
   setChipSelect(LOW);
 }
@@ -506,3 +507,90 @@ bool Adafruit_SPIDevice::write_and_read(uint8_t *buffer, size_t len) {
 
   return true;
 }
+
+/*!
+ *    @brief  write_then_read() without waiting for it. On the Teensy the whole
+ * transfer goes out by DMA and the call returns right away, CS is released and
+ * the read bytes are copied to read_buffer from the DMA interrupt, then
+ * callback runs there. Poll busy() or wait() for it instead, if you like.
+ * Elsewhere it is a blocking write_then_read() that runs the callback before
+ * returning. Until it is done nothing else may use the bus: blocking calls on
+ * this device wait for it, but other devices on the same bus don't know about
+ * it
+ *    @param  write_buffer Pointer to buffer of data to write from, copied
+ * before this returns
+ *    @param  write_len Number of bytes from buffer to write.
+ *    @param  read_buffer Pointer to buffer of data to read into, has to stay
+ * around until the transfer is done
+ *    @param  read_len Number of bytes from buffer to read.
+ *    @param  callback Called when the read bytes are in read_buffer, can be
+ * nullptr
+ *    @param  context Passed to callback
+ *    @param  sendvalue The 8-bits of data to write when doing the data read,
+ * defaults to 0xFF
+ *    @return False if write_len + read_len is over SPIDEVICE_ASYNC_MAX, or a
+ * DMA transfer couldn't be started (nothing was sent then)
+ */
+bool Adafruit_SPIDevice::write_then_read_async(
+    const uint8_t *write_buffer, size_t write_len, uint8_t *read_buffer,
+    size_t read_len, BusIO_AsyncCallback callback, void *context,
+    uint8_t sendvalue) {
+  if (write_len + read_len > SPIDEVICE_ASYNC_MAX)
+    return false;
+
+#ifdef BUSIO_HAS_ASYNC_SPI
+  if (_spi) {
+    wait();
+    memcpy(_async_tx, write_buffer, write_len);
+    memset(_async_tx + write_len, sendvalue, read_len);
+    _async_write_len = write_len;
+    _async_read_len = read_len;
+    _async_read_buffer = read_buffer;
+    _async_callback = callback;
+    _async_context = context;
+    _async_event.setContext(this);
+    _async_event.attachImmediate(&Adafruit_SPIDevice::asyncDone);
+
+    beginTransactionWithAssertingCS();
+    _async_busy = true;
+    if (!_spi->transfer(_async_tx, _async_rx, write_len + read_len,
+                        _async_event)) {
+      endTransactionWithDeassertingCS();
+      _async_busy = false;
+      return false;
+    }
+    return true;
+  }
+#endif
+
+  if (!write_then_read(write_buffer, write_len, read_buffer, read_len,
+                       sendvalue))
+    return false;
+  if (callback)
+    callback(context);
+  return true;
+}
+
+/*!
+ *    @brief  Blocks until the async transfer in flight, if any, is done
+ */
+void Adafruit_SPIDevice::wait(void) {
+  while (_async_busy)
+    yield();
+}
+
+#ifdef BUSIO_HAS_ASYNC_SPI
+/*!
+ *    @brief  DMA completion of write_then_read_async(), in interrupt context
+ *    @param  event The device's EventResponder, its context is the device
+ */
+void Adafruit_SPIDevice::asyncDone(EventResponderRef event) {
+  Adafruit_SPIDevice *dev = (Adafruit_SPIDevice *)event.getContext();
+  dev->endTransactionWithDeassertingCS();
+  memcpy(dev->_async_read_buffer, dev->_async_rx + dev->_async_write_len,
+         dev->_async_read_len);
+  dev->_async_busy = false;
+  if (dev->_async_callback)
+    dev->_async_callback(dev->_async_context);
+}
+#endif
@@ -8,6 +8,10 @@
 // HW SPI available
 #include <SPI.h>
 #define BUSIO_HAS_HW_SPI
+#ifdef SPI_HAS_TRANSFER_ASYNC // Teensy 3.x/4.x, DMA transfers
+#include <EventResponder.h>
+#define BUSIO_HAS_ASYNC_SPI
+#endif
 #else
 // SW SPI ONLY
 enum { SPI_MODE0, SPI_MODE1, SPI_MODE2, _SPI_MODE4 };
@@ -85,6 +89,17 @@ typedef uint32_t BusIO_PortMask;
 #undef BUSIO_USE_FAST_PINIO
 #endif
 
+#ifndef BUSIO_ASYNC_CALLBACK
+#define BUSIO_ASYNC_CALLBACK
+/**! Called when an async transfer is done, from the DMA interrupt on the
+ * Teensy. Gets the context the transfer was started with **/
+typedef void (*BusIO_AsyncCallback)(void *context);
+#endif
+
+/**! Largest write + read of one async transfer, they go through buffers in the
+ * device. Register bursts, not FIFO drains **/
+#define SPIDEVICE_ASYNC_MAX 32
+
 /**! The class which defines how we will talk to this device over SPI **/
 class Adafruit_SPIDevice {
 public:
@@ -112,6 +127,15 @@ public:
                        uint8_t sendvalue = 0xFF);
   bool write_and_read(uint8_t *buffer, size_t len);
 
+  bool write_then_read_async(const uint8_t *write_buffer, size_t write_len,
+                             uint8_t *read_buffer, size_t read_len,
+                             BusIO_AsyncCallback callback = nullptr,
+                             void *context = nullptr, uint8_t sendvalue = 0xFF);
+  /*! @brief  Whether an async transfer is still running
+      @return True until its callback has run */
+  bool busy(void) { return _async_busy; }
+  void wait(void);
+
   uint8_t transfer(uint8_t send);
   void transfer(uint8_t *buffer, size_t len);
   void beginTransaction(void);
@@ -138,6 +162,19 @@ private:
   BusIO_PortMask mosiPinMask, misoPinMask, clkPinMask, csPinMask;
 #endif
   bool _begun;
+
+  volatile bool _async_busy = false;
+#ifdef BUSIO_HAS_ASYNC_SPI
+  static void asyncDone(EventResponderRef event);
+  EventResponder _async_event;
+  // the DMA clears the cache over rx, keep it on cache lines of its own
+  alignas(32) uint8_t _async_rx[SPIDEVICE_ASYNC_MAX];
+  uint8_t _async_tx[SPIDEVICE_ASYNC_MAX];
+  size_t _async_write_len, _async_read_len;
+  uint8_t *_async_read_buffer;
+  BusIO_AsyncCallback _async_callback;
+  void *_async_context;
+#endif
 };
 
 #endif // Adafruit_SPIDevice_h
@@ -236,8 +236,45 @@ bool Adafruit_LSM6DS::getRaw(void) {
       i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, LSM6DS_OUT_TEMP_L, 14);
 
   uint8_t buffer[14];
-  data_reg.read(buffer, 14);
+  if (!data_reg.read(buffer, 14))
+    return false;
+
+  parseRaw(buffer);
+  return true;
+}
+
+/*!
+    @brief  Starts the read of getRaw() in the background (the I2C interrupt
+            or SPI DMA on the Teensy, see Adafruit_BusIO_Register::read_async)
+            so other work can go on meanwhile. finishRaw() gets the result.
+            Nothing else may use the bus until then.
+    @return True if the read was started
+*/
+bool Adafruit_LSM6DS::startRaw(void) {
+  Adafruit_BusIO_Register data_reg = Adafruit_BusIO_Register(
+      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, LSM6DS_OUT_TEMP_L, 14);
+  _raw_started = data_reg.read_async(_raw_buffer, 14);
+  return _raw_started;
+}
+
+/*!
+    @brief  Waits for the read startRaw() started, and sets the raw fields
+            (and temperature) like getRaw()
+    @return False if no read was started, or it failed
+*/
+bool Adafruit_LSM6DS::finishRaw(void) {
+  if (!_raw_started)
+    return false;
+  _raw_started = false;
+  if (spi_dev)
+    spi_dev->wait();
+  if (i2c_dev && !i2c_dev->wait())
+    return false;
+  parseRaw(_raw_buffer);
+  return true;
+}
 
+void Adafruit_LSM6DS::parseRaw(const uint8_t *buffer) {
   rawTemp = buffer[1] << 8 | buffer[0];
   temperature = (rawTemp / temperature_sensitivity) + 25.0;
 
@@ -248,8 +285,6 @@ bool Adafruit_LSM6DS::getRaw(void) {
   rawAccX = buffer[9] << 8 | buffer[8];
   rawAccY = buffer[11] << 8 | buffer[10];
   rawAccZ = buffer[13] << 8 | buffer[12];
-
-  return true;
 }
 /**************************************************************************/
 /*!
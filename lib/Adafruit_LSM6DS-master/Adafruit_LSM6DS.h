@@ -151,6 +151,8 @@ public:
                  uint32_t frequency = 1000000);
 
   bool getRaw(void);
+  bool startRaw(void);
+  bool finishRaw(void);
 
   bool getEvent(sensors_event_t *accel, sensors_event_t *gyro,
                 sensors_event_t *temp);
@@ -246,6 +248,10 @@ private:
   friend class Adafruit_LSM6DS_Gyro; ///< Gives access to private members to
                                      ///< Gyro data object
 
+  void parseRaw(const uint8_t *buffer);
+  uint8_t _raw_buffer[14];   // startRaw() reads into this
+  bool _raw_started = false; // startRaw() ran since the last finishRaw()
+
   void fillTempEvent(sensors_event_t *temp, uint32_t timestamp);
   void fillAccelEvent(sensors_event_t *accel, uint32_t timestamp);
   void fillGyroEvent(sensors_event_t *gyro, uint32_t timestamp);
@@ -89,3 +89,197 @@ void Adafruit_LSM6DSOX::enableI2CMasterPullups(bool enable_pullups) {
   i2c_master_pu_en.write(enable_pullups);
   master_cfg_enable_bit.write(false);
 }
+
+/**************************************************************************/
+/*!
+    @brief Streams accel and gyro through the FIFO in continuous mode: both
+    are batched every slot at rate (which also becomes their ODR), with a
+    timestamp every 8 slots. When the FIFO is full the oldest words are
+    overwritten.
+    @param rate The data rate of both sensors and of the FIFO slots
+    @param watermark FIFO level in words that sets the watermark flag and
+    interrupt. A slot is 2 words, plus a timestamp every 8 slots
+    @returns False if rate can't be batched or the registers couldn't be written
+*/
+/**************************************************************************/
+bool Adafruit_LSM6DSOX::enableFifo(lsm6ds_data_rate_t rate,
+                                   uint16_t watermark) {
+  if (rate == LSM6DS_RATE_SHUTDOWN || rate > LSM6DS_RATE_6_66K_HZ)
+    return false;
+
+  setAccelDataRate(rate);
+  setGyroDataRate(rate);
+
+  // timestamp resolution is 1 / (40 kHz * (1 + 0.0015 * FREQ_FINE)). The ODR
+  // comes from the same oscillator: 6667 Hz / 2^(10 - rate), or 6 ticks at
+  // 6667 Hz, so a slot is always a whole number of ticks
+  Adafruit_BusIO_Register freq_fine = Adafruit_BusIO_Register(
+      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, LSM6DSOX_INTERNAL_FREQ_FINE);
+  int8_t fine = (int8_t)freq_fine.read();
+  _ts_period_ns = 25000.0f / (1.0f + 0.0015f * fine);
+  _slot_ticks = 6UL << (LSM6DS_RATE_6_66K_HZ - rate);
+
+  Adafruit_BusIO_Register ctrl10 = Adafruit_BusIO_Register(
+      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, LSM6DSOX_CTRL10_C);
+  Adafruit_BusIO_RegisterBits timestamp_en =
+      Adafruit_BusIO_RegisterBits(&ctrl10, 1, 5);
+  if (!timestamp_en.write(true))
+    return false;
+
+  uint8_t fifo_ctrl[4] = {
+      (uint8_t)(watermark & 0xFF),      // WTM[7:0]
+      (uint8_t)((watermark >> 8) & 1),  // WTM8
+      (uint8_t)(rate << 4 | rate),      // BDR_GY, BDR_XL
+      (uint8_t)(0b10 << 6 | 0b110)};    // DEC_TS_BATCH every 8, continuous
+  Adafruit_BusIO_Register fifo = Adafruit_BusIO_Register(
+      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, LSM6DSOX_FIFO_CTRL1, 4);
+
+  _slot_cnt = 0;
+  _slot_ts_valid = false;
+  _slot_have = 0;
+  _fifo_overruns = 0;
+  return fifo.write(fifo_ctrl, 4);
+}
+
+/**************************************************************************/
+/*!
+    @brief Puts the FIFO back in bypass mode, which also empties it
+*/
+/**************************************************************************/
+void Adafruit_LSM6DSOX::disableFifo(void) {
+  Adafruit_BusIO_Register fifo_ctrl4 = Adafruit_BusIO_Register(
+      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, LSM6DSOX_FIFO_CTRL4);
+  fifo_ctrl4.write(0);
+  _slot_ts_valid = false;
+  _slot_have = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Checks that the FIFO is still in continuous mode, a chip that
+    browned out comes back in bypass
+    @returns True if the FIFO is streaming
+*/
+/**************************************************************************/
+bool Adafruit_LSM6DSOX::fifoEnabled(void) {
+  Adafruit_BusIO_Register fifo_ctrl4 = Adafruit_BusIO_Register(
+      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, LSM6DSOX_FIFO_CTRL4);
+  return (fifo_ctrl4.read() & 0x07) == 0b110;
+}
+
+/**************************************************************************/
+/*!
+    @brief Routes the FIFO watermark flag to INT1
+    @param watermark true to raise INT1 while the FIFO is at or above the
+    watermark
+*/
+/**************************************************************************/
+void Adafruit_LSM6DSOX::configInt1Fifo(bool watermark) {
+  Adafruit_BusIO_Register int1_ctrl = Adafruit_BusIO_Register(
+      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, LSM6DSOX_INT1_CTRL);
+  Adafruit_BusIO_RegisterBits fifo_th =
+      Adafruit_BusIO_RegisterBits(&int1_ctrl, 1, 3);
+  fifo_th.write(watermark);
+}
+
+/**************************************************************************/
+/*!
+    @brief Drains the FIFO, up to max_samples slots. Words are read in bursts
+    of LSM6DSOX_FIFO_BURST (the address wraps from the last FIFO data
+    register back to the tag, so a burst is one read). A slot split across two
+    calls is finished on the next one. Slots are only returned once a
+    timestamp word has been seen, after enableFifo() or an overrun
+    @param samples Filled with the decoded slots, oldest first
+    @param max_samples Size of samples
+    @returns The number of slots decoded, or -1 on a bus error
+*/
+/**************************************************************************/
+int Adafruit_LSM6DSOX::readFifo(lsm6dsox_fifo_sample_t *samples,
+                                size_t max_samples) {
+  Adafruit_BusIO_Register fifo_status = Adafruit_BusIO_Register(
+      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, LSM6DSOX_FIFO_STATUS1, 2);
+  uint8_t status[2];
+  if (!fifo_status.read(status, 2))
+    return -1;
+
+  uint16_t words = (status[1] & 0x03) << 8 | status[0];
+  if (status[1] & 0x40) {
+    // FIFO_OVR_IA: words were dropped, so slots can't be counted from the last
+    // timestamp anymore
+    _fifo_overruns++;
+    _slot_ts_valid = false;
+    _slot_have = 0;
+  }
+
+  // a slot is at least 2 words, don't read more than samples can take
+  if (words > 2 * max_samples)
+    words = 2 * max_samples;
+
+  uint8_t buffer[LSM6DSOX_FIFO_BURST * LSM6DSOX_FIFO_WORD_SIZE];
+  size_t count = 0;
+  while (words) {
+    uint16_t n = words < LSM6DSOX_FIFO_BURST ? words : LSM6DSOX_FIFO_BURST;
+    uint8_t reg = LSM6DSOX_FIFO_DATA_OUT_TAG;
+    size_t len = n * LSM6DSOX_FIFO_WORD_SIZE;
+    bool ok;
+    if (i2c_dev) {
+      ok = i2c_dev->write_then_read(&reg, 1, buffer, len);
+    } else {
+      reg |= 0x80;
+      ok = spi_dev->write_then_read(&reg, 1, buffer, len);
+    }
+    if (!ok) {
+      _slot_ts_valid = false;
+      _slot_have = 0;
+      return -1;
+    }
+    for (uint16_t i = 0; i < n; i++)
+      _decodeFifoWord(buffer + i * LSM6DSOX_FIFO_WORD_SIZE, samples, count);
+    words -= n;
+  }
+  return count;
+}
+
+// One FIFO word. TAG_CNT changes on every new slot, slots between two
+// timestamp words get their time by counting
+void Adafruit_LSM6DSOX::_decodeFifoWord(const uint8_t *word,
+                                        lsm6dsox_fifo_sample_t *samples,
+                                        size_t &count) {
+  uint8_t tag = word[0] >> 3;
+  uint8_t cnt = (word[0] >> 1) & 0x03;
+  const uint8_t *d = word + 1;
+
+  if (cnt != _slot_cnt) {
+    _slot_ts += ((cnt - _slot_cnt) & 0x03) * _slot_ticks;
+    _slot_cnt = cnt;
+    _slot_have = 0; // half a slot left over from an overrun is dropped
+  }
+
+  switch (tag) {
+  case LSM6DSOX_TAG_TIMESTAMP:
+    _slot_ts = (uint32_t)d[3] << 24 | (uint32_t)d[2] << 16 |
+               (uint32_t)d[1] << 8 | d[0];
+    _slot_ts_valid = true;
+    return;
+  case LSM6DSOX_TAG_GYRO:
+    for (int i = 0; i < 3; i++)
+      _slot_sample.gyro[i] = d[2 * i + 1] << 8 | d[2 * i];
+    _slot_have |= 0x01;
+    break;
+  case LSM6DSOX_TAG_ACCEL:
+    for (int i = 0; i < 3; i++)
+      _slot_sample.acc[i] = d[2 * i + 1] << 8 | d[2 * i];
+    _slot_have |= 0x02;
+    break;
+  default:
+    return; // nothing else is batched
+  }
+
+  if (_slot_have == 0x03) {
+    _slot_have |= 0x04; // done, a repeated word won't give the slot twice
+    if (_slot_ts_valid) {
+      _slot_sample.timestamp = _slot_ts;
+      samples[count++] = _slot_sample;
+    }
+  }
+}
@@ -35,6 +35,31 @@
 ///< I2C Master config; access must be enabled with  bit SHUB_REG_ACCESS
 ///< is set to '1' in FUNC_CFG_ACCESS (01h).
 
+#define LSM6DSOX_FIFO_CTRL1 0x07   ///< FIFO watermark, low 8 bits
+#define LSM6DSOX_FIFO_CTRL2 0x08   ///< FIFO watermark bit 8
+#define LSM6DSOX_FIFO_CTRL3 0x09   ///< FIFO batch data rates, gyro and accel
+#define LSM6DSOX_FIFO_CTRL4 0x0A   ///< FIFO mode and timestamp batching
+#define LSM6DSOX_CTRL10_C 0x19     ///< Timestamp enable
+#define LSM6DSOX_FIFO_STATUS1 0x3A ///< FIFO level low 8 bits, STATUS2 follows
+#define LSM6DSOX_INTERNAL_FREQ_FINE                                            \
+  0x63 ///< Oscillator trim, sets the actual ODR and timestamp resolution
+#define LSM6DSOX_FIFO_DATA_OUT_TAG 0x78 ///< First of the 7 FIFO word registers
+
+#define LSM6DSOX_FIFO_DEPTH 512    ///< FIFO size in words
+#define LSM6DSOX_FIFO_WORD_SIZE 7  ///< tag byte + 6 data bytes
+#define LSM6DSOX_FIFO_BURST 64     ///< words read per bus transaction
+
+#define LSM6DSOX_TAG_GYRO 0x01      ///< FIFO tag, gyro sample
+#define LSM6DSOX_TAG_ACCEL 0x02     ///< FIFO tag, accel sample
+#define LSM6DSOX_TAG_TIMESTAMP 0x04 ///< FIFO tag, timestamp
+
+/** One accelerometer + gyro time slot out of the FIFO */
+typedef struct {
+  uint32_t timestamp; ///< sensor time of the sample, in timestampPeriodNs() ticks
+  int16_t acc[3];     ///< raw accelerometer X, Y, Z
+  int16_t gyro[3];    ///< raw gyro X, Y, Z
+} lsm6dsox_fifo_sample_t;
+
 /*!
  *    @brief  Class that stores state and functions for interacting with
  *            the LSM6DSOX I2C Digital Potentiometer
@@ -46,8 +71,34 @@ public:
   void enableI2CMasterPullups(bool enable_pullups);
   void disableSPIMasterPullups(bool disable_pullups);
 
+  bool enableFifo(lsm6ds_data_rate_t rate, uint16_t watermark);
+  void disableFifo(void);
+  bool fifoEnabled(void);
+  void configInt1Fifo(bool watermark);
+  int readFifo(lsm6dsox_fifo_sample_t *samples, size_t max_samples);
+
+  /** @brief Length of one timestamp tick, nominally 25 us
+      @returns The tick in ns, corrected for this chip's oscillator */
+  uint32_t timestampPeriodNs(void) { return _ts_period_ns; }
+  /** @brief How often the FIFO filled up and lost samples
+      @returns Overruns since enableFifo() */
+  uint32_t getFifoOverruns(void) { return _fifo_overruns; }
+
 private:
   bool _init(int32_t sensor_id);
+  void _decodeFifoWord(const uint8_t *word, lsm6dsox_fifo_sample_t *samples,
+                       size_t &count);
+
+  uint32_t _ts_period_ns = 25000; ///< timestamp tick, see timestampPeriodNs()
+  uint32_t _slot_ticks = 0;       ///< FIFO time slot length in timestamp ticks
+  uint32_t _fifo_overruns = 0;    ///< see getFifoOverruns()
+
+  // FIFO decoder state, carried across reads since a slot can be split by one
+  uint8_t _slot_cnt = 0;     ///< TAG_CNT of the slot being decoded
+  uint32_t _slot_ts = 0;     ///< timestamp of that slot
+  bool _slot_ts_valid = false; ///< false until a timestamp word is seen
+  uint8_t _slot_have = 0;    ///< which of accel/gyro the slot has so far
+  lsm6dsox_fifo_sample_t _slot_sample; ///< the slot's sample so far
 };
 
 #endif
@@ -57,6 +57,7 @@ static int8_t cal_crc(uint8_t seed, uint8_t data);
 /**************************************************************************/
 Adafruit_BMP3XX::Adafruit_BMP3XX(void) {
   _meas_end = 0;
+  the_sensor.fifo = NULL;
   _filterEnabled = _tempOSEnabled = _presOSEnabled = false;
 }
 
@@ -386,6 +387,139 @@ bool Adafruit_BMP3XX::performReading(void) {
   return true;
 }
 
+/**************************************************************************/
+/*!
+    @brief Reads the pressure and temperature ADC words, without compensating
+   them. Same burst as performReading(), but none of the floating point math.
+
+    Assigns the internal Adafruit_BMP3XX#raw_temperature &
+   Adafruit_BMP3XX#raw_pressure member variables
+
+    @return True on success, False on failure
+*/
+/**************************************************************************/
+bool Adafruit_BMP3XX::performRawReading(void) {
+  g_i2c_dev = i2c_dev;
+  g_spi_dev = spi_dev;
+
+  uint8_t reg_data[BMP3_LEN_P_T_DATA];
+  if (bmp3_get_regs(BMP3_REG_DATA, reg_data, BMP3_LEN_P_T_DATA, &the_sensor) !=
+      BMP3_OK)
+    return false;
+
+  raw_pressure = (uint32_t)reg_data[2] << 16 | (uint32_t)reg_data[1] << 8 |
+                 reg_data[0];
+  raw_temperature = (uint32_t)reg_data[5] << 16 | (uint32_t)reg_data[4] << 8 |
+                    reg_data[3];
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Starts the burst of performReading() in the background (DMA on the
+   Teensy, see Adafruit_SPIDevice::write_then_read_async, or the LPI2C
+   interrupt over I2C), finishReading() or finishRawReading() get the result.
+   Nothing else may use the bus until then.
+
+    @return True if the burst was started
+*/
+/**************************************************************************/
+bool Adafruit_BMP3XX::startReading(void) {
+  _reading_started = false;
+  if (spi_dev) {
+    uint8_t reg = BMP3_REG_DATA | 0x80;
+    _reading_started = spi_dev->write_then_read_async(
+        &reg, 1, _reading, BMP3_LEN_P_T_DATA + 1);
+  } else if (i2c_dev) {
+    uint8_t reg = BMP3_REG_DATA;
+    _reading_started = i2c_dev->write_then_read_async(
+        &reg, 1, _reading + 1, BMP3_LEN_P_T_DATA);
+  }
+  return _reading_started;
+}
+
+/**************************************************************************/
+/*!
+    @brief Waits for the burst startReading() started
+    @return False if there was none, or it failed
+*/
+/**************************************************************************/
+bool Adafruit_BMP3XX::waitReading(void) {
+  if (!_reading_started)
+    return false;
+  _reading_started = false;
+  if (spi_dev)
+    spi_dev->wait();
+  if (i2c_dev)
+    return i2c_dev->wait();
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Waits for the burst startReading() started and compensates it,
+   like performReading()
+
+    Assigns the internal Adafruit_BMP3XX#temperature & Adafruit_BMP3XX#pressure
+   member variables
+
+    @return True on success, False on failure
+*/
+/**************************************************************************/
+bool Adafruit_BMP3XX::finishReading(void) {
+  if (!waitReading())
+    return false;
+
+  struct bmp3_data data;
+  if (bmp3_compensate_sensor_data(sensor_comp, _reading + 1, &data,
+                                  &the_sensor) != BMP3_OK)
+    return false;
+
+  temperature = data.temperature;
+  pressure = data.pressure;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Waits for the burst startReading() started, like
+   performRawReading()
+
+    Assigns the internal Adafruit_BMP3XX#raw_temperature &
+   Adafruit_BMP3XX#raw_pressure member variables
+
+    @return True on success, False on failure
+*/
+/**************************************************************************/
+bool Adafruit_BMP3XX::finishRawReading(void) {
+  if (!waitReading())
+    return false;
+
+  const uint8_t *reg_data = _reading + 1;
+  raw_pressure = (uint32_t)reg_data[2] << 16 | (uint32_t)reg_data[1] << 8 |
+                 reg_data[0];
+  raw_temperature = (uint32_t)reg_data[5] << 16 | (uint32_t)reg_data[4] << 8 |
+                    reg_data[3];
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Reads the chip's calibration (trimming) coefficients as they are
+   stored in its NVM, what the raw words of performRawReading() are
+   compensated with
+    @param nvm Filled with BMP3_LEN_CALIB_DATA bytes, from register 0x31 on
+    @return True on success, False on failure
+*/
+/**************************************************************************/
+bool Adafruit_BMP3XX::readCalibration(uint8_t *nvm) {
+  g_i2c_dev = i2c_dev;
+  g_spi_dev = spi_dev;
+
+  return bmp3_get_regs(BMP3_REG_CALIB_DATA, nvm, BMP3_LEN_CALIB_DATA,
+                       &the_sensor) == BMP3_OK;
+}
+
 /**************************************************************************/
 /*!
     @brief  Setter for Temperature oversampling
@@ -481,6 +615,158 @@ bool Adafruit_BMP3XX::setOutputDataRate(uint8_t odr) {
   return true;
 }
 
+/**************************************************************************/
+/*!
+    @brief  Routes data ready to the INT pin (push-pull, active high, not
+   latched) so a pin change interrupt can tell us when a new sample exists
+    @return True on success, False on failure
+
+*/
+/**************************************************************************/
+bool Adafruit_BMP3XX::enableDataReadyInterrupt(void) {
+  g_i2c_dev = i2c_dev;
+  g_spi_dev = spi_dev;
+
+  the_sensor.settings.int_settings.output_mode = BMP3_INT_PIN_PUSH_PULL;
+  the_sensor.settings.int_settings.level = BMP3_INT_PIN_ACTIVE_HIGH;
+  the_sensor.settings.int_settings.latch = BMP3_INT_PIN_NON_LATCH;
+  the_sensor.settings.int_settings.drdy_en = BMP3_ENABLE;
+
+  return bmp3_set_sensor_settings(BMP3_SEL_OUTPUT_MODE | BMP3_SEL_LEVEL |
+                                      BMP3_SEL_LATCH | BMP3_SEL_DRDY_EN,
+                                  &the_sensor) == BMP3_OK;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Turns on the FIFO: a pressure and temperature frame per sample at
+   the current ODR, a sensor time frame after the last one on every read, and
+   the oldest frames dropped when it is full. The watermark interrupt goes to
+   the INT pin (push-pull, active high after reset). Flushes the FIFO
+    @param watermark_frames Frames that set the watermark interrupt, 1 to 73
+    @return True on success, False on failure
+*/
+/**************************************************************************/
+bool Adafruit_BMP3XX::enableFifo(uint8_t watermark_frames) {
+  g_i2c_dev = i2c_dev;
+  g_spi_dev = spi_dev;
+
+  the_sensor.fifo = &_fifo;
+  _fifo.data.buffer = _fifo_buffer;
+  _fifo.data.req_frames = watermark_frames;
+  _fifo.settings.mode = BMP3_ENABLE;
+  _fifo.settings.stop_on_full_en = BMP3_DISABLE;
+  _fifo.settings.time_en = BMP3_ENABLE;
+  _fifo.settings.press_en = BMP3_ENABLE;
+  _fifo.settings.temp_en = BMP3_ENABLE;
+  _fifo.settings.down_sampling = BMP3_FIFO_NO_SUBSAMPLING;
+  _fifo.settings.filter_en = BMP3_ENABLE; // IIR filtered, like the data registers
+  _fifo.settings.fwtm_en = BMP3_ENABLE;
+  _fifo.settings.ffull_en = BMP3_DISABLE;
+  _fifo_overflows = 0;
+  _fifo_time_valid = false;
+
+  uint16_t settings_sel =
+      BMP3_SEL_FIFO_MODE | BMP3_SEL_FIFO_STOP_ON_FULL_EN |
+      BMP3_SEL_FIFO_TIME_EN | BMP3_SEL_FIFO_PRESS_EN | BMP3_SEL_FIFO_TEMP_EN |
+      BMP3_SEL_FIFO_DOWN_SAMPLING | BMP3_SEL_FIFO_FILTER_EN |
+      BMP3_SEL_FIFO_FWTM_EN | BMP3_SEL_FIFO_FULL_EN;
+
+  return bmp3_set_fifo_settings(settings_sel, &the_sensor) == BMP3_OK &&
+         bmp3_set_fifo_watermark(&the_sensor) == BMP3_OK &&
+         bmp3_fifo_flush(&the_sensor) == BMP3_OK;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Turns the FIFO off, performReading() works either way
+    @return True on success, False on failure
+*/
+/**************************************************************************/
+bool Adafruit_BMP3XX::disableFifo(void) {
+  g_i2c_dev = i2c_dev;
+  g_spi_dev = spi_dev;
+
+  if (!the_sensor.fifo)
+    return true;
+  _fifo.settings.mode = BMP3_DISABLE;
+  return bmp3_set_fifo_settings(BMP3_SEL_FIFO_MODE, &the_sensor) == BMP3_OK;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads the FIFO mode back from the chip
+    @return True if the FIFO is on, false if it is off (a chip that was reset)
+   or the read failed
+*/
+/**************************************************************************/
+bool Adafruit_BMP3XX::fifoEnabled(void) {
+  g_i2c_dev = i2c_dev;
+  g_spi_dev = spi_dev;
+
+  uint8_t config;
+  return bmp3_get_regs(BMP3_REG_FIFO_CONFIG_1, &config, 1, &the_sensor) ==
+             BMP3_OK &&
+         (config & BMP3_FIFO_MODE_MSK);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Drains the FIFO in one burst and compensates every frame, oldest
+   first. Frames past max_frames stay in the buffer and are lost, so make it
+   big enough for a full FIFO (73 frames).
+
+   A frame that arrives between reading the FIFO length and the data is cut
+   off at the end of the burst. It isn't parsed, the chip sends it again on
+   the next read.
+    @param frames Filled with up to max_frames compensated samples
+    @param max_frames Size of frames
+    @return The number of frames read, or -1 on a bus error
+*/
+/**************************************************************************/
+int Adafruit_BMP3XX::readFifo(struct bmp3_data *frames, uint8_t max_frames) {
+  g_i2c_dev = i2c_dev;
+  g_spi_dev = spi_dev;
+  _fifo_time_valid = false;
+
+  if (!the_sensor.fifo || bmp3_get_fifo_data(&the_sensor) != BMP3_OK)
+    return -1;
+
+  // bmp3_get_fifo_data() read 4 bytes more than the FIFO length, for the
+  // sensor time frame the chip appends once the FIFO has been read out
+  uint16_t len = _fifo.data.byte_count - 4;
+  if (len > BMP3XX_FIFO_SIZE - BMP3_LEN_P_AND_T_HEADER_DATA)
+    _fifo_overflows++;
+  if (_fifo_buffer[len] == BMP3_FIFO_TIME_FRAME) {
+    _fifo_time = (uint32_t)_fifo_buffer[len + 1] |
+                 (uint32_t)_fifo_buffer[len + 2] << 8 |
+                 (uint32_t)_fifo_buffer[len + 3] << 16;
+    _fifo_time_valid = true;
+  }
+
+  _fifo.data.byte_count = len;
+  _fifo.data.req_frames = max_frames;
+  if (bmp3_extract_fifo_data(frames, &the_sensor) != BMP3_OK)
+    return -1;
+  return _fifo.data.parsed_frames;
+}
+
+/**************************************************************************/
+/*!
+    @brief  The sensor time frame the last readFifo() found after the data
+   frames, the chip's 24 bit 25.6 kHz counter at the time of the read
+    @param ticks Set to the sensor time, if there was one
+    @return False if the read had no sensor time frame (a frame was cut off,
+   see readFifo())
+*/
+/**************************************************************************/
+bool Adafruit_BMP3XX::fifoSensorTime(uint32_t &ticks) {
+  if (!_fifo_time_valid)
+    return false;
+  ticks = _fifo_time;
+  return true;
+}
+
 /**************************************************************************/
 /*!
     @brief  Reads 8 bit values over I2C
@@ -520,7 +806,9 @@ int8_t i2c_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len,
 /**************************************************************************/
 static int8_t spi_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len,
                        void *intf_ptr) {
-  g_spi_dev->write_then_read(&reg_addr, 1, reg_data, len, 0xFF);
+  if (!g_spi_dev->write_then_read(&reg_addr, 1, reg_data, len, 0xFF))
+    return 1;
+
   return 0;
 }
 
@@ -531,7 +819,8 @@ static int8_t spi_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len,
 /**************************************************************************/
 static int8_t spi_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len,
                         void *intf_ptr) {
-  g_spi_dev->write((uint8_t *)reg_data, len, &reg_addr, 1);
+  if (!g_spi_dev->write((uint8_t *)reg_data, len, &reg_addr, 1))
+    return 1;
 
   return 0;
 }
@@ -33,6 +33,7 @@
 #define BMP3XX_DEFAULT_ADDRESS (0x77) ///< The default I2C address
 /*=========================================================================*/
 #define BMP3XX_DEFAULT_SPIFREQ (1000000) ///< The default SPI Clock speed
+#define BMP3XX_FIFO_SIZE (512)           ///< FIFO bytes
 
 /** Adafruit_BMP3XX Class for both I2C and SPI usage.
  *  Wraps the Bosch library for Arduino usage
@@ -57,14 +58,34 @@ public:
   bool setPressureOversampling(uint8_t os);
   bool setIIRFilterCoeff(uint8_t fs);
   bool setOutputDataRate(uint8_t odr);
+  bool enableDataReadyInterrupt(void);
+
+  bool enableFifo(uint8_t watermark_frames);
+  bool disableFifo(void);
+  bool fifoEnabled(void);
+  int readFifo(struct bmp3_data *frames, uint8_t max_frames);
+  bool fifoSensorTime(uint32_t &ticks);
+  /// Reads that found the FIFO full since enableFifo(), frames may have been lost
+  uint32_t getFifoOverflows(void) { return _fifo_overflows; }
 
   /// Perform a reading in blocking mode
   bool performReading(void);
+  /// Read the ADC words only, compensate them later with the calibration
+  bool performRawReading(void);
+  bool readCalibration(uint8_t *nvm);
+  /// performReading() in two halves, the burst runs in the background between
+  bool startReading(void);
+  bool finishReading(void);
+  bool finishRawReading(void);
 
   /// Temperature (Celsius) assigned after calling performReading()
   double temperature;
   /// Pressure (Pascals) assigned after calling performReading()
   double pressure;
+  /// 24 bit temperature ADC word assigned after calling performRawReading()
+  uint32_t raw_temperature;
+  /// 24 bit pressure ADC word assigned after calling performRawReading()
+  uint32_t raw_pressure;
 
 private:
   Adafruit_I2CDevice *i2c_dev = NULL; ///< Pointer to I2C bus interface
@@ -81,6 +102,17 @@ private:
   uint8_t spixfer(uint8_t x);
   uint8_t sensor_comp = 0;
   struct bmp3_dev the_sensor;
+
+  struct bmp3_fifo _fifo;
+  uint8_t _fifo_buffer[BMP3XX_FIFO_SIZE + 4]; // + the sensor time frame
+  bool _fifo_time_valid = false;
+  uint32_t _fifo_time = 0;
+  uint32_t _fifo_overflows = 0;
+
+  bool waitReading(void);
+  // startReading()'s burst, SPI sends a dummy byte ahead of the data
+  uint8_t _reading[BMP3_LEN_P_T_DATA + 1];
+  bool _reading_started = false;
 };
 
 #endif
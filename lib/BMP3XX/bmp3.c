@@ -1415,6 +1415,34 @@ int8_t bmp3_get_sensor_data(uint8_t sensor_comp, struct bmp3_data *comp_data, st
     return rslt;
 }
 
+/*!
+ * @brief This API compensates pressure and temperature registers read
+ * elsewhere.
+ */
+int8_t bmp3_compensate_sensor_data(uint8_t sensor_comp,
+                                   const uint8_t *reg_data,
+                                   struct bmp3_data *comp_data,
+                                   struct bmp3_dev *dev)
+{
+    int8_t rslt;
+    struct bmp3_uncomp_data uncomp_data = { 0 };
+
+    /* Check for null pointer in the device structure*/
+    rslt = null_ptr_check(dev);
+
+    if ((rslt == BMP3_OK) && (comp_data != NULL) && (reg_data != NULL))
+    {
+        parse_sensor_data(reg_data, &uncomp_data);
+        rslt = compensate_data(sensor_comp, &uncomp_data, comp_data, &dev->calib_data);
+    }
+    else
+    {
+        rslt = BMP3_E_NULL_PTR;
+    }
+
+    return rslt;
+}
+
 /****************** Static Function Definitions *******************************/
 
 /*!
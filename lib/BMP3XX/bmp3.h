@@ -270,6 +270,32 @@ int8_t bmp3_get_op_mode(uint8_t *op_mode, struct bmp3_dev *dev);
  */
 int8_t bmp3_get_sensor_data(uint8_t sensor_comp, struct bmp3_data *data, struct bmp3_dev *dev);
 
+/*!
+ * \ingroup bmp3ApiData
+ * \page bmp3_api_bmp3_compensate_sensor_data bmp3_compensate_sensor_data
+ * \code
+ * int8_t bmp3_compensate_sensor_data(uint8_t sensor_comp, const uint8_t *reg_data, struct bmp3_data *data,
+ *                                    struct bmp3_dev *dev);
+ * \endcode
+ * @details This API does what bmp3_get_sensor_data() does with data that has
+ * already been read, the BMP3_LEN_P_T_DATA bytes from BMP3_REG_DATA on. For
+ * reads the library doesn't make itself (DMA).
+ *
+ * @param[in] sensor_comp : As in bmp3_get_sensor_data().
+ * @param[in] reg_data : The pressure and temperature registers.
+ * @param[out] data : Structure instance of bmp3_data.
+ * @param[in] dev : Structure instance of bmp3_dev.
+ *
+ * @return Result of API execution status
+ * @retval 0  -> Success
+ * @retval >0 -> Warning
+ * @retval <0 -> Error
+ */
+int8_t bmp3_compensate_sensor_data(uint8_t sensor_comp,
+                                   const uint8_t *reg_data,
+                                   struct bmp3_data *data,
+                                   struct bmp3_dev *dev);
+
 /**
  * \ingroup bmp3
  * \defgroup bmp3ApiRegs Registers
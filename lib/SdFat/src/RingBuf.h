@@ -71,6 +71,52 @@ inline void memcpyBuf(void* dst, const void* src, size_t len) {
 template <class F, size_t Size>
 class RingBuf : public Print {
  public:
+  /**
+   * \class Span
+   * \brief Writable region of the RingBuf returned by reserve().
+   *
+   * The region may wrap around the end of the buffer, in that case it is
+   * made of two pieces, first then second. Producers that can write a split
+   * region use operator[] or copy(), producers that need one contiguous
+   * piece use reserveContiguous() instead.
+   */
+  struct Span {
+    /** Start of the first piece, nullptr if nothing was reserved. */
+    uint8_t* first;
+    /** Length of the first piece. */
+    size_t firstLen;
+    /** Start of the second piece, at the start of the buffer. */
+    uint8_t* second;
+    /** Length of the second piece, zero if the span does not wrap. */
+    size_t secondLen;
+    /** \return total length of the span. */
+    size_t size() const { return firstLen + secondLen; }
+    /** \return true if the span is one piece. */
+    bool contiguous() const { return secondLen == 0; }
+    /** \param[in] i offset in the span.  \return byte at offset i. */
+    uint8_t& operator[](size_t i) {
+      return i < firstLen ? first[i] : second[i - firstLen];
+    }
+    /**
+     * Copy data into the span.
+     * \param[in] offset offset in the span.
+     * \param[in] src Location of the data.
+     * \param[in] count number of bytes to copy, offset + count <= size().
+     */
+    void copy(size_t offset, const void* src, size_t count) {
+      const uint8_t* s = reinterpret_cast<const uint8_t*>(src);
+      if (offset < firstLen) {
+        size_t n = count < firstLen - offset ? count : firstLen - offset;
+        memcpyBuf(first + offset, s, n);
+        s += n;
+        count -= n;
+        offset = firstLen;
+      }
+      if (count) {
+        memcpyBuf(second + offset - firstLen, s, count);
+      }
+    }
+  };
   /**
    * RingBuf Constructor.
    */
@@ -287,6 +333,58 @@ class RingBuf : public Print {
     adjustCount(count);
     return count;
   }
+  /**
+   * Reserve space for the producer to write into directly, instead of
+   * building the data somewhere else and copying it in with write().
+   *
+   * Nothing is visible to writeOut() until commit(). Only one reservation
+   * may be open at a time and it must be made by the only producer, the
+   * same rules as write(). A new reserve() replaces an uncommitted one.
+   *
+   * If count is greater than bytesFree, the write error is set and an empty
+   * span is returned.
+   *
+   * \param[in] count number of bytes to reserve.
+   * \return The reserved region, possibly split at the end of the buffer.
+   */
+  Span reserve(size_t count) {
+    if (bytesFree() < count) {
+      setWriteError();
+      return Span{nullptr, 0, nullptr, 0};
+    }
+    size_t n = minSize(Size - m_head, count);
+    return Span{m_buf + m_head, n, m_buf, count - n};
+  }
+  /**
+   * Reserve count contiguous bytes, for producers that need a plain pointer
+   * (packet encoders, DMA).
+   *
+   * Returns nullptr without setting the write error if the free space does
+   * not reach the end of the buffer in one piece. Fall back to a local
+   * buffer and write() in that case, it only happens near the wrap point.
+   * The write error is set if count is greater than bytesFree.
+   *
+   * \param[in] count number of bytes to reserve.
+   * \return Location to write count bytes to, or nullptr.
+   */
+  uint8_t* reserveContiguous(size_t count) {
+    if (bytesFree() < count) {
+      setWriteError();
+      return nullptr;
+    }
+    return Size - m_head < count ? nullptr : m_buf + m_head;
+  }
+  /**
+   * Publish bytes written into the last reservation.
+   *
+   * \param[in] count number of bytes written, may be less than reserved.
+   * \return Number of bytes committed.
+   */
+  size_t commit(size_t count) {
+    m_head = advance(m_head, count);
+    adjustCount(count);
+    return count;
+  }
   /**
    * Copy str to RingBuf.
    *
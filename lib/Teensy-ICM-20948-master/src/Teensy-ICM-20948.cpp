@@ -305,6 +305,11 @@ inline void build_sensor_event_data(void * context, enum inv_icm20948_sensor sen
       sensor->quat_y = event.data.quaternion.quat[2];
       sensor->quat_z = event.data.quaternion.quat[3];
       sensor->quat_data_ready = true;
+
+      if (sensor->settings.buffer_frames) {
+        TeensyICM20948Frame *f = sensor->pushFrame(ICM_FRAME_QUAT, timestamp);
+        memcpy(f->quat, event.data.quaternion.quat, sizeof(f->quat));
+      }
       break;
 
     case INV_SENSOR_TYPE_BAC:
@@ -330,6 +335,12 @@ inline void build_sensor_event_data(void * context, enum inv_icm20948_sensor sen
     case INV_SENSOR_TYPE_RAW_ACCELEROMETER:
     case INV_SENSOR_TYPE_RAW_GYROSCOPE:
       memcpy(event.data.raw3d.vect, data, sizeof(event.data.raw3d.vect));
+
+      if (sensor->settings.buffer_frames) {
+        uint8_t type = sensor_id == INV_SENSOR_TYPE_RAW_GYROSCOPE ? ICM_FRAME_RAW_GYRO : ICM_FRAME_RAW_ACCEL;
+        TeensyICM20948Frame *f = sensor->pushFrame(type, timestamp);
+        memcpy(f->raw, event.data.raw3d.vect, sizeof(f->raw));
+      }
       break;
     default:
       return;
@@ -447,20 +458,54 @@ bool TeensyICM20948::init()
   rc |= inv_icm20948_set_sensor_period(&icm_device, idd_sensortype_conversion(INV_SENSOR_TYPE_GYROSCOPE), 1000 / settings.gyroscope_frequency);
   rc |= inv_icm20948_set_sensor_period(&icm_device, idd_sensortype_conversion(INV_SENSOR_TYPE_ACCELEROMETER), 1000 / settings.accelerometer_frequency);
   rc |= inv_icm20948_set_sensor_period(&icm_device, idd_sensortype_conversion(INV_SENSOR_TYPE_MAGNETOMETER), 1000 / settings.magnetometer_frequency);
+  rc |= inv_icm20948_set_sensor_period(&icm_device, idd_sensortype_conversion(INV_SENSOR_TYPE_RAW_GYROSCOPE), 1000 / settings.gyroscope_frequency);
+  rc |= inv_icm20948_set_sensor_period(&icm_device, idd_sensortype_conversion(INV_SENSOR_TYPE_RAW_ACCELEROMETER), 1000 / settings.accelerometer_frequency);
 
   // Enable / disable
   rc |= inv_icm20948_enable_sensor(&icm_device, idd_sensortype_conversion(INV_SENSOR_TYPE_GYROSCOPE), settings.enable_gyroscope);
   rc |= inv_icm20948_enable_sensor(&icm_device, idd_sensortype_conversion(INV_SENSOR_TYPE_ACCELEROMETER), settings.enable_accelerometer);
   rc |= inv_icm20948_enable_sensor(&icm_device, idd_sensortype_conversion(INV_SENSOR_TYPE_GAME_ROTATION_VECTOR), settings.enable_quaternion);
   rc |= inv_icm20948_enable_sensor(&icm_device, idd_sensortype_conversion(INV_SENSOR_TYPE_MAGNETOMETER), settings.enable_magnetometer);
+  rc |= inv_icm20948_enable_sensor(&icm_device, idd_sensortype_conversion(INV_SENSOR_TYPE_RAW_GYROSCOPE), settings.enable_raw_gyroscope);
+  rc |= inv_icm20948_enable_sensor(&icm_device, idd_sensortype_conversion(INV_SENSOR_TYPE_RAW_ACCELEROMETER), settings.enable_raw_accelerometer);
+
+  // a restarted DMP starts its timestamps over
+  frame_head = frame_count = 0;
   return !(bool)rc;
 }
 
+// Handles everything waiting in the DMP FIFO, not just one sample: poll_sensor() loops
+// until the FIFO count it read is used up
 void TeensyICM20948::task()
 {
   inv_icm20948_poll_sensor(&icm_device, this, build_sensor_event_data);
 }
 
+// next slot in the frame buffer, the oldest frame makes room when it is full
+TeensyICM20948Frame *TeensyICM20948::pushFrame(uint8_t type, uint64_t timestamp)
+{
+  if (frame_count == ICM_FRAME_BUFFER) {
+    frame_head = (frame_head + 1) % ICM_FRAME_BUFFER;
+    frame_count--;
+    frame_overflows++;
+  }
+  TeensyICM20948Frame *f = &frames[(frame_head + frame_count++) % ICM_FRAME_BUFFER];
+  f->timestamp = timestamp;
+  f->type = type;
+  return f;
+}
+
+int TeensyICM20948::readFrames(TeensyICM20948Frame *out, int max)
+{
+  int n = 0;
+  while (n < max && frame_count > 0) {
+    out[n++] = frames[frame_head];
+    frame_head = (frame_head + 1) % ICM_FRAME_BUFFER;
+    frame_count--;
+  }
+  return n;
+}
+
 bool TeensyICM20948::gyroDataIsReady()
 {
   return gyro_data_ready;
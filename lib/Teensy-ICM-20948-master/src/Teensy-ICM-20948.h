@@ -24,6 +24,9 @@ typedef struct {
   bool enable_accelerometer   = true;
   bool enable_magnetometer    = true;
   bool enable_quaternion      = false;
+  bool enable_raw_gyroscope   = false; // raw outputs run at the gyroscope/accelerometer frequency
+  bool enable_raw_accelerometer = false;
+  bool buffer_frames          = false; // queue quaternion and raw outputs for readFrames()
   int gyroscope_frequency     = 225;
   int accelerometer_frequency = 225;
   int magnetometer_frequency  = 225;
@@ -31,6 +34,26 @@ typedef struct {
 
 } TeensyICM20948Settings;
 
+// With buffer_frames, every quaternion and raw sample task() pulls out of the DMP FIFO is
+// queued here, up to ICM_FRAME_BUFFER of them. If readFrames() doesn't keep up the oldest
+// ones are dropped (getFrameOverflows())
+#define ICM_FRAME_BUFFER 64
+
+enum TeensyICM20948FrameType : uint8_t {
+  ICM_FRAME_QUAT = 0,  // game rotation vector, quat = w, x, y, z
+  ICM_FRAME_RAW_GYRO,  // raw = x, y, z in LSB of the gyro full scale (2000 dps, 16.4 LSB/dps)
+  ICM_FRAME_RAW_ACCEL  // raw = x, y, z in LSB of the accel full scale (16 g, 2048 LSB/g)
+};
+
+typedef struct {
+  uint64_t timestamp; // us, the DMP driver's sample time (micros() at the FIFO read, stepped back by the ODR)
+  uint8_t  type;      // TeensyICM20948FrameType
+  union {
+    float   quat[4];
+    int32_t raw[3];
+  };
+} TeensyICM20948Frame;
+
 /*************************************************************************
   Class
 *************************************************************************/
@@ -55,6 +78,10 @@ class TeensyICM20948
     void readAccelData(float *x, float *y, float *z);
     void readMagData(float *x, float *y, float *z);
     void readQuatData(float *w, float *x, float *y, float *z);
+
+    // queued frames, oldest first, at most max of them. Returns how many were copied
+    int readFrames(TeensyICM20948Frame *frames, int max);
+    uint32_t getFrameOverflows() { return frame_overflows; }
     
     friend inline void build_sensor_event_data(void * context, enum inv_icm20948_sensor sensortype, uint64_t timestamp, const void * data, const void *arg);
     friend inline int idd_io_hal_read_reg(void * context, uint8_t reg, uint8_t * rbuffer, uint32_t rlen);
@@ -80,6 +107,12 @@ class TeensyICM20948
     bool mag_data_ready = false;
     bool quat_data_ready = false;
 
+    TeensyICM20948Frame frames[ICM_FRAME_BUFFER];
+    int      frame_head = 0; // oldest frame
+    int      frame_count = 0;
+    uint32_t frame_overflows = 0;
+    TeensyICM20948Frame *pushFrame(uint8_t type, uint64_t timestamp);
+
     void check_rc(int rc, const char * msg_context);
     int load_dmp3(void);
     inv_bool_t interface_is_SPI(void);
@@ -1,7 +1,7 @@
 /**
- * The sketch restores the GPS receiver default configuration and configures it to get NAV-PVT messages with 100 ms
- * frequency and 115200 baudrate. After the auto-configuration, it transmits the data from the GPS receiver to the
- * computer and vice versa.
+ * The sketch finds the GPS receiver at whatever baudrate it is at and configures it to get NAV-PVT messages with
+ * 100 ms frequency and 115200 baudrate, every step checked by the receiver's ACK. After the auto-configuration, it
+ * transmits the data from the GPS receiver to the computer and vice versa.
  *
  * u-blox NEO-7M - Arduino Mega
  * VCC - 5V
@@ -11,23 +11,28 @@
  */
 
 #include <Arduino.h>
+#include <UbloxGps.h>
 #include <UbxGpsConfig.h>
 
 #define COMPUTER_BAUDRATE 115200
 #define GPS_BAUDRATE 115200
 
+UbloxGps gps(Serial3);
+UbxGpsConfig ubxGpsConfig(gps);
+
 void setup()
 {
     Serial.begin(COMPUTER_BAUDRATE);
 
-    UbxGpsConfig<HardwareSerial, HardwareSerial> *ubxGpsConfig = new UbxGpsConfig<HardwareSerial, HardwareSerial>(Serial3, Serial);
-    ubxGpsConfig->setBaudrate(GPS_BAUDRATE);
-    ubxGpsConfig->setMessage(UbxGpsConfigMessage::NavPvt);
-    ubxGpsConfig->setRate(100);
-    ubxGpsConfig->configure();
-    delete ubxGpsConfig;
-
-    Serial3.begin(GPS_BAUDRATE);
+    const uint32_t bauds[] = {GPS_BAUDRATE};
+    const uint16_t rates[] = {100};
+    ubxGpsConfig.setBauds(bauds, 1);
+    ubxGpsConfig.setRates(rates, 1);
+    ubxGpsConfig.start();
+    while (!ubxGpsConfig.update())
+    {
+    }
+    ubxGpsConfig.report(Serial);
 }
 
 void loop()
@@ -1,6 +1,8 @@
 #ifndef PACKETS_H
 #define PACKETS_H
 
+#include <stdint.h>
+
 struct commonHeader {
   unsigned char headerClass;
   unsigned char headerId;
@@ -8,40 +10,86 @@ struct commonHeader {
 };
 
 struct NavPvtPacket {
-  // note that 'long' is typically 4 bytes. on a machine where it is 8, this code breaks
+  // fixed width types, this is the wire layout and 'long' is 8 bytes on a 64 bit PC
   commonHeader    header;
-  unsigned long   iTOW;       //  ms    GPS time of week of the navigation epoch. See the description of iTOW for details.
-  unsigned short  year;       //  y     Year (UTC)
-  unsigned char   month;      //  month Month, range 1..12 (UTC)
-  unsigned char   day;        //  d     Day of month, range 1..31 (UTC)
-  unsigned char   hour;       //  h     Hour of day, range 0..23 (UTC)
-  unsigned char   min;        //  min   Minute of hour, range 0..59 (UTC)
-  unsigned char   sec;        //  s     Seconds of minute, range 0..60 (UTC)
+  uint32_t        iTOW;       //  ms    GPS time of week of the navigation epoch. See the description of iTOW for details.
+  uint16_t        year;       //  y     Year (UTC)
+  uint8_t         month;      //  month Month, range 1..12 (UTC)
+  uint8_t         day;        //  d     Day of month, range 1..31 (UTC)
+  uint8_t         hour;       //  h     Hour of day, range 0..23 (UTC)
+  uint8_t         min;        //  min   Minute of hour, range 0..59 (UTC)
+  uint8_t         sec;        //  s     Seconds of minute, range 0..60 (UTC)
   char            valid;      //        Validity Flags (see graphic below)
-  unsigned long   tAcc;       //  ns    Time accuracy estimate (UTC)
-  long            nano;       //  ns    Fraction of second, range -1e9 .. 1e9 (UTC)
-  unsigned char   fixType;    //        GNSSfix Type, range 0..5, 0x00 = No Fix, 0x01 = Dead Reckoning only, 0x02 = 2D-Fix, 0x03 = 3D-Fix, 0x04 = GNSS + dead reckoning combined, 0x05 = Time only fix, 0x06..0xff: reserved,
+  uint32_t        tAcc;       //  ns    Time accuracy estimate (UTC)
+  int32_t         nano;       //  ns    Fraction of second, range -1e9 .. 1e9 (UTC)
+  uint8_t         fixType;    //        GNSSfix Type, range 0..5, 0x00 = No Fix, 0x01 = Dead Reckoning only, 0x02 = 2D-Fix, 0x03 = 3D-Fix, 0x04 = GNSS + dead reckoning combined, 0x05 = Time only fix, 0x06..0xff: reserved,
   char            flags;      //        Fix Status Flags (see graphic below)
-  unsigned char   reserved1;  //        Reserved
-  unsigned char   numSV;      //        Number of satellites used in Nav Solution
-  long            lon;        //  deg   Longitude (1e-7)
-  long            lat;        //  deg   Latitude (1e-7)
-  long            alt;        //  mm    Height above Ellipsoid
-  long            hMSL;       //  mm    Height above mean sea level
-  unsigned long   hAcc;       //  mm    Horizontal Accuracy Estimate
-  unsigned long   vAcc;       //  mm    Vertical Accuracy Estimate
-  long            velN;       //  mm/s  NED north velocity
-  long            velE;       //  mm/s  NED east velocity
-  long            velD;       //  mm/s  NED down velocity
-  long            gSpeed;     //  mm/s  Ground Speed (2-D)
-  long            heading;    //  deg   Heading of motion 2-D (1e-5)
-  unsigned long   sAcc;       //  mm/s  Speed Accuracy Estimate
-  unsigned long   headingAcc; //  deg   Heading Accuracy Estimate (1e-5)
-  unsigned short  pDOP;       //        Position DOP (0.01)
-  short           reserved2;  //        Reserved
-  unsigned long   reserved3;  //        Reserved
+  uint8_t         reserved1;  //        Reserved
+  uint8_t         numSV;      //        Number of satellites used in Nav Solution
+  int32_t         lon;        //  deg   Longitude (1e-7)
+  int32_t         lat;        //  deg   Latitude (1e-7)
+  int32_t         alt;        //  mm    Height above Ellipsoid
+  int32_t         hMSL;       //  mm    Height above mean sea level
+  uint32_t        hAcc;       //  mm    Horizontal Accuracy Estimate
+  uint32_t        vAcc;       //  mm    Vertical Accuracy Estimate
+  int32_t         velN;       //  mm/s  NED north velocity
+  int32_t         velE;       //  mm/s  NED east velocity
+  int32_t         velD;       //  mm/s  NED down velocity
+  int32_t         gSpeed;     //  mm/s  Ground Speed (2-D)
+  int32_t         heading;    //  deg   Heading of motion 2-D (1e-5)
+  uint32_t        sAcc;       //  mm/s  Speed Accuracy Estimate
+  uint32_t        headingAcc; //  deg   Heading Accuracy Estimate (1e-5)
+  uint16_t        pDOP;       //        Position DOP (0.01)
+  int16_t         reserved2;  //        Reserved
+  uint32_t        reserved3;  //        Reserved
+
+};
+static_assert(sizeof(NavPvtPacket) == 88, "u-blox 7 NAV-PVT is 4 header bytes and 84 payload bytes");
+
+struct NavTimeGpsPacket {
+  commonHeader    header;
+  uint32_t        iTOW;       //  ms    GPS time of week of the navigation epoch
+  int32_t         fTOW;       //  ns    Fractional part of iTOW (range: +/-500000), the precise GPS time of week in
+                              //        seconds is: (iTOW * 1e-3) + (fTOW * 1e-9)
+  int16_t         week;       //  weeks GPS week number of the navigation epoch
+  int8_t          leapS;      //  s     GPS leap seconds (GPS-UTC)
+  uint8_t         valid;      //        Validity flags, 0x01 towValid, 0x02 weekValid, 0x04 leapSValid
+  uint32_t        tAcc;       //  ns    Time accuracy estimate
+};
+static_assert(sizeof(NavTimeGpsPacket) == 20, "NAV-TIMEGPS is 4 header bytes and 16 payload bytes");
 
+// NAV-SAT (u-blox 8 and later, a u-blox 7 has NAV-SVINFO instead): numSvs of these follow the
+// packet in the frame
+struct NavSatSv {
+  uint8_t         gnssId;     //        GNSS identifier
+  uint8_t         svId;       //        Satellite identifier
+  uint8_t         cno;        //  dBHz  Carrier to noise ratio (signal strength)
+  int8_t          elev;       //  deg   Elevation (range: +/-90), unknown if out of range
+  int16_t         azim;       //  deg   Azimuth (range 0-360), unknown if elevation is out of range
+  int16_t         prRes;      //  m     Pseudorange residual (0.1)
+  uint32_t        flags;      //        Bitmask, 0x07 signal quality, 0x08 used in the solution
 };
+static_assert(sizeof(NavSatSv) == 12, "NAV-SAT repeats 12 bytes per satellite");
+
+struct NavSatPacket {
+  commonHeader    header;
+  uint32_t        iTOW;       //  ms    GPS time of week of the navigation epoch
+  uint8_t         version;    //        Message version (0x01 for this version)
+  uint8_t         numSvs;     //        Number of satellites
+  uint8_t         reserved1[2];
+
+  const NavSatSv *svs() const { return (const NavSatSv *) (this + 1); }
+};
+static_assert(sizeof(NavSatPacket) == 12, "NAV-SAT is 4 header bytes and 8 payload bytes before the satellites");
+
+// ACK-ACK and ACK-NAK, the answer to every CFG message
+struct AckPacket {
+  commonHeader    header;
+  uint8_t         clsID;      //        Class ID of the (not) acknowledged message
+  uint8_t         msgID;      //        Message ID of the (not) acknowledged message
+};
+static_assert(sizeof(AckPacket) == 6, "ACK is 4 header bytes and 2 payload bytes");
+
 // write Packet unions like ^ to enable other UBX message types.
 /*
   // Type       Name        Unit  Description (Scaling)
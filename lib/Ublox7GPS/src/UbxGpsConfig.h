@@ -1,387 +1,446 @@
+// Receiver configuration, checked by ACK and never blocking
+//
+// UbxGpsConfig takes a u-blox receiver from whatever it was left in (factory 9600 baud NMEA,
+// or what the last boot set up) to UBX only at the fastest baud and measurement rate that
+// work. Each update() does at most one step and never waits on the port, so it can run from
+// the loop, or while waiting for the start command, without holding anything up:
+//
+//   PROBE    poll MON-VER at each baud, fastest first, until the receiver answers
+//   BAUD     CFG-PRT to a faster baud (UBX only out, which is also what turns NMEA off),
+//            follow it once it has gone out and poll again. A NAK, or no answer there
+//            (which rolls the receiver back to the last good baud), and the next slower
+//            one is tried
+//   RATE     CFG-RATE, fastest first, skipping what the enabled messages would need more
+//            than GPS_CONFIG_LINK_LOAD percent of the baud for. A NAK moves on to the next
+//   MESSAGES CFG-MSG for every enable()d message, then CFG-GNSS (GPS only, NAK is fine)
+//   VERIFY   two NAV-PVTs, their iTOW difference is the rate the receiver really runs at
+//
+// Every command waits for its ACK-ACK/ACK-NAK (or the poll's answer) with a timeout, and
+// goes out again up to GPS_CONFIG_RETRIES times before it counts as failed (not PROBE's
+// polls, its next pass over the bauds is the retry). The replies come in through the
+// UbloxGps parser, which update() drives, on handlers of the config's own for ACK, MON-VER
+// and NAV-PVT. Register yours once done() is true.
+
 #ifndef UBXGPSCONFIG_H_INCLUDED
 #define UBXGPSCONFIG_H_INCLUDED
 
 #include <Arduino.h>
+#include "UbloxGps.h"
 
-// The default baudrate is determined by the GPS receiver manufacturer.
+// what a receiver comes up at from the factory, probed last if it isn't a candidate
 #define GPS_DEFAULT_BAUDRATE 9600
 
-enum class UbxGpsConfigMessage
-{
-    NavPosecef = 0x01,
-    NavPossllh = 0x02,
-    NavPvt = 0x07,
-    NavSol = 0x06,
-};
-
-// An array of possible baudrates that can be used by the GPS receiver, sorted descending to prevent excess Serial
-// flush/begin after restoring defaults. You can uncomment values that can be used by your GPS receiver before the
-// auto-configuration.
-const long gpsPossibleBaudrates[] = {
-    // 921600,
-    // 460800,
-    // 230400,
-    //115200,
-    // 57600,
-    // 38400,
-    // 19200,
-    9600,
-    // 4800,
-};
+#define GPS_CONFIG_TIMEOUT_MS   100 // on top of the time the command and its answer take on the wire
+#define GPS_CONFIG_REPLY_BYTES  128 // the answer's share of that, a MON-VER with a few extensions
+#define GPS_CONFIG_RETRIES      2
+#define GPS_CONFIG_PROBE_PASSES 2   // over every baud, the receiver may still be booting on the first
+#define GPS_CONFIG_SETTLE_MS    10  // after a CFG-PRT has gone out, for the receiver to switch over
+#define GPS_CONFIG_LINK_LOAD    75  // percent of the baud the enabled messages may use
+#define GPS_CONFIG_VERIFY_MS    1000 // on top of two epochs, for VERIFY's NAV-PVTs
+#define GPS_CONFIG_MAX_BAUDS    8
+#define GPS_CONFIG_MAX_RATES    8
+#define GPS_CONFIG_MAX_MESSAGES 4
 
-template <class GpsSerial = HardwareSerial, class LogSerial = HardwareSerial>
-class UbxGpsConfig
-{
-private:
-    GpsSerial &gpsSerial;
-    LogSerial &logSerial;
-
-    unsigned long baudrate;
-    UbxGpsConfigMessage message;
-    unsigned short rate;
-
-    // Print a packet to the log serial port in a hexadecimal form.
-    void printPacket(byte *packet, byte len)
-    {
-        char temp[3];
-
-        for (byte i = 0; i < len; i++)
-        {
-            sprintf(temp, "%.2X", packet[i]);
-            logSerial.print(temp);
-
-            if (i != len - 1)
-            {
-                logSerial.print(' ');
-            }
-        }
+class UbxGpsConfig {
 
-        logSerial.println();
-    }
+public:
 
-    // Send a packet to the GPS receiver.
-    void sendPacket(byte *packet, byte len)
-    {
-        for (byte i = 0; i < len; i++)
-        {
-            gpsSerial.write(packet[i]);
-        }
+  enum Result : uint8_t { IDLE, RUNNING, OK, NO_RECEIVER, FAILED };
 
-        printPacket(packet, len);
-    }
+  UbxGpsConfig(UbloxGps &gps) : gps(gps), serial(gps.getSerial()) {
+    enable(UBX_CLASS_NAV, UBX_NAV_PVT, sizeof(NavPvtPacket) + 4);
+  }
 
-    // Send a packet to the GPS receiver to restore the default configuration.
-    void restoreDefaults()
-    {
-        // CFG-CFG packet.
-        byte packet[] = {
-            0xB5, // sync char 1
-            0x62, // sync char 2
-            0x06, // class
-            0x09, // id
-            0x0D, // length
-            0x00, // length
-            0xFF, // payload
-            0xFF, // payload
-            0x00, // payload
-            0x00, // payload
-            0x00, // payload
-            0x00, // payload
-            0x00, // payload
-            0x00, // payload
-            0xFF, // payload
-            0xFF, // payload
-            0x00, // payload
-            0x00, // payload
-            0x17, // payload
-            0x2F, // CK_A
-            0xAE, // CK_B
-        };
-
-        sendPacket(packet, sizeof(packet));
+  // candidate bauds, fastest first
+  void setBauds(const uint32_t *list, uint8_t count) {
+    baudCount = 0;
+    bool factory = false;
+    for (uint8_t i = 0; i < count && baudCount < GPS_CONFIG_MAX_BAUDS; i++) {
+      bauds[baudCount++] = list[i];
+      factory |= list[i] == GPS_DEFAULT_BAUDRATE;
     }
-
-    // Send a set of packets to the GPS receiver to disable NMEA messages.
-    void disableNmea()
-    {
-        // An array of two bytes for CFG-MSG packets payload.
-        byte messages[][2] = {
-            {0xF0, 0x0A},
-            {0xF0, 0x09},
-            {0xF0, 0x00},
-            {0xF0, 0x01},
-            {0xF0, 0x0D},
-            {0xF0, 0x06},
-            {0xF0, 0x02},
-            {0xF0, 0x07},
-            {0xF0, 0x03},
-            {0xF0, 0x04},
-            {0xF0, 0x0E},
-            {0xF0, 0x0F},
-            {0xF0, 0x05},
-            {0xF0, 0x08},
-            {0xF1, 0x00},
-            {0xF1, 0x01},
-            {0xF1, 0x03},
-            {0xF1, 0x04},
-            {0xF1, 0x05},
-            {0xF1, 0x06},
-        };
-
-        // CFG-MSG packet buffer.
-        byte packet[] = {
-            0xB5, // sync char 1
-            0x62, // sync char 2
-            0x06, // class
-            0x01, // id
-            0x03, // length
-            0x00, // length
-            0x00, // payload (first byte from messages array element)
-            0x00, // payload (second byte from messages array element)
-            0x00, // payload (not changed in this case)
-            0x00, // CK_A
-            0x00, // CK_B
-        };
-        byte packetSize = sizeof(packet);
-
-        // Offset to a place where payload starts.
-        byte payloadOffset = 6;
-
-        // Iterate over the messages array.
-        for (byte i = 0; i < sizeof(messages) / sizeof(*messages); i++)
-        {
-            // Copy two bytes of payload to the packet buffer.
-            for (byte j = 0; j < sizeof(*messages); j++)
-            {
-                packet[payloadOffset + j] = messages[i][j];
-            }
-
-            // Set checksum bytes to null.
-            packet[packetSize - 2] = 0x00;
-            packet[packetSize - 1] = 0x00;
-
-            // Calculate checksum over the packet buffer excluding sync (first two) and checksum chars (last two).
-            for (byte j = 0; j < packetSize - 4; j++)
-            {
-                packet[packetSize - 2] += packet[2 + j];
-                packet[packetSize - 1] += packet[packetSize - 2];
-            }
-
-            sendPacket(packet, packetSize);
+    if (!factory && baudCount < GPS_CONFIG_MAX_BAUDS) bauds[baudCount++] = GPS_DEFAULT_BAUDRATE;
+  }
+
+  // candidate measurement periods in ms, fastest first
+  void setRates(const uint16_t *list, uint8_t count) {
+    rateCount = 0;
+    for (uint8_t i = 0; i < count && rateCount < GPS_CONFIG_MAX_RATES; i++) rates[rateCount++] = list[i];
+  }
+
+  // one more message at one per epoch, bytes is its whole frame (for the link budget).
+  // NAV-PVT is always on. False if there is no room
+  bool enable(uint8_t cls, uint8_t id, uint16_t bytes) {
+    if (messageCount == GPS_CONFIG_MAX_MESSAGES) return false;
+    messages[messageCount++] = {cls, id, bytes};
+    return true;
+  }
+
+  // from the top, again if it already ran
+  void start() {
+    gps.on(UBX_CLASS_ACK, UBX_ACK_ACK, onAck, this);
+    gps.on(UBX_CLASS_ACK, UBX_ACK_NAK, onAck, this);
+    gps.on(UBX_CLASS_MON, UBX_MON_VER, onVersion, this);
+    gps.on(UBX_CLASS_NAV, UBX_NAV_PVT, onPvt, this);
+    result    = RUNNING;
+    startMs   = millis();
+    baud      = 0;
+    rateMs    = 0;
+    measuredMs = 0;
+    retries   = 0;
+    naks      = 0;
+    badBauds  = 0;
+    version[0] = 0;
+    probe(0, 0);
+  }
+
+  // one step, true once done()
+  bool update() {
+    if (result != RUNNING) return result != IDLE;
+    gps.update(); // replies land in the handlers below
+    uint32_t now = millis();
+    Reply r = exchange(now);
+
+    switch (state) {
+      case PROBE:
+        if (r == ACKED) {
+          found(probing);
+        } else if (r == TIMED_OUT) {
+          if (probing + 1 < baudCount) probe(probing + 1, pass);
+          else if (pass + 1 < GPS_CONFIG_PROBE_PASSES) probe(0, pass + 1);
+          else finish(NO_RECEIVER);
+        }
+        break;
+      case SWITCH: // the CFG-PRT is out, follow it
+        if (r == NAKED) {
+          // it said no while still at the old baud, no need to go looking
+          naks++;
+          badBauds |= 1 << target;
+          found(good);
+        } else if (r == ACKED) {
+          setPort(bauds[target]);
+          askVersion();
+          state = CHECK;
         }
+        break;
+      case CHECK:
+        if (r == ACKED) {
+          found(target);
+        } else if (r == TIMED_OUT) {
+          // in case it did switch and only its answers don't make it, tell it to come back
+          badBauds |= 1 << target;
+          askPort(bauds[good]);
+          state = ROLLBACK;
+        }
+        break;
+      case ROLLBACK:
+        if (r != WAITING) {
+          setPort(bauds[good]);
+          askVersion();
+          state = RECHECK;
+        }
+        break;
+      case RECHECK:
+        if (r == ACKED) found(good);
+        else if (r == TIMED_OUT) probe(0, 0); // lost it, start over without the bad baud
+        break;
+      case RATE:
+        if (r == ACKED) {
+          rateMs = rates[rateIndex];
+          setMessage(0);
+        } else if (r == NAKED) {
+          naks++;
+          setRate(rateIndex + 1);
+        } else if (r == TIMED_OUT) {
+          finish(FAILED);
+        }
+        break;
+      case MESSAGES:
+        if (r == NAKED) naks++;
+        if (r == ACKED || r == NAKED) setMessage(messageIndex + 1);
+        else if (r == TIMED_OUT) finish(FAILED);
+        break;
+      case GNSS:
+        if (r == NAKED) naks++; // not a u-blox 7, it keeps its own constellations
+        if (r != WAITING) {
+          pvts = 0;
+          verifyUntil = now + 2 * (rateMs ? rateMs : 1000) + GPS_CONFIG_VERIFY_MS;
+          state = VERIFY;
+        }
+        break;
+      case VERIFY:
+        if (pvts >= 2 || (int32_t) (now - verifyUntil) >= 0) finish(OK); // without NAV-PVTs measured stays 0
+        break;
+      default:
+        break;
     }
-
-    // Send a packet to the GPS receiver to change the baudrate to 115200.
-    void changeBaudrate()
-    {
-        // CFG-PRT packet.
-        byte packet[] = {
-            0xB5, // sync char 1
-            0x62, // sync char 2
-            0x06, // class
-            0x00, // id
-            0x14, // length
-            0x00, // length
-            0x01, // payload
-            0x00, // payload
-            0x00, // payload
-            0x00, // payload
-            0xD0, // payload
-            0x08, // payload
-            0x00, // payload
-            0x00, // payload
-            0x00, // payload
-            0xC2, // payload
-            0x01, // payload
-            0x00, // payload
-            0x07, // payload
-            0x00, // payload
-            0x03, // payload
-            0x00, // payload
-            0x00, // payload
-            0x00, // payload
-            0x00, // payload
-            0x00, // payload
-            0xC0, // CK_A
-            0x7E, // CK_B
-        };
-
-        sendPacket(packet, sizeof(packet));
+    return result != RUNNING;
+  }
+
+  bool     done()              const { return result != IDLE && result != RUNNING; }
+  Result   getResult()         const { return result; }
+  uint32_t getBaud()           const { return baud; }       // 0 if the receiver was never found
+  uint16_t getRateMs()         const { return rateMs; }     // measurement period it ACKed, 0 for none
+  uint16_t getMeasuredRateMs() const { return measuredMs; } // between VERIFY's NAV-PVTs, 0 without them
+  uint32_t getElapsedMs()      const { return elapsedMs; }
+  uint16_t getRetries()        const { return retries; }
+  uint16_t getNaks()           const { return naks; }
+  const char *getVersion()     const { return version; }    // MON-VER software and hardware versions
+
+  void report(Print &out) const {
+    switch (result) {
+      case OK:          out.print("configured "); break;
+      case NO_RECEIVER: out.print("no receiver "); break;
+      case FAILED:      out.print("config failed "); break;
+      default:          out.print("not configured "); break;
     }
-
-    // Send a packet to the GPS receiver to change the frequency to 100 ms.
-    void changeFrequency()
-    {
-        // CFG-RATE packet.
-        byte packet[] = {
-            0xB5, // sync char 1
-            0x62, // sync char 2
-            0x06, // class
-            0x08, // id
-            0x06, // length
-            0x00, // length
-            0x64, // payload
-            0x00, // payload
-            0x01, // payload
-            0x00, // payload
-            0x01, // payload
-            0x00, // payload
-            0x7A, // CK_A
-            0x12, // CK_B
-        };
-
-        sendPacket(packet, sizeof(packet));
+    if (version[0]) {
+      out.print(version);
+      out.print(' ');
     }
-
-    // Send a packet to the GPS receiver to disable unnecessary channels.
-    void disableUnnecessaryChannels()
-    {
-        // CFG-GNSS packet.
-        byte packet[] = {
-            0xB5, // sync char 1
-            0x62, // sync char 2
-            0x06, // class
-            0x3E, // id
-            0x24, // length
-            0x00, // length
-
-            0x00, 0x00, 0x16, 0x04, 0x00, 0x04, 0xFF, 0x00, // payload
-            0x01, 0x00, 0x00, 0x01, 0x01, 0x01, 0x03, 0x00, // payload
-            0x00, 0x00, 0x00, 0x01, 0x05, 0x00, 0x03, 0x00, // payload
-            0x00, 0x00, 0x00, 0x01, 0x06, 0x08, 0xFF, 0x00, // payload
-            0x00, 0x00, 0x00, 0x01,                         // payload
-
-            0xA4, // CK_A
-            0x25, // CK_B
-        };
-
-        sendPacket(packet, sizeof(packet));
+    if (baud) {
+      out.print("at ");
+      out.print(baud);
+      out.print(" baud, ");
     }
-
-    // Send a packet to the GPS receiver to enable NAV-PVT messages.
-    void enableNavPvt()
-    {
-        // CFG-MSG packet.
-        byte packet[] = {
-            0xB5,          // sync char 1
-            0x62,          // sync char 2
-            0x06,          // class
-            0x01,          // id
-            0x03,          // length
-            0x00,          // length
-            0x01,          // payload
-            (byte)message, // payload
-            0x01,          // payload
-            // TODO: Update checksum to fit message other than 0x07.
-            0x13, // CK_A
-            0x51, // CK_B
-        };
-
-        sendPacket(packet, sizeof(packet));
+    if (rateMs) {
+      out.print(rateMs);
+      out.print(" ms epochs (");
+      out.print(measuredMs);
+      out.print(" measured), ");
     }
+    out.print("took ");
+    out.print(elapsedMs);
+    out.print(" ms, ");
+    out.print(retries);
+    out.print(" retries, ");
+    out.print(naks);
+    out.println(" NAKs");
+  }
 
-public:
-    UbxGpsConfig(GpsSerial &gpsSerial, LogSerial &logSerial) : gpsSerial(gpsSerial),
-                                                               logSerial(logSerial)
-    {
-        //
-    }
+private:
 
-    // The target buadrate at the moment can be 9600 (not changed after defaults) or 115200 (changed by the
-    // `changeBaudrate()` function with a special message).
-    void setBaudrate(unsigned long _baudrate)
-    {
-        baudrate = _baudrate;
+  enum State : uint8_t { PROBE, SWITCH, CHECK, ROLLBACK, RECHECK, RATE, MESSAGES, GNSS, VERIFY, FINISHED };
+  enum Reply : uint8_t { WAITING, ACKED, NAKED, TIMED_OUT };
+  enum Expect : uint8_t { NOTHING, ACK, VERSION };
+
+  struct Message {
+    uint8_t  cls;
+    uint8_t  id;
+    uint16_t bytes;
+  };
+
+  // the receiver answered at bauds[index], try anything faster that isn't known bad
+  void found(uint8_t index) {
+    good = index;
+    baud = bauds[index];
+    for (target = 0; target < good; target++) {
+      if (!(badBauds & (1 << target))) break;
     }
-
-    void setMessage(UbxGpsConfigMessage _message)
-    {
-        message = _message;
+    if (target == good) {
+      setRate(0);
+      return;
     }
-
-    void setRate(unsigned short _rate)
-    {
-        rate = _rate;
+    askPort(bauds[target]);
+    state = SWITCH;
+  }
+
+  void probe(uint8_t index, uint8_t p) {
+    probing = index;
+    pass    = p;
+    setPort(bauds[index]);
+    askVersion();
+    maxTries = 0; // the next pass is the retry, no point hammering a baud it isn't at
+    state = PROBE;
+  }
+
+  // first rate from index on the link can carry, or the slowest if none
+  void setRate(uint8_t index) {
+    uint32_t bytes = 0;
+    for (uint8_t i = 0; i < messageCount; i++) bytes += messages[i].bytes;
+    while (index < rateCount &&
+           (uint64_t) bytes * 1000 * 10 * 100 > (uint64_t) baud * rates[index] * GPS_CONFIG_LINK_LOAD) {
+      index++;
     }
-
-    void configure()
-    {
-        //logSerial.println("Starting auto-configuration...");
-
-        // Restore the default GPS receiver configuration.
-        for (byte i = 0; i < sizeof(gpsPossibleBaudrates) / sizeof(*gpsPossibleBaudrates); i++)
-        {
-            //logSerial.print("Trying to restore defaults at ");
-            //logSerial.print(gpsPossibleBaudrates[i]);
-            //logSerial.println(" baudrate...");
-
-            if (i != 0)
-            {
-                delay(100); // Little delay before the flush.
-                gpsSerial.flush();
-            }
-
-            gpsSerial.begin(gpsPossibleBaudrates[i]);
-            restoreDefaults();
-        }
-
-        // Switch the GPS receiver serial configuration to the default baudrate.
-        if (gpsPossibleBaudrates[sizeof(gpsPossibleBaudrates) / sizeof(*gpsPossibleBaudrates) - 1] != GPS_DEFAULT_BAUDRATE)
-        {
-            //logSerial.print("Switching to the default baudrate which is ");
-            //logSerial.print(GPS_DEFAULT_BAUDRATE);
-            //logSerial.println("...");
-
-            delay(100); // Little delay before the flush.
-            gpsSerial.flush();
-            gpsSerial.begin(GPS_DEFAULT_BAUDRATE);
-        }
-
-        // Disable NMEA messages by sending appropriate packets.
-        //logSerial.println("Disabling NMEA messages...");
-        disableNmea();
-
-        // Switch the GPS receiver serial configuration to the target baudrate.
-        if (baudrate != GPS_DEFAULT_BAUDRATE)
-        {
-            //logSerial.print("Switching to the target baudrate which is ");
-            //logSerial.print(baudrate);
-            //logSerial.println("...");
-
-            changeBaudrate();
-
-            delay(100); // Little delay before the flush.
-            gpsSerial.flush();
-            gpsSerial.begin(baudrate);
-        }
-
-        if (rate == 100)
-        {
-            // Change receiving frequency to 100 ms.
-            //logSerial.println("Changing receiving frequency to 100 ms...");
-            changeFrequency();
-        }
-
-        // Disable unnecessary channels like SBAS or QZSS.
-        //logSerial.println("Disabling unnecessary channels...");
-        disableUnnecessaryChannels();
-        delay(100);
-
-        // Enable NAV-PVT messages.
-        //logSerial.println("Enabling NAV-PVT messages...");
-        enableNavPvt();
-        delay(100);
-
-        //logSerial.println("Auto-configuration is complete!");
-
-        delay(100); // Little delay before the flush.
-        gpsSerial.flush();
+    if (index >= rateCount) {
+      // nothing left that fits (or was ACKed), the receiver keeps what it has
+      setMessage(0);
+      return;
     }
-
-    ~UbxGpsConfig()
-    {
-        gpsSerial.end();
+    rateIndex = index;
+    uint8_t payload[6] = {(uint8_t) rates[index], (uint8_t) (rates[index] >> 8), 1, 0, 1, 0}; // every measurement, GPS time
+    ask(UBX_CLASS_CFG, UBX_CFG_RATE, payload, sizeof(payload), ACK);
+    state = RATE;
+  }
+
+  void setMessage(uint8_t index) {
+    messageIndex = index;
+    if (index == messageCount) {
+      setGnss();
+      return;
+    }
+    uint8_t payload[3] = {messages[index].cls, messages[index].id, 1}; // on this port, every epoch
+    ask(UBX_CLASS_CFG, UBX_CFG_MSG, payload, sizeof(payload), ACK);
+    state = MESSAGES;
+  }
+
+  // GPS only, SBAS and QZSS off (u-blox 7 block layout)
+  void setGnss() {
+    static const uint8_t payload[] = {
+      0x00, 0x00, 0x16, 0x04, 0x00, 0x04, 0xFF, 0x00,
+      0x01, 0x00, 0x00, 0x01, 0x01, 0x01, 0x03, 0x00,
+      0x00, 0x00, 0x00, 0x01, 0x05, 0x00, 0x03, 0x00,
+      0x00, 0x00, 0x00, 0x01, 0x06, 0x08, 0xFF, 0x00,
+      0x00, 0x00, 0x00, 0x01,
+    };
+    ask(UBX_CLASS_CFG, UBX_CFG_GNSS, payload, sizeof(payload), ACK);
+    state = GNSS;
+  }
+
+  // UART1 at b, 8N1, UBX/NMEA/RTCM in and UBX only out. Nothing to wait for, the ACK (if any)
+  // goes out at whichever baud the receiver feels like
+  void askPort(uint32_t b) {
+    uint8_t payload[20] = {0x01, 0x00, 0x00, 0x00, 0xD0, 0x08, 0x00, 0x00,
+                           (uint8_t) b, (uint8_t) (b >> 8), (uint8_t) (b >> 16), (uint8_t) (b >> 24),
+                           0x07, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00};
+    ask(UBX_CLASS_CFG, UBX_CFG_PRT, payload, sizeof(payload), NOTHING);
+  }
+
+  void askVersion() { ask(UBX_CLASS_MON, UBX_MON_VER, nullptr, 0, VERSION); }
+
+  void setPort(uint32_t b) {
+    portBaud = b;
+    serial.begin(b);
+  }
+
+  // the command exchange() sends next
+  void ask(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len, Expect e) {
+    uint8_t header[4] = {cls, id, (uint8_t) len, (uint8_t) (len >> 8)};
+    tx[0] = UBX_SYNC_1;
+    tx[1] = UBX_SYNC_2;
+    memcpy(tx + 2, header, sizeof(header));
+    if (len) memcpy(tx + 6, payload, len);
+    uint8_t a = 0, b = 0;
+    for (uint16_t i = 2; i < 6 + len; i++) {
+      a += tx[i];
+      b += a;
+    }
+    tx[6 + len] = a;
+    tx[7 + len] = b;
+    txLen   = 8 + len;
+    txPos   = 0;
+    askCls  = cls;
+    askId   = id;
+    expect  = e;
+    tries   = 0;
+    maxTries = GPS_CONFIG_RETRIES;
+    reply   = WAITING;
+  }
+
+  // ms the bytes take on the wire at the port's baud, rounded up
+  uint32_t wireMs(uint32_t bytes) const { return (bytes * 10 * 1000 + portBaud - 1) / portBaud; }
+
+  // sends the command a bit at a time as the UART has room, then waits for its answer. A
+  // command that expects nothing is ACKED once it has had time to go out and settle
+  Reply exchange(uint32_t now) {
+    if (state == VERIFY || state == FINISHED) return WAITING;
+    if (reply != WAITING) return reply;
+    if (txPos < txLen) {
+      int room = serial.availableForWrite();
+      if (room <= 0) return WAITING;
+      uint16_t n = txLen - txPos;
+      if (n > (uint16_t) room) n = room;
+      serial.write(tx + txPos, n);
+      txPos += n;
+      if (txPos < txLen) return WAITING;
+      deadline = now + wireMs(txLen) + (expect == NOTHING ? GPS_CONFIG_SETTLE_MS : wireMs(GPS_CONFIG_REPLY_BYTES) + GPS_CONFIG_TIMEOUT_MS);
+      return WAITING;
     }
+    if ((int32_t) (now - deadline) < 0) return WAITING;
+    if (expect == NOTHING) return reply = ACKED;
+    if (tries < maxTries) {
+      tries++;
+      retries++;
+      txPos = 0;
+      return WAITING;
+    }
+    return reply = TIMED_OUT;
+  }
+
+  void finish(Result r) {
+    result    = r;
+    state     = FINISHED;
+    elapsedMs = millis() - startMs;
+    if (!baud) setPort(GPS_DEFAULT_BAUDRATE); // a receiver that shows up later most likely comes up there
+  }
+
+  // a command that expects nothing (CFG-PRT) can still be NAKed before the port switches
+  static void onAck(const UbxFrame &frame, void *context) {
+    UbxGpsConfig *c = (UbxGpsConfig *) context;
+    if (c->expect == VERSION || c->reply != WAITING || c->txPos < c->txLen || frame.length < 2) return;
+    if (frame.payload[0] != c->askCls || frame.payload[1] != c->askId) return; // a late one for something else
+    if (c->expect == NOTHING && frame.id == UBX_ACK_ACK) return; // it's going by the clock
+    c->reply = frame.id == UBX_ACK_ACK ? ACKED : NAKED;
+  }
+
+  static void onVersion(const UbxFrame &frame, void *context) {
+    UbxGpsConfig *c = (UbxGpsConfig *) context;
+    if (c->expect != VERSION || c->reply != WAITING || c->txPos < c->txLen || frame.length < 40) return;
+    // swVersion[30] then hwVersion[10], both zero padded
+    size_t n = strnlen((const char *) frame.payload, 30);
+    memcpy(c->version, frame.payload, n);
+    c->version[n] = ' ';
+    size_t m = strnlen((const char *) frame.payload + 30, 10);
+    memcpy(c->version + n + 1, frame.payload + 30, m);
+    c->version[n + 1 + m] = 0;
+    c->reply = ACKED;
+  }
+
+  static void onPvt(const UbxFrame &frame, void *context) {
+    UbxGpsConfig *c = (UbxGpsConfig *) context;
+    const NavPvtPacket *pvt = frame.as<NavPvtPacket>();
+    if (c->state != VERIFY || !pvt) return;
+    if (c->pvts++) c->measuredMs = pvt->iTOW - c->firstTow;
+    else c->firstTow = pvt->iTOW;
+  }
+
+  UbloxGps       &gps;
+  HardwareSerial &serial;
+
+  uint32_t bauds[GPS_CONFIG_MAX_BAUDS] = {GPS_DEFAULT_BAUDRATE};
+  uint8_t  baudCount = 1;
+  uint16_t rates[GPS_CONFIG_MAX_RATES] = {1000};
+  uint8_t  rateCount = 1;
+  Message  messages[GPS_CONFIG_MAX_MESSAGES];
+  uint8_t  messageCount = 0;
+
+  Result   result = IDLE;
+  State    state  = FINISHED;
+  uint8_t  probing = 0, pass = 0;      // PROBE's baud and pass over them
+  uint8_t  good = 0, target = 0;       // last baud it answered at, the one being tried
+  uint8_t  badBauds = 0;               // bit per baud that didn't work after a switch
+  uint8_t  rateIndex = 0, messageIndex = 0;
+  uint32_t portBaud = GPS_DEFAULT_BAUDRATE;
+
+  // the command in flight
+  uint8_t  tx[8 + 40];
+  uint16_t txLen = 0, txPos = 0;
+  uint8_t  askCls = 0, askId = 0;
+  Expect   expect = NOTHING;
+  Reply    reply  = WAITING;
+  uint8_t  tries  = 0, maxTries = 0;
+  uint32_t deadline = 0;
+
+  uint8_t  pvts = 0;
+  uint32_t firstTow = 0;
+  uint32_t verifyUntil = 0;
+
+  uint32_t startMs = 0, elapsedMs = 0;
+  uint32_t baud = 0;
+  uint16_t rateMs = 0, measuredMs = 0;
+  uint16_t retries = 0, naks = 0;
+  char     version[42] = "";
+
 };
 
 #endif
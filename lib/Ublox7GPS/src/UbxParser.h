@@ -0,0 +1,202 @@
+// UBX framing and dispatch
+//
+// UbxParser takes the receiver's bytes as they come, one at a time or in chunks, and finds
+// the UBX frames in them: sync chars, class, id, 16 bit little endian length, payload and
+// the Fletcher checksum over everything from the class on. Every frame whose checksum
+// holds goes to the handler registered for its class/id, in place: the handler sees the
+// parser's buffer (the 4 header bytes then the payload, 4 byte aligned, the layout of the
+// structs in Packets.h) and only until it returns. Nothing is copied out.
+//
+// Positions are 16 bit, so any length the protocol allows is parsed. What is kept is up
+// to MaxPayload, a length over it is taken for a false sync (a 0xB5 0x62 in some payload)
+// and the search starts over, instead of swallowing up to 64k of the stream. Set it to
+// the longest message the receiver is configured to send.
+
+#ifndef UBXPARSER_H_INCLUDED
+#define UBXPARSER_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Packets.h"
+
+#define UBX_SYNC_1 0xB5
+#define UBX_SYNC_2 0x62
+
+#define UBX_CLASS_NAV   0x01
+#define UBX_CLASS_ACK   0x05
+#define UBX_CLASS_CFG   0x06
+#define UBX_CLASS_MON   0x0A
+
+#define UBX_NAV_PVT     0x07
+#define UBX_NAV_TIMEGPS 0x20
+#define UBX_NAV_SAT     0x35
+#define UBX_ACK_NAK     0x00
+#define UBX_ACK_ACK     0x01
+#define UBX_CFG_PRT     0x00
+#define UBX_CFG_MSG     0x01
+#define UBX_CFG_RATE    0x08
+#define UBX_CFG_GNSS    0x3E
+#define UBX_MON_VER     0x04
+
+#define UBX_MAX_HANDLERS 8
+
+struct UbxFrame {
+  uint8_t        cls;
+  uint8_t        id;
+  uint16_t       length;  // payload bytes
+  const uint8_t *payload;
+
+  // the frame as one of the Packets.h structs, they start with the header. nullptr if the
+  // payload is shorter than the struct's
+  template <typename Packet>
+  const Packet *as() const {
+    if (sizeof(commonHeader) + length < sizeof(Packet)) return nullptr;
+    return (const Packet *) (payload - sizeof(commonHeader));
+  }
+};
+
+typedef void (*UbxHandler)(const UbxFrame &frame, void *context);
+
+template <uint16_t MaxPayload>
+class UbxParser {
+
+public:
+
+  // frames of cls/id go to handler from now on, replacing the one they had. False if
+  // UBX_MAX_HANDLERS message types already have one
+  bool on(uint8_t cls, uint8_t id, UbxHandler handler, void *context = nullptr) {
+    for (uint8_t i = 0; i < handlerCount; i++) {
+      if (handlers[i].cls == cls && handlers[i].id == id) {
+        handlers[i].handler = handler;
+        handlers[i].context = context;
+        return true;
+      }
+    }
+    if (handlerCount == UBX_MAX_HANDLERS) return false;
+    handlers[handlerCount++] = {cls, id, handler, context};
+    return true;
+  }
+
+  void push(uint8_t b) { push(&b, 1); }
+
+  void push(const uint8_t *data, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+      if (state == PAYLOAD) {
+        // the bulk of the stream, a run at a time
+        size_t n = len - i;
+        if (n > (size_t) (length - pos)) n = length - pos;
+        uint8_t a = ckA, b = ckB;
+        uint8_t *out = frame + sizeof(commonHeader) + pos;
+        for (size_t k = 0; k < n; k++) {
+          uint8_t c = data[i + k];
+          out[k] = c;
+          a += c;
+          b += a;
+        }
+        ckA = a;
+        ckB = b;
+        pos += n;
+        i += n;
+        if (pos == length) state = CK_A;
+        continue;
+      }
+
+      uint8_t c = data[i++];
+      switch (state) {
+        case SYNC_1:
+          if (c == UBX_SYNC_1) state = SYNC_2;
+          break;
+        case SYNC_2:
+          if (c == UBX_SYNC_2) {
+            state = HEADER;
+            pos = 0;
+            ckA = ckB = 0;
+          } else if (c != UBX_SYNC_1) {
+            state = SYNC_1;
+          }
+          break;
+        case HEADER:
+          frame[pos++] = c;
+          ckA += c;
+          ckB += ckA;
+          if (pos == sizeof(commonHeader)) {
+            length = frame[2] | (frame[3] << 8);
+            pos = 0;
+            if (length > MaxPayload) {
+              oversize++;
+              state = SYNC_1;
+            } else {
+              state = length ? PAYLOAD : CK_A;
+            }
+          }
+          break;
+        case CK_A:
+          if (c == ckA) {
+            state = CK_B;
+          } else {
+            checksumErrors++;
+            state = c == UBX_SYNC_1 ? SYNC_2 : SYNC_1;
+          }
+          break;
+        case CK_B:
+          if (c == ckB) {
+            dispatch();
+            state = SYNC_1;
+          } else {
+            checksumErrors++;
+            state = c == UBX_SYNC_1 ? SYNC_2 : SYNC_1;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+  }
+
+  uint32_t getFrames()         const { return frames; }         // good frames, handled or not
+  uint32_t getUnhandled()      const { return unhandled; }      // good frames nobody registered for
+  uint32_t getChecksumErrors() const { return checksumErrors; }
+  uint32_t getOversize()       const { return oversize; }       // lengths over MaxPayload
+
+private:
+
+  enum State : uint8_t { SYNC_1, SYNC_2, HEADER, PAYLOAD, CK_A, CK_B };
+
+  struct Entry {
+    uint8_t    cls;
+    uint8_t    id;
+    UbxHandler handler;
+    void      *context;
+  };
+
+  void dispatch() {
+    frames++;
+    UbxFrame f = {frame[0], frame[1], length, frame + sizeof(commonHeader)};
+    for (uint8_t i = 0; i < handlerCount; i++) {
+      if (handlers[i].cls == f.cls && handlers[i].id == f.id) {
+        handlers[i].handler(f, handlers[i].context);
+        return;
+      }
+    }
+    unhandled++;
+  }
+
+  alignas(4) uint8_t frame[sizeof(commonHeader) + MaxPayload];
+  State    state  = SYNC_1;
+  uint16_t length = 0;
+  uint16_t pos    = 0;
+  uint8_t  ckA    = 0;
+  uint8_t  ckB    = 0;
+
+  Entry   handlers[UBX_MAX_HANDLERS];
+  uint8_t handlerCount = 0;
+
+  uint32_t frames         = 0;
+  uint32_t unhandled      = 0;
+  uint32_t checksumErrors = 0;
+  uint32_t oversize       = 0;
+
+};
+
+#endif
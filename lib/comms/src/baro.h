@@ -0,0 +1,73 @@
+// BMP390 compensation for raw baro logs (RAW_BARO), the ground side half
+//
+// With RAW_BARO the flight computer logs the BMP390's 24 bit ADC words and sends its NVM
+// calibration bytes once per file (baro_calib_p), instead of compensating every sample.
+// This turns them back into C and Pa with the same steps as the Bosch driver's double
+// precision compensation (bmp3.c, what performReading() runs), in the same order, so the
+// result is bit for bit what the flight computer would have logged. Keep it that way:
+// pow_bmp3() rounding through float is part of the result. A compiler that fuses
+// multiply-adds (-ffp-contract) changes the last bits, on both sides.
+
+#ifndef COMMS_BARO_H
+#define COMMS_BARO_H
+
+#include <stdint.h>
+#include "comms.h"
+
+// parse_calib_data() in bmp3.c, the coefficients scaled by their powers of two
+struct baro_calib {
+    double par_t1, par_t2, par_t3;
+    double par_p1, par_p2, par_p3, par_p4, par_p5, par_p6;
+    double par_p7, par_p8, par_p9, par_p10, par_p11;
+};
+
+inline baro_calib baroCalib(const unsigned char nvm[BARO_CALIB_LENGTH]) {
+    baro_calib c;
+    c.par_t1  = (double) (uint16_t) (nvm[1] << 8 | nvm[0]) / 0.00390625; // 2^-8
+    c.par_t2  = (double) (uint16_t) (nvm[3] << 8 | nvm[2]) / 1073741824.0; // 2^30
+    c.par_t3  = (double) (int8_t) nvm[4] / 281474976710656.0; // 2^48
+    c.par_p1  = (double) ((int16_t) (nvm[6] << 8 | nvm[5]) - 16384) / 1048576.0; // 2^20
+    c.par_p2  = (double) ((int16_t) (nvm[8] << 8 | nvm[7]) - 16384) / 536870912.0; // 2^29
+    c.par_p3  = (double) (int8_t) nvm[9] / 4294967296.0; // 2^32
+    c.par_p4  = (double) (int8_t) nvm[10] / 137438953472.0; // 2^37
+    c.par_p5  = (double) (uint16_t) (nvm[12] << 8 | nvm[11]) / 0.125; // 2^-3
+    c.par_p6  = (double) (uint16_t) (nvm[14] << 8 | nvm[13]) / 64.0; // 2^6
+    c.par_p7  = (double) (int8_t) nvm[15] / 256.0; // 2^8
+    c.par_p8  = (double) (int8_t) nvm[16] / 32768.0; // 2^15
+    c.par_p9  = (double) (int16_t) (nvm[18] << 8 | nvm[17]) / 281474976710656.0; // 2^48
+    c.par_p10 = (double) (int8_t) nvm[19] / 281474976710656.0; // 2^48
+    c.par_p11 = (double) (int8_t) nvm[20] / 36893488147419103232.0; // 2^65
+    return c;
+}
+
+// pow_bmp3(): a float running product, not pow()
+inline float baroPow(double base, uint8_t power) {
+    float out = 1;
+    while (power--) out = (float) base * out;
+    return out;
+}
+
+// compensate_temperature() and compensate_pressure(), temp in C and pres in Pa
+inline void baroCompensate(const baro_calib &c, uint32_t raw_temp, uint32_t raw_pres, double &temp, double &pres) {
+    double d1 = (double) (raw_temp - c.par_t1);
+    double d2 = (double) (d1 * c.par_t2);
+    double t_lin = d2 + (d1 * d1) * c.par_t3;
+
+    double p1 = c.par_p6 * t_lin;
+    double p2 = c.par_p7 * baroPow(t_lin, 2);
+    double p3 = c.par_p8 * baroPow(t_lin, 3);
+    double out1 = c.par_p5 + p1 + p2 + p3;
+    p1 = c.par_p2 * t_lin;
+    p2 = c.par_p3 * baroPow(t_lin, 2);
+    p3 = c.par_p4 * baroPow(t_lin, 3);
+    double out2 = raw_pres * (c.par_p1 + p1 + p2 + p3);
+    p1 = baroPow((double) raw_pres, 2);
+    p2 = c.par_p9 + c.par_p10 * t_lin;
+    p3 = p1 * p2;
+    double p4 = p3 + baroPow((double) raw_pres, 3) * c.par_p11;
+
+    temp = t_lin;
+    pres = out1 + out2 + p4;
+}
+
+#endif
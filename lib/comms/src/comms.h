@@ -2,6 +2,11 @@
 #ifndef COMMS_H
 #define COMMS_H
 
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "crc16.h"
+
 #define HEADER_LENGTH    4
 #define SYNC             0xAA
 
@@ -10,43 +15,50 @@
 #define TYPE_GPS         0xCA
 #define TYPE_COMMAND     0xA5
 #define TYPE_POOP        0x33
+#define TYPE_IMU_BATCH   0x1B
+#define TYPE_HIGHG_BATCH 0x2B
+#define TYPE_BARO_BATCH  0x3B
+#define TYPE_BARO_CALIB  0x3C
+#define TYPE_ICM_BATCH   0x4B
+#define TYPE_TIMESYNC    0x5C
+#define TYPE_PROFILE     0x9F
+
+// max samples carried by one batch packet
+#define BATCH_MAX_SAMPLES 32
+
+// bytes of BMP390 calibration coefficients in baro_calib_p
+#define BARO_CALIB_LENGTH 21
+
+// stages timed by the loop profiler (DEBUG_MODE_DATARATE), index into profile_p's stages
+#define PROFILE_RECONNECT     0
+#define PROFILE_COLLECT_ICM   1
+#define PROFILE_COLLECT_LSM   2
+#define PROFILE_COLLECT_BMP   3
+#define PROFILE_COLLECT_ADXL  4
+#define PROFILE_COLLECT_GPS   5
+#define PROFILE_STATUS_ICM    6
+#define PROFILE_STATUS_LSM    7
+#define PROFILE_STATUS_BMP    8
+#define PROFILE_STATUS_ADXL   9
+#define PROFILE_SAVE          10 // saveData(), or one flushSD() on the storage thread
+#define PROFILE_TRANSMIT      11
+#define PROFILE_LOG           12 // storage thread, encoding one queued packet into the log buffer
+#define PROFILE_NUM_STAGES    13
+#define PROFILE_BUCKETS       16 // log2 histogram, see profile_stage
 
 // commands for command_p
 #define START_COMMAND    0x6D656F77 // DANGER, DO NOT CONVERT THIS TO ASCII!!! YOU WILL REGRET
 #define STOP_COMMAND     0x6D696175 // or this one!!!
 
-const uint16_t crc16_lookup_table[256] = { 
-        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7, 0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
-        0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6, 0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
-        0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485, 0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
-        0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4, 0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
-        0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823, 0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
-        0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12, 0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
-        0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41, 0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
-        0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70, 0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
-        0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F, 0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
-        0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E, 0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
-        0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D, 0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
-        0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C, 0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
-        0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB, 0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
-        0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A, 0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
-        0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9, 0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
-        0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8, 0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
-};
-
-//switch to crc 16 ccitt false
-#define CHECKSUM(p) \
+// CHECKSUM_N only covers the first n bytes of the packet, for variable length packets
+#define CHECKSUM_N(p, n) \
     { \
-        unsigned char *payload = (unsigned char *) &p;                 \
-        memset(payload + 2, 0xFF, 2); \
-        uint16_t crc = 0xFFFF;\
-        for (unsigned int i = HEADER_LENGTH; i < sizeof(p); i++) {  \
-            crc = (crc << 8) ^ crc16_lookup_table[(crc >> 8) ^ payload[i]];\
-            crc &= 0xFFFF;\
-        }\
-        p.crc_16_ccitt_false = crc;\
+        p.crc_16_ccitt_false = crc16((const unsigned char *) &p + HEADER_LENGTH, (n) - HEADER_LENGTH); \
     }
 
+#define CHECKSUM(p) CHECKSUM_N(p, sizeof(p))
+#define BATCH_CHECKSUM(p) CHECKSUM_N(p, batchLength(p))
+
 typedef unsigned char packet_t;
 
 // Header common to all packet types
@@ -65,10 +77,15 @@ struct packet_base {
 // Sensor packet includes IMU data, altimeter data
 // if you make changes to this struct, they should respect packed alignment
 // if packing is impossible, make sure to explicitly specify the padding in the struct to its straightfoward to interpret on the Python end
+// Times are the flight computer's 64 bit us clock since start, split in two 32 bit halves.
+// Every sensor field group has its own sample time, given as its age: how many us before
+// 'us' (when the packet was put together) that sensor was sampled. An age of 0xFFFF means
+// 65 ms or more, i.e. no fresh sample (the sensor is missing or hasn't been read yet)
 struct sensor_p : public packet_base {
 
     struct {
-        uint32_t      us;   
+        uint32_t      us;
+        uint32_t      us_hi;
         int16_t       acc_x;
         int16_t       acc_y;
         int16_t       acc_z;
@@ -78,11 +95,15 @@ struct sensor_p : public packet_base {
         float         mag_x;
         float         mag_y;
         float         mag_z;
-        float         temp;
-        float         pres;
+        float         temp;     // with RAW_BARO_FLAG in status, the 24 bit temp ADC word (uint32_t)
+        float         pres;     // with RAW_BARO_FLAG in status, the 24 bit pres ADC word (uint32_t)
         int16_t       adxl_acc_x;
         int16_t       adxl_acc_y;
         int16_t       adxl_acc_z;
+        uint16_t      lsm_age;  // acc, gyr
+        uint16_t      icm_age;  // mag
+        uint16_t      bmp_age;  // temp, pres
+        uint16_t      adxl_age; // adxl_acc
         unsigned char status;
         unsigned char reserved;
     } data;
@@ -91,10 +112,14 @@ struct sensor_p : public packet_base {
 
 };
 
+static_assert(sizeof(sensor_p) == 60, "sensor_p is sent as is, it can't have padding");
+
+// us is when the NAV-PVT frame was received
 struct gps_p : public packet_base {
 
     struct {
         uint32_t      us;
+        uint32_t      us_hi;
         int32_t       lat;
         int32_t       lon;
         int32_t       alt;
@@ -117,6 +142,57 @@ struct gps_p : public packet_base {
 
 };
 
+static_assert(sizeof(gps_p) == 60, "gps_p is sent as is, it can't have padding");
+
+// sensor_p status bit: temp and pres are the BMP390's raw ADC words, compensate them with the
+// last baro_calib_p (see baro.h)
+#define RAW_BARO_FLAG 0x40
+
+// The BMP390's calibration coefficients, the bytes of its NVM registers 0x31-0x45 as they are.
+// Sent at the start of every log file when sensor packets carry raw baro words
+struct baro_calib_p : public packet_base {
+
+    struct {
+        unsigned char nvm[BARO_CALIB_LENGTH];
+        unsigned char reserved[3];
+    } data;
+
+    baro_calib_p() : packet_base(TYPE_BARO_CALIB), data{} {}
+
+};
+
+static_assert(sizeof(baro_calib_p) == 28, "baro_calib_p is sent as is, it can't have padding");
+
+// timesync_p flags
+#define TIMESYNC_LOCKED 0x01 // drift_ppb is measured, before that it is 0
+#define TIMESYNC_PPS    0x02 // from PPS edges, otherwise NAV-PVT epochs (off by the receiver's latency)
+#define TIMESYNC_LEAP   0x04 // leap_s is valid
+
+// GPS time at 'us' on the flight computer's clock, and how fast that clock runs off GPS
+// time. Sent about once a second while the GPS has time, every packet's us maps to GPS time
+// with the last one before it:
+//   gps ns = (week * 604800000 + tow_ms) * 1000000 + tow_ns + (t - us) * (1000 - drift_ppb / 1e6)
+// UTC is that minus leap_s
+struct timesync_p : public packet_base {
+
+    struct {
+        uint32_t      us;
+        uint32_t      us_hi;
+        uint32_t      tow_ms;    // GPS time of week
+        int32_t       tow_ns;    // plus this, 0 to 999999
+        int32_t       drift_ppb; // ns our clock gains per s of GPS time
+        uint32_t      spread_ns; // how far apart the observations the fit is made from were
+        uint16_t      week;      // GPS week, not rolled over at 1024
+        int8_t        leap_s;    // GPS - UTC
+        unsigned char flags;
+    } data;
+
+    timesync_p() : packet_base(TYPE_TIMESYNC), data{} {}
+
+};
+
+static_assert(sizeof(timesync_p) == 32, "timesync_p is sent as is, it can't have padding");
+
 struct command_p : public packet_base {
     
     struct {
@@ -126,6 +202,175 @@ struct command_p : public packet_base {
     command_p() : packet_base(TYPE_COMMAND), data{} {}
 };
 
+// Timing of one profiled stage over a profile window, in ticks of the clock in profile_p.
+// hist[0] counts runs under 2^5 ticks, hist[i] runs in [2^(i+4), 2^(i+5)), the last bucket
+// everything from 2^19 up. Counts saturate at 65535
+struct profile_stage {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t mean;
+    uint16_t hist[PROFILE_BUCKETS];
+};
+
+// Sent every PROFILE_INTERVAL_MS with DEBUG_MODE_DATARATE, by each thread that runs profiled stages.
+// Stages the thread doesn't run have a count of 0
+struct profile_p : public packet_base {
+
+    struct {
+        uint32_t      us;       // end of the window
+        uint32_t      clock_hz; // profile tick rate, the CPU clock on the Teensy (DWT cycle counter)
+        unsigned char source;   // 0 sampling loop, 1 storage thread
+        unsigned char reserved;
+        uint16_t      batch_drops; // batched samples dropped in the window, no free batch buffer (sampling loop, saturates)
+        profile_stage stages[PROFILE_NUM_STAGES];
+    } data;
+
+    profile_p() : packet_base(TYPE_PROFILE), data{} {}
+
+};
+
+// Batch packets carry many samples of one sensor under a single header, base timestamp and CRC.
+// Only the first 'count' samples go on the wire, so the length is variable: use batchLength()
+// instead of sizeof(), and BATCH_CHECKSUM() instead of CHECKSUM().
+// Each sample stores its time as the offset in us from the previous sample (0 for the first one),
+// so samples can be at most ~65 ms apart.
+struct imu_sample {
+    uint16_t dt;
+    int16_t  acc_x;
+    int16_t  acc_y;
+    int16_t  acc_z;
+    int16_t  gyr_x;
+    int16_t  gyr_y;
+    int16_t  gyr_z;
+};
+
+struct highg_sample {
+    uint16_t dt;
+    int16_t  acc_x;
+    int16_t  acc_y;
+    int16_t  acc_z;
+};
+
+// One ICM-20948 DMP output, kind says which (ICM_SAMPLE_*). Kinds are mixed in one batch, in
+// the order the DMP put them out, several can share a time (dt 0)
+#define ICM_SAMPLE_QUAT 0 // game rotation vector, v = w, x, y, z in Q14 (16384 is 1)
+#define ICM_SAMPLE_GYRO 1 // raw gyro, v = x, y, z, 0 at 16.4 LSB/dps (2000 dps full scale)
+#define ICM_SAMPLE_ACC  2 // raw acc, v = x, y, z, 0 at 2048 LSB/g (16 g full scale)
+
+struct icm_sample {
+    uint16_t      dt;
+    unsigned char kind;
+    unsigned char reserved;
+    int16_t       v[4];
+};
+
+// floats as bytes: a float member would make it 4 byte aligned, and pad the batch header
+struct baro_sample {
+    uint16_t      dt;
+    unsigned char temp[4]; // float, C
+    unsigned char pres[4]; // float, Pa
+};
+
+template <typename Sample, packet_t Type>
+struct batch_p : public packet_base {
+
+    struct {
+        uint32_t      us;    // time of the first sample, low 32 bits
+        unsigned char count; // number of samples that follow
+        unsigned char us_hi; // bits 32-39 of the time of the first sample (12.7 days)
+        Sample        samples[BATCH_MAX_SAMPLES];
+    } data;
+
+    uint32_t last_us; // time of the last sample, not sent
+
+    batch_p() : packet_base(Type), data{}, last_us(0) {}
+
+};
+
+typedef batch_p<imu_sample, TYPE_IMU_BATCH>     imu_batch_p;   // LSM6DSO32 raw acc + gyr
+typedef batch_p<highg_sample, TYPE_HIGHG_BATCH> highg_batch_p; // ADXL375 raw acc
+typedef batch_p<baro_sample, TYPE_BARO_BATCH>   baro_batch_p;  // BMP390 FIFO frames
+typedef batch_p<icm_sample, TYPE_ICM_BATCH>     icm_batch_p;   // ICM-20948 DMP quaternions, raw gyr + acc
+
+static_assert(alignof(baro_sample) == 2, "batch headers are 6 bytes on the wire, see packetLength()");
+
+// bytes on the wire before the first sample
+template <typename Batch>
+inline size_t batchHeaderLength(const Batch &p) {
+    return (const unsigned char *) &p.data.samples - (const unsigned char *) &p;
+}
+
+// bytes on the wire for the whole batch
+template <typename Batch>
+inline size_t batchLength(const Batch &p) {
+    return batchHeaderLength(p) + p.data.count * sizeof(p.data.samples[0]);
+}
+
+// Append a sample taken at time us (dt is filled in here). Returns false if it doesn't fit,
+// either because the batch is full or because us is too far from the previous sample. Send the
+// batch, batchReset() it, and add the sample again
+template <typename Batch, typename Sample>
+inline bool batchAdd(Batch &p, uint64_t us, Sample s) {
+    if (p.data.count == 0) {
+        p.data.us    = p.last_us = (uint32_t) us;
+        p.data.us_hi = us >> 32;
+    }
+    uint32_t dt = (uint32_t) us - p.last_us;
+    if (p.data.count >= BATCH_MAX_SAMPLES || dt > 0xFFFF) return false;
+    s.dt = (uint16_t) dt;
+    p.last_us = us;
+    p.data.samples[p.data.count++] = s;
+    return true;
+}
+
+template <typename Batch>
+inline void batchReset(Batch &p) { p.data.count = 0; }
+
+// absolute time of sample i
+template <typename Batch>
+inline uint64_t batchSampleTime(const Batch &p, unsigned int i) {
+    uint64_t us = ((uint64_t) p.data.us_hi << 32) | p.data.us;
+    for (unsigned int j = 1; j <= i; j++) us += p.data.samples[j].dt;
+    return us;
+}
+
+// Decode a batch from raw bytes (as read from a file or serial), starting at the sync byte.
+// Returns the number of bytes consumed, or 0 if the bytes are not a complete, valid batch of this type
+template <typename Batch>
+inline size_t batchDecode(const unsigned char *buf, size_t len, Batch &p) {
+    size_t header = batchHeaderLength(p);
+    if (len < header || buf[0] != SYNC || buf[1] != p.type) return 0;
+    unsigned char count = buf[header - 2];
+    if (count > BATCH_MAX_SAMPLES) return 0;
+    size_t total = header + count * sizeof(p.data.samples[0]);
+    if (len < total) return 0;
+    uint16_t received_crc = buf[2] | (buf[3] << 8);
+    memcpy(&p.data, buf + HEADER_LENGTH, total - HEADER_LENGTH);
+    BATCH_CHECKSUM(p)
+    return p.crc_16_ccitt_false == received_crc ? total : 0;
+}
+
+// Length of the packet starting at buf[0], read from its type (and count, for batches).
+// Returns 0 if the type is unknown or len is too short to tell
+inline size_t packetLength(const unsigned char *buf, size_t len) {
+    const size_t batch_header = HEADER_LENGTH + 6; // us, count, reserved
+    if (len < 2 || buf[0] != SYNC) return 0;
+    switch (buf[1]) {
+        case TYPE_SENSOR:      return sizeof(sensor_p);
+        case TYPE_GPS:         return sizeof(gps_p);
+        case TYPE_COMMAND:     return sizeof(command_p);
+        case TYPE_PROFILE:     return sizeof(profile_p);
+        case TYPE_BARO_CALIB:  return sizeof(baro_calib_p);
+        case TYPE_TIMESYNC:    return sizeof(timesync_p);
+        case TYPE_IMU_BATCH:   return len < batch_header ? 0 : batch_header + buf[batch_header - 2] * sizeof(imu_sample);
+        case TYPE_HIGHG_BATCH: return len < batch_header ? 0 : batch_header + buf[batch_header - 2] * sizeof(highg_sample);
+        case TYPE_BARO_BATCH:  return len < batch_header ? 0 : batch_header + buf[batch_header - 2] * sizeof(baro_sample);
+        case TYPE_ICM_BATCH:   return len < batch_header ? 0 : batch_header + buf[batch_header - 2] * sizeof(icm_sample);
+        default:               return 0;
+    }
+}
+
 // this assumes the packet passed in is initialized with correct type, i.e. correct size
 // templated to use any packet type an either usb or harware serial
 // TURN THIS INTO MACRO, ALSO CONSIDER PACKET POINTER TYPE OOPSIE
@@ -137,7 +382,8 @@ struct command_p : public packet_base {
         serial.read() != SYNC || \
         serial.read() != p.type) result = false; \
     else { \
-        uint16_t received_crc = (serial.read() & 0xFF) | (serial.read() << 8); \
+        uint16_t received_crc = serial.read() & 0xFF; /* two statements, the order of reads in one expression is unspecified */ \
+        received_crc |= serial.read() << 8; \
         unsigned char *buffer = reinterpret_cast<unsigned char *>(&p); \
         for (int i = HEADER_LENGTH; i < packet_size; i++) buffer[i] = serial.read(); \
         CHECKSUM(p) \
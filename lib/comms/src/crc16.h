@@ -0,0 +1,75 @@
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF, no reflection, no final xor)
+//
+// Slice-by-8: table[k] is the crc contribution of a byte followed by k zero bytes, so
+// 8 bytes are folded in with 8 independent lookups and xors instead of a chain of 8
+// dependent ones. The tables are generated at compile time, the crc of one byte through
+// table[0] is the same as the old byte-at-a-time lookup, so results are bit exact.
+//
+// crc16_update() can be called on consecutive chunks, crc16() is the whole thing at once:
+//   crc16(a+b) == crc16_update(crc16_update(CRC16_INIT, a), b)
+
+#ifndef COMMS_CRC16_H
+#define COMMS_CRC16_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define CRC16_POLY  0x1021
+#define CRC16_INIT  0xFFFF
+#define CRC16_SLICE 8
+
+struct crc16_tables {
+
+    uint16_t table[CRC16_SLICE][256];
+
+    constexpr crc16_tables() : table{} {
+        for (int b = 0; b < 256; b++) {
+            uint16_t crc = b << 8;
+            for (int bit = 0; bit < 8; bit++) crc = (crc & 0x8000) ? (crc << 1) ^ CRC16_POLY : crc << 1;
+            table[0][b] = crc;
+        }
+        for (int k = 1; k < CRC16_SLICE; k++)
+            for (int b = 0; b < 256; b++)
+                table[k][b] = (table[k - 1][b] << 8) ^ table[0][table[k - 1][b] >> 8];
+    }
+
+};
+
+// templated so the tables can be defined in a header and still only exist once in the binary
+template <int = 0>
+struct crc16_engine {
+
+    static constexpr crc16_tables tables{};
+
+    static uint16_t update(uint16_t crc, const unsigned char *data, size_t len) {
+        const uint16_t (*t)[256] = tables.table;
+        while (len >= CRC16_SLICE) {
+            crc = t[7][data[0] ^ (crc >> 8)] ^ t[6][data[1] ^ (crc & 0xFF)] ^
+                  t[5][data[2]] ^ t[4][data[3]] ^ t[3][data[4]] ^
+                  t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+            data += CRC16_SLICE;
+            len  -= CRC16_SLICE;
+        }
+        while (len--) crc = (crc << 8) ^ t[0][(crc >> 8) ^ *data++];
+        return crc;
+    }
+
+};
+
+template <int N>
+constexpr crc16_tables crc16_engine<N>::tables;
+
+static_assert(crc16_engine<>::tables.table[0][1] == 0x1021 && crc16_engine<>::tables.table[0][255] == 0x1EF0,
+              "crc16 table doesn't match CRC-16/CCITT-FALSE");
+
+// continue a crc over more bytes, start from CRC16_INIT
+inline uint16_t crc16_update(uint16_t crc, const void *data, size_t len) {
+    return crc16_engine<>::update(crc, (const unsigned char *) data, len);
+}
+
+inline uint16_t crc16(const void *data, size_t len) {
+    return crc16_update(CRC16_INIT, data, len);
+}
+
+#endif
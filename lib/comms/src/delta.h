@@ -0,0 +1,234 @@
+// Lossless delta compression for the log stream
+//
+// Back to back sensor/gps packets only differ by a few LSBs in most fields, so most of
+// the 48/56 bytes we write per packet are redundant. The encoder keeps the last packet of
+// each type and writes a delta frame instead of the packet:
+//
+//   sync | TYPE_DELTA | crc of the packet it decodes to | packet type | length | fields...
+//
+// Every field is stored as the zig-zag encoded difference to the same field of the last
+// packet, as a varint (7 bits per byte), so an unchanged field costs one byte. Floats are
+// delta'd on their bit pattern, which is still exact. The crc in the header is the crc
+// the original packet had, so the decoder checks the packet it rebuilt, not just the frame.
+//
+// Every DELTA_KEYFRAME_INTERVAL packets (and whenever a delta would not be smaller) the
+// plain packet is written instead, so a corrupted sector only loses the frames up to the
+// next keyframe, and tools that don't know about delta frames can still read keyframes.
+// Packet types without a layout below (commands, batches) pass through untouched.
+
+#ifndef COMMS_DELTA_H
+#define COMMS_DELTA_H
+
+#include "comms.h"
+
+#define TYPE_DELTA              0x0D
+#define DELTA_HEADER_LENGTH     (HEADER_LENGTH + 2)
+#define DELTA_KEYFRAME_INTERVAL 64
+#define DELTA_MAX_FIELDS        24
+#define DELTA_MAX_PACKET        64 // biggest packet with a layout, and the biggest frame
+
+// Field widths (bytes) of a packet's data, in order. Must match the structs in comms.h
+struct delta_layout {
+    packet_t      type;
+    unsigned char size;   // sizeof the packet
+    unsigned char fields;
+    unsigned char width[DELTA_MAX_FIELDS];
+};
+
+static const delta_layout delta_layouts[] = {
+    // us, us_hi, acc[3], gyr[3], mag[3], temp, pres, adxl[3], ages[4], status, reserved
+    { TYPE_SENSOR, sizeof(sensor_p), 22, {4, 4, 2,2,2, 2,2,2, 4,4,4, 4, 4, 2,2,2, 2,2,2,2, 1, 1} },
+    // us, us_hi, lat, lon, alt, vel[3], eph, epv, sacc, gspeed, pdop, nsats, fix_type, valid, flags
+    { TYPE_GPS,    sizeof(gps_p),    17, {4, 4, 4,4,4, 4,4,4, 4,4,4, 4, 4, 1,1,1,1} },
+};
+
+#define DELTA_NUM_LAYOUTS (sizeof(delta_layouts) / sizeof(delta_layouts[0]))
+
+static_assert(sizeof(sensor_p) <= DELTA_MAX_PACKET && sizeof(gps_p) <= DELTA_MAX_PACKET, "raise DELTA_MAX_PACKET");
+
+// shared between the encoder and decoder, the last packet seen of each layout
+class DeltaState {
+
+  public:
+
+    // forget everything, the next packet of each type is a keyframe
+    void reset() {
+      for (unsigned int i = 0; i < DELTA_NUM_LAYOUTS; i++) {
+        valid[i] = false;
+        since_key[i] = 0;
+      }
+    }
+
+  protected:
+
+    DeltaState() { reset(); }
+
+    static int layoutIndex(packet_t type) {
+      for (unsigned int i = 0; i < DELTA_NUM_LAYOUTS; i++)
+        if (delta_layouts[i].type == type) return i;
+      return -1;
+    }
+
+    static uint32_t readField(const unsigned char *p, unsigned char width) {
+      uint32_t v = 0;
+      for (unsigned char i = 0; i < width; i++) v |= (uint32_t) p[i] << (8 * i);
+      return v;
+    }
+
+    static void writeField(unsigned char *p, unsigned char width, uint32_t v) {
+      for (unsigned char i = 0; i < width; i++) p[i] = v >> (8 * i);
+    }
+
+    // difference of two fields, sign extended from the field width
+    static int32_t fieldDelta(uint32_t cur, uint32_t prev, unsigned char width) {
+      uint32_t d = cur - prev;
+      if (width == 1) return (int8_t) d;
+      if (width == 2) return (int16_t) d;
+      return (int32_t) d;
+    }
+
+    unsigned char prev[DELTA_NUM_LAYOUTS][DELTA_MAX_PACKET];
+    bool          valid[DELTA_NUM_LAYOUTS];
+    uint16_t      since_key[DELTA_NUM_LAYOUTS];
+
+};
+
+class DeltaEncoder : public DeltaState {
+
+  public:
+
+    // Encode a packet (checksum already computed) into out, which must hold
+    // DELTA_MAX_PACKET bytes. Returns the number of bytes to write
+    template <typename Packet>
+    size_t encode(const Packet &p, unsigned char *out) {
+      return encode((const unsigned char *) &p, sizeof(p), out);
+    }
+
+    size_t encode(const unsigned char *raw, size_t len, unsigned char *out) {
+
+      int l = layoutIndex(raw[1]);
+      if (l < 0 || len != delta_layouts[l].size) {
+        memcpy(out, raw, len);
+        return len;
+      }
+
+      const delta_layout &layout = delta_layouts[l];
+      size_t n = 0;
+
+      if (valid[l] && since_key[l] < DELTA_KEYFRAME_INTERVAL) {
+        out[0] = SYNC;
+        out[1] = TYPE_DELTA;
+        out[2] = raw[2]; // crc of the packet we encode
+        out[3] = raw[3];
+        out[4] = raw[1];
+        n = DELTA_HEADER_LENGTH;
+        const unsigned char *cur = raw + HEADER_LENGTH, *last = prev[l] + HEADER_LENGTH;
+        for (unsigned char f = 0; f < layout.fields && n < len; f++) {
+          unsigned char w = layout.width[f];
+          int32_t d = fieldDelta(readField(cur, w), readField(last, w), w);
+          uint32_t z = ((uint32_t) d << 1) ^ (uint32_t) (d >> 31);
+          do {
+            out[n++] = (z & 0x7F) | (z > 0x7F ? 0x80 : 0);
+            z >>= 7;
+          } while (z && n < len);
+          cur += w;
+          last += w;
+        }
+        out[5] = n - DELTA_HEADER_LENGTH;
+        since_key[l]++;
+      }
+
+      // no reference yet, keyframe due, or the delta didn't pay off
+      if (n == 0 || n >= len) {
+        memcpy(out, raw, len);
+        n = len;
+        since_key[l] = 0;
+      }
+
+      memcpy(prev[l], raw, len);
+      valid[l] = true;
+      return n;
+
+    }
+
+};
+
+class DeltaDecoder : public DeltaState {
+
+  public:
+
+    // Decode the frame starting at buf[0]. Returns the number of bytes consumed, 0 if buf
+    // doesn't start with a complete frame we know (skip a byte and try again). If the frame
+    // decodes to a good packet it is copied to out and out_len is set, otherwise out_len is 0.
+    // Plain packets of any type are passed through as they are, so out has to fit the biggest
+    // packet in the log (sizeof(imu_batch_p) if it has batches)
+    size_t decode(const unsigned char *buf, size_t len, unsigned char *out, size_t &out_len) {
+
+      out_len = 0;
+      if (len < HEADER_LENGTH || buf[0] != SYNC) return 0;
+
+      if (buf[1] != TYPE_DELTA) {
+        size_t n = packetLength(buf, len);
+        if (n == 0 || n > len) return 0;
+        uint16_t crc = buf[2] | (buf[3] << 8);
+        int l = layoutIndex(buf[1]);
+        if (crc16(buf + HEADER_LENGTH, n - HEADER_LENGTH) != crc) {
+          if (l >= 0) valid[l] = false;
+          return n;
+        }
+        if (l >= 0) {
+          memcpy(prev[l], buf, n);
+          valid[l] = true;
+        }
+        memcpy(out, buf, n);
+        out_len = n;
+        return n;
+      }
+
+      if (len < DELTA_HEADER_LENGTH) return 0;
+      int l = layoutIndex(buf[4]);
+      size_t n = DELTA_HEADER_LENGTH + buf[5];
+      if (l < 0 || n > len) return 0;
+
+      // nothing to apply the delta to, wait for the next keyframe
+      if (!valid[l]) return n;
+
+      const delta_layout &layout = delta_layouts[l];
+      unsigned char packet[DELTA_MAX_PACKET];
+      memcpy(packet, prev[l], layout.size);
+      packet[2] = buf[2];
+      packet[3] = buf[3];
+
+      size_t i = DELTA_HEADER_LENGTH;
+      unsigned char *field = packet + HEADER_LENGTH;
+      for (unsigned char f = 0; f < layout.fields; f++) {
+        uint32_t z = 0;
+        unsigned char shift = 0, byte;
+        do {
+          if (i >= n || shift > 28) { valid[l] = false; return n; }
+          byte = buf[i++];
+          z |= (uint32_t) (byte & 0x7F) << shift;
+          shift += 7;
+        } while (byte & 0x80);
+        int32_t d = (int32_t) (z >> 1) ^ -(int32_t) (z & 1);
+        unsigned char w = layout.width[f];
+        writeField(field, w, readField(field, w) + (uint32_t) d);
+        field += w;
+      }
+
+      uint16_t crc = buf[2] | (buf[3] << 8);
+      if (i != n || crc16(packet + HEADER_LENGTH, layout.size - HEADER_LENGTH) != crc) {
+        valid[l] = false;
+        return n;
+      }
+
+      memcpy(prev[l], packet, layout.size);
+      memcpy(out, packet, layout.size);
+      out_len = layout.size;
+      return n;
+
+    }
+
+};
+
+#endif
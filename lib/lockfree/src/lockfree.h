@@ -0,0 +1,309 @@
+// Lock-free queues for handing data between ISRs, threads and the main loop
+//
+// None of these ever mask interrupts or take a lock, so an ISR that pushes can never be
+// delayed by the other side, and the other side never adds jitter to any ISR. Everything
+// is sized at compile time and only depends on <atomic>, so the same code runs on the
+// Teensy and on the host with std::thread.
+//
+//   SpscQueue<T, N>    one producer, one consumer, typed items, filled/drained in place
+//   MpscQueue<T, N>    any number of producers (several ISRs, an ISR and a thread), one consumer
+//   SpscByteQueue<N>   one producer, one consumer, variable length byte records (packets of
+//                      different sizes without every slot being as big as the biggest one)
+//
+// A full queue drops the item and counts it instead of waiting. N must be a power of two.
+//
+// On the Cortex-M7 loads and stores of aligned 32 bit words are atomic on their own, and the
+// compare-exchange in MpscQueue is LDREX/STREX, which an interrupt can't tear.
+
+#ifndef LOCKFREE_H
+#define LOCKFREE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+
+/*******************************************************************************
+* SpscQueue
+*
+*   The producer only writes head, the consumer only writes tail. Both are free
+*   running counters, only their difference matters.
+*
+*******************************************************************************/
+template <typename T, uint32_t N>
+class SpscQueue {
+
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "queue depth must be a power of two");
+
+  public:
+
+    // producer side. Slot to fill, or nullptr if the queue is full (counted as a drop)
+    T *reserve() {
+      uint32_t h = head.load(std::memory_order_relaxed);
+      if (h - tail.load(std::memory_order_acquire) >= N) {
+        drops++;
+        return nullptr;
+      }
+      return &slots[h & (N - 1)];
+    }
+
+    // producer side. Make the slot from the last reserve() visible to the consumer
+    void publish() {
+      uint32_t h = head.load(std::memory_order_relaxed) + 1;
+      head.store(h, std::memory_order_release);
+      uint32_t depth = h - tail.load(std::memory_order_relaxed);
+      if (depth > max_depth) max_depth = depth;
+    }
+
+    bool push(const T &item) {
+      T *slot = reserve();
+      if (!slot) return false;
+      *slot = item;
+      publish();
+      return true;
+    }
+
+    // consumer side. Oldest item, or nullptr if the queue is empty
+    T *front() {
+      uint32_t t = tail.load(std::memory_order_relaxed);
+      if (t == head.load(std::memory_order_acquire)) return nullptr;
+      return &slots[t & (N - 1)];
+    }
+
+    // consumer side. Done with the item from front(), its slot can be reused
+    void pop() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    bool pop(T &item) {
+      T *slot = front();
+      if (!slot) return false;
+      item = *slot;
+      pop();
+      return true;
+    }
+
+    // items waiting, exact from either side, a snapshot from anywhere else
+    uint32_t size() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+
+    uint32_t capacity()     const { return N; }
+    uint32_t getDropCount() const { return drops; }     // producer side counter
+    uint32_t getMaxDepth()  const { return max_depth; } // producer side counter
+
+  private:
+
+    T slots[N];
+
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+
+    uint32_t drops     = 0;
+    uint32_t max_depth = 0;
+
+};
+
+/*******************************************************************************
+* MpscQueue
+*
+*   Every slot carries a sequence number saying whose turn it is: pos means free
+*   for the producer claiming position pos, pos + 1 means filled and waiting for
+*   the consumer, pos + N means free again for the next lap. Producers claim a
+*   position with a compare-exchange on head, so a producer interrupted by another
+*   one (an ISR on top of a thread) just ends up one slot further. The consumer
+*   only sees slots in order, a slot claimed but not yet filled holds up the ones
+*   behind it until its producer finishes.
+*
+*******************************************************************************/
+template <typename T, uint32_t N>
+class MpscQueue {
+
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "queue depth must be a power of two");
+
+  public:
+
+    MpscQueue() {
+      for (uint32_t i = 0; i < N; i++) slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // any producer. False if the queue is full (counted as a drop)
+    bool push(const T &item) {
+      uint32_t pos = head.load(std::memory_order_relaxed);
+      for (;;) {
+        Slot &s = slots[pos & (N - 1)];
+        int32_t diff = (int32_t) (s.seq.load(std::memory_order_acquire) - pos);
+        if (diff == 0) {
+          if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+            s.item = item;
+            s.seq.store(pos + 1, std::memory_order_release);
+            return true;
+          }
+          // lost the race, pos now holds the current head, try again
+        } else if (diff < 0) {
+          drops.fetch_add(1, std::memory_order_relaxed);
+          return false;
+        } else {
+          pos = head.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    // consumer side. Oldest finished item, or nullptr if there is none (yet)
+    T *front() {
+      uint32_t t = tail.load(std::memory_order_relaxed);
+      Slot &s = slots[t & (N - 1)];
+      if (s.seq.load(std::memory_order_acquire) != t + 1) return nullptr;
+      return &s.item;
+    }
+
+    // consumer side. Done with the item from front()
+    void pop() {
+      uint32_t t = tail.load(std::memory_order_relaxed);
+      slots[t & (N - 1)].seq.store(t + N, std::memory_order_release);
+      tail.store(t + 1, std::memory_order_relaxed);
+    }
+
+    bool pop(T &item) {
+      T *slot = front();
+      if (!slot) return false;
+      item = *slot;
+      pop();
+      return true;
+    }
+
+    // claimed positions not consumed yet, a snapshot
+    uint32_t size() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed); }
+
+    uint32_t capacity()     const { return N; }
+    uint32_t getDropCount() const { return drops.load(std::memory_order_relaxed); }
+
+  private:
+
+    struct Slot {
+      std::atomic<uint32_t> seq;
+      T item;
+    };
+
+    Slot slots[N];
+
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0}; // only written by the consumer
+
+    std::atomic<uint32_t> drops{0};
+
+};
+
+/*******************************************************************************
+* SpscByteQueue
+*
+*   Variable length records in one byte ring of N bytes. Each record is a 4 byte
+*   length followed by its bytes, padded to 4 bytes so lengths stay aligned.
+*   Records are always contiguous: when one doesn't fit before the end of the
+*   ring, a wrap marker is written and the record starts over at offset 0, so
+*   both sides always deal with one plain pointer.
+*
+*******************************************************************************/
+template <uint32_t N>
+class SpscByteQueue {
+
+  static_assert(N >= 16 && (N & (N - 1)) == 0, "queue size must be a power of two");
+
+  public:
+
+    // producer side. Room for len contiguous bytes, or nullptr if there isn't enough
+    // (counted as a drop). Fill at most len bytes, then commit(). Records bigger than
+    // half the queue are always refused, they could never be guaranteed to fit
+    unsigned char *reserve(size_t len) {
+      uint32_t need = align(len) + HEADER;
+      if (need > N / 2) {
+        drops++;
+        return nullptr;
+      }
+      uint32_t h = head.load(std::memory_order_relaxed);
+      uint32_t used = h - tail.load(std::memory_order_acquire);
+      uint32_t offset = h & (N - 1);
+      uint32_t skip = N - offset < need ? N - offset : 0; // wasted up to the end of the ring
+      if (used + skip + need > N) {
+        drops++;
+        return nullptr;
+      }
+      if (skip) {
+        // the consumer doesn't look past head, so this is safe to write before publishing
+        writeLength(offset, WRAP);
+        h += skip;
+        head.store(h, std::memory_order_release);
+        offset = 0;
+      }
+      return buf + offset + HEADER;
+    }
+
+    // producer side. Publish len bytes written to the last reserve(), len <= reserved
+    void commit(size_t len) {
+      uint32_t h = head.load(std::memory_order_relaxed);
+      writeLength(h & (N - 1), len);
+      h += align(len) + HEADER;
+      head.store(h, std::memory_order_release);
+      uint32_t used = h - tail.load(std::memory_order_relaxed);
+      if (used > max_used) max_used = used;
+    }
+
+    bool push(const void *data, size_t len) {
+      unsigned char *p = reserve(len);
+      if (!p) return false;
+      memcpy(p, data, len);
+      commit(len);
+      return true;
+    }
+
+    // consumer side. Oldest record and its length, or nullptr if the queue is empty
+    const unsigned char *front(size_t &len) {
+      uint32_t t = tail.load(std::memory_order_relaxed);
+      uint32_t h = head.load(std::memory_order_acquire);
+      if (t == h) return nullptr;
+      uint32_t l = readLength(t & (N - 1));
+      if (l == WRAP) {
+        t += N - (t & (N - 1));
+        tail.store(t, std::memory_order_release);
+        if (t == h) return nullptr;
+        l = readLength(0);
+      }
+      len = l;
+      return buf + (t & (N - 1)) + HEADER;
+    }
+
+    // consumer side. Done with the record from front()
+    void pop() {
+      uint32_t t = tail.load(std::memory_order_relaxed);
+      t += align(readLength(t & (N - 1))) + HEADER;
+      tail.store(t, std::memory_order_release);
+    }
+
+    // bytes in use (records, headers, padding), a snapshot
+    uint32_t bytesUsed() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+
+    uint32_t capacity()    const { return N; }
+    uint32_t getDropCount() const { return drops; }   // producer side counter
+    uint32_t getMaxUsed()   const { return max_used; } // producer side counter
+
+  private:
+
+    static const uint32_t HEADER = 4;
+    static const uint32_t WRAP   = 0xFFFFFFFF;
+
+    static uint32_t align(size_t len) { return (len + 3) & ~3u; }
+
+    void writeLength(uint32_t offset, uint32_t len) { memcpy(buf + offset, &len, HEADER); }
+    uint32_t readLength(uint32_t offset) const {
+      uint32_t len;
+      memcpy(&len, buf + offset, HEADER);
+      return len;
+    }
+
+    alignas(4) unsigned char buf[N];
+
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+
+    uint32_t drops    = 0;
+    uint32_t max_used = 0;
+
+};
+
+#endif
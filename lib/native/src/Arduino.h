@@ -0,0 +1,89 @@
+// Native stand-in for the Teensy core
+//
+// Just enough of the Arduino API for shart and the libraries it pulls in. Time comes from
+// the simulated clock in native_hal.h, pins only remember what was written to them.
+
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef __cplusplus
+#include <algorithm>
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+#include "native_hal.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define HIGH 1
+#define LOW  0
+
+#define INPUT          0
+#define OUTPUT         1
+#define INPUT_PULLUP   2
+#define INPUT_PULLDOWN 3
+
+#define CHANGE  4
+#define FALLING 2
+#define RISING  3
+
+#define NOT_AN_INTERRUPT -1
+
+#define PI         3.1415926535897932384626433832795
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+uint32_t micros(void);
+uint32_t millis(void);
+void     delay(uint32_t ms);
+void     delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int  digitalRead(uint8_t pin);
+int  analogRead(uint8_t pin);
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t pin);
+#define digitalPinToInterrupt(p) (p)
+
+// there is nothing to mask on the host, code that relies on this for more than an ISR
+// guard wouldn't be right on the Teensy either
+static inline void interrupts(void)   {}
+static inline void noInterrupts(void) {}
+
+void yield(void);
+
+#ifdef __cplusplus
+}
+
+typedef enum { LSBFIRST = 0, MSBFIRST = 1 } BitOrder;
+
+// functions instead of the usual macros so <algorithm> still works, mixed types allowed like the macros
+template <typename A, typename B>
+inline auto min(const A &a, const B &b) -> decltype(a < b ? a : b) { return b < a ? b : a; }
+template <typename A, typename B>
+inline auto max(const A &a, const B &b) -> decltype(a < b ? a : b) { return a < b ? b : a; }
+template <typename T, typename L, typename H>
+inline T constrain(T x, L lo, H hi) { return x < lo ? lo : (x > hi ? hi : x); }
+
+// the sketch
+void setup();
+void loop();
+#endif
+
+#endif
@@ -0,0 +1,48 @@
+// Native EventResponder
+//
+// Only the immediate flavour, which is all the async SPI transfers use: triggerEvent()
+// calls the attached function right away, on the calling thread (SPIClass::poll(), for
+// a DMA transfer).
+
+#ifndef NATIVE_EVENT_RESPONDER_H
+#define NATIVE_EVENT_RESPONDER_H
+
+#include <stddef.h>
+
+class EventResponder;
+typedef EventResponder &EventResponderRef;
+typedef void (*EventResponderFunction)(EventResponderRef);
+
+class EventResponder {
+
+  public:
+
+    void attachImmediate(EventResponderFunction function) { this->function = function; }
+    void detach() { function = nullptr; }
+
+    void  setContext(void *context) { this->context = context; }
+    void *getContext() { return context; }
+
+    void triggerEvent(int status = 0, void *data = nullptr) {
+      this->status = status;
+      this->data   = data;
+      triggered    = true;
+      if (function) function(*this);
+    }
+    void clearEvent() { triggered = false; }
+    operator bool() { return triggered; }
+
+    int   getStatus() { return status; }
+    void *getData() { return data; }
+
+  private:
+
+    EventResponderFunction function = nullptr;
+    void *context   = nullptr;
+    void *data      = nullptr;
+    int   status    = 0;
+    bool  triggered = false;
+
+};
+
+#endif
@@ -0,0 +1,79 @@
+// Native serial ports
+//
+// Bytes the code writes go to the device attached with hal::attachSerial() (if any) and
+// optionally to a host FILE, e.g. stdout for the USB port. Bytes the code reads come from
+// feed(), either called by the attached device or by the harness directly. The receive
+// side is locked, so a harness thread can feed a port that shart reads on another thread.
+
+#ifndef NATIVE_HARDWARESERIAL_H
+#define NATIVE_HARDWARESERIAL_H
+
+#include <stdio.h>
+#include <deque>
+#include <mutex>
+#include "Stream.h"
+
+namespace hal { class SerialDevice; }
+
+#define SERIAL_8N1 0
+
+class HardwareSerial : public Stream {
+
+  public:
+
+    explicit HardwareSerial(const char *name) : name(name) {}
+
+    void begin(uint32_t baud, uint16_t format = SERIAL_8N1) { this->baud = baud; (void) format; }
+    void end() {}
+    operator bool() { return true; } // the Teensy USB port is false until the host connects, ours always is
+
+    int available() override;
+    int read() override;
+    int peek() override;
+
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    int availableForWrite() override { return 4096; }
+    void flush() override { if (output) fflush(output); }
+    void addMemoryForWrite(void *buffer, size_t size) { (void) buffer; (void) size; }
+    void addMemoryForRead(void *buffer, size_t size)  { (void) buffer; (void) size; }
+
+    // harness side
+    void feed(const void *data, size_t len);
+    void setOutput(FILE *file) { output = file; } // copy of everything written, nullptr for none
+    void attach(hal::SerialDevice *d) { device = d; }
+
+    const char *getName()     const { return name; }
+    uint32_t    getBaud()     const { return baud; }
+    uint64_t    getTxCount()  const { return tx_count; } // bytes written by the code
+    uint64_t    getRxCount()  const { return rx_count; } // bytes read by the code
+
+  private:
+
+    void pump();
+
+    const char *name;
+    uint32_t    baud = 0;
+
+    std::mutex          rx_lock;
+    std::deque<uint8_t> rx;
+
+    FILE               *output = nullptr;
+    hal::SerialDevice  *device = nullptr;
+
+    uint64_t tx_count = 0;
+    uint64_t rx_count = 0;
+
+};
+
+// Teensy's USB serial is its own class, templates like UbxGpsConfig name it explicitly
+class usb_serial_class : public HardwareSerial {
+  public:
+    using HardwareSerial::HardwareSerial;
+};
+
+extern usb_serial_class Serial;
+extern HardwareSerial   Serial1, Serial2, Serial3, Serial4, Serial5, Serial6, Serial7, Serial8;
+
+#endif
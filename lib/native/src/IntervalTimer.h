@@ -0,0 +1,33 @@
+// Native IntervalTimer
+//
+// Same interface as the Teensy's PIT timers, but nothing fires on its own: hal::runTimers()
+// calls every callback whose time has come, on the calling thread (see native_hal.h).
+
+#ifndef NATIVE_INTERVALTIMER_H
+#define NATIVE_INTERVALTIMER_H
+
+#include <stdint.h>
+
+class IntervalTimer {
+
+  public:
+
+    ~IntervalTimer() { end(); }
+
+    bool begin(void (*function)(), uint32_t microseconds);
+    void update(uint32_t microseconds) { period_us = microseconds; }
+    void end();
+    void priority(uint8_t n) { (void) n; } // everything runs on the harness thread anyway
+
+    // harness side, once for every period that has passed by now_us
+    void run(uint64_t now_us);
+
+  private:
+
+    void   (*function)() = nullptr;
+    uint32_t period_us   = 0;
+    uint64_t next_us     = 0;
+
+};
+
+#endif
@@ -0,0 +1,70 @@
+// Arduino Print, everything funnels into write(uint8_t) or write(buffer, size)
+
+#ifndef NATIVE_PRINT_H
+#define NATIVE_PRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "WString.h"
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class Print {
+
+  public:
+
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+      size_t n = 0;
+      while (size--) n += write(*buffer++);
+      return n;
+    }
+    size_t write(const char *str)                     { return str ? write((const uint8_t *) str, strlen(str)) : 0; }
+    size_t write(const char *buffer, size_t size)     { return write((const uint8_t *) buffer, size); }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const char *s)                 { return write(s); }
+    size_t print(const String &s)               { return write((const uint8_t *) s.c_str(), s.length()); }
+    size_t print(const __FlashStringHelper *s)  { return write(reinterpret_cast<const char *>(s)); }
+    size_t print(char c)                        { return write((uint8_t) c); }
+    size_t print(unsigned char n, int base = DEC)      { return printNumber(n, base); }
+    size_t print(int n, int base = DEC)                { return printSigned(n, base); }
+    size_t print(unsigned int n, int base = DEC)       { return printNumber(n, base); }
+    size_t print(long n, int base = DEC)               { return printSigned(n, base); }
+    size_t print(unsigned long n, int base = DEC)      { return printNumber(n, base); }
+    size_t print(long long n, int base = DEC)          { return printSigned(n, base); }
+    size_t print(unsigned long long n, int base = DEC) { return printNumber(n, base); }
+    size_t print(double n, int digits = 2);
+
+    size_t println()                              { return write("\r\n"); }
+    template <typename T> size_t println(const T &x)           { size_t n = print(x); return n + println(); }
+    template <typename T> size_t println(const T &x, int base) { size_t n = print(x, base); return n + println(); }
+
+    int  getWriteError()   { return write_error; }
+    void clearWriteError() { write_error = 0; }
+
+  protected:
+
+    void setWriteError(int err = 1) { write_error = err; }
+
+  private:
+
+    size_t printNumber(unsigned long long n, int base);
+    size_t printSigned(long long n, int base) {
+      // like the Teensy core, only base 10 gets a minus sign
+      if (n < 0 && base == DEC) return write('-') + printNumber(-(unsigned long long) n, base);
+      return printNumber((unsigned long long) n, base);
+    }
+
+    int write_error = 0;
+
+};
+
+#endif
@@ -0,0 +1,2 @@
+// The real SdFat RingBuf, it only needs a file with read() and write(), which SdFat.h here has
+#include "../../SdFat/src/RingBuf.h"
@@ -0,0 +1,102 @@
+// Native SPI buses
+//
+// No clock or mode is modelled, a transfer just hands each byte to whichever device on
+// the bus has its chip select low (see hal::attachSpi) and returns what it answers.
+// Nothing selected reads as 0xFF, like a floating MISO with a pull-up.
+//
+// An async (DMA) transfer moves the bytes right away, but its event only fires once the
+// bus would have clocked them out (at the transaction's clock, plus a little DMA setup),
+// from a yield() on the thread that started it. Waiting on one is what code does anyway,
+// and when STEPPED that yield() moves the clock up to the completion, so the latency is
+// only charged for the part that wasn't overlapped with other work.
+
+#ifndef NATIVE_SPI_H
+#define NATIVE_SPI_H
+
+#include <atomic>
+#include <thread>
+#include "Arduino.h"
+#include "EventResponder.h"
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+#define SPI_HAS_TRANSFER_ASYNC 1
+
+class SPISettings {
+  public:
+    SPISettings(uint32_t clock = 4000000, uint8_t bit_order = MSBFIRST, uint8_t data_mode = SPI_MODE0)
+      : clock(clock), bit_order(bit_order), data_mode(data_mode) {}
+    uint32_t clock;
+    uint8_t  bit_order;
+    uint8_t  data_mode;
+};
+
+class SPIClass {
+
+  public:
+
+    explicit SPIClass(const char *name) : name(name) {}
+
+    void begin() {}
+    void end() {}
+    void beginTransaction(const SPISettings &settings) { clock = settings.clock; transactions++; }
+    void endTransaction() {}
+
+    uint8_t transfer(uint8_t data) {
+      bytes++;
+      return selected ? selected->transfer(data) : 0xFF;
+    }
+    uint16_t transfer16(uint16_t data) {
+      uint16_t hi = transfer(data >> 8);
+      return (hi << 8) | transfer(data & 0xFF);
+    }
+    void transfer(void *buf, size_t count) {
+      uint8_t *p = (uint8_t *) buf;
+      for (size_t i = 0; i < count; i++) p[i] = transfer(p[i]);
+    }
+    void transfer(const void *tx, void *rx, size_t count) {
+      const uint8_t *out = (const uint8_t *) tx;
+      uint8_t *in = (uint8_t *) rx;
+      for (size_t i = 0; i < count; i++) {
+        uint8_t b = transfer(out ? out[i] : 0xFF);
+        if (in) in[i] = b;
+      }
+    }
+    bool transfer(const void *tx, void *rx, size_t count, EventResponderRef event);
+
+    // hal side, yield() fires a finished async transfer's event
+    void poll();
+
+    // hal side, driven by digitalWrite() on an attached chip select
+    void select(hal::SpiDevice *device) { selected = device; }
+    void deselect(hal::SpiDevice *device) { if (selected == device) selected = nullptr; }
+
+    const char *getName()         const { return name; }
+    uint64_t    getByteCount()    const { return bytes; }        // bytes clocked so far
+    uint64_t    getTransactions() const { return transactions; } // beginTransaction() calls so far
+    uint64_t    getAsyncTransfers() const { return async_transfers; }
+
+  private:
+
+    const char     *name;
+    hal::SpiDevice *selected = nullptr;
+    uint64_t        bytes        = 0;
+    uint64_t        transactions = 0;
+    uint64_t        async_transfers = 0;
+    uint32_t        clock = 4000000;
+
+    // the async transfer in flight, if any
+    std::atomic<EventResponder *> pending{nullptr};
+    uint64_t        pending_due_us = 0;
+    void           *pending_data = nullptr;
+    size_t          pending_count = 0;
+    std::thread::id pending_owner;
+
+};
+
+extern SPIClass SPI, SPI1, SPI2;
+
+#endif
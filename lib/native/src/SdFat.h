@@ -0,0 +1,108 @@
+// Native SdFat, files live in memory
+//
+// One card (hal::SdCard) shared by every SdFs, so a log written during a run can be looked
+// at or saved to disk by the harness afterwards. Only the calls shart makes are here.
+// Writes can be given a cost per sector to see how the flush policy copes with a slow card.
+
+#ifndef NATIVE_SDFAT_H
+#define NATIVE_SDFAT_H
+
+#include <fcntl.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+typedef int oflag_t;
+
+#define FIFO_SDIO 0
+#define DMA_SDIO  1
+
+class SdioConfig {
+  public:
+    explicit SdioConfig(uint8_t options = FIFO_SDIO) : options(options) {}
+    uint8_t options;
+};
+
+namespace hal {
+
+class SdCard {
+
+  public:
+
+    static SdCard &instance();
+
+    bool inserted = true;              // SdFs::begin() fails without a card
+    uint32_t write_us_per_sector = 0;  // time every write takes, 0 for free
+
+    std::vector<uint8_t> *find(const std::string &name);
+    std::vector<uint8_t> *create(const std::string &name);
+    bool remove(const std::string &name);
+
+    // write every file on the card into directory dir, false if any of them failed
+    bool save(const char *dir);
+
+  private:
+
+    std::mutex lock;
+    std::map<std::string, std::vector<uint8_t>> files;
+
+};
+
+}
+
+class FsFile : public Stream {
+
+  public:
+
+    bool open(const char *path, oflag_t oflag = O_RDONLY);
+    bool close() { data = nullptr; return true; }
+    bool isOpen() const { return data != nullptr; }
+    operator bool() const { return isOpen(); }
+
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override;
+    size_t write(const void *buffer, size_t size) { return write((const uint8_t *) buffer, size); }
+    using Print::write;
+    int read(void *buffer, size_t size);
+    int read() override;
+    int peek() override;
+    int available() override { return isOpen() ? (int) (data->size() - position) : 0; }
+
+    bool     preAllocate(uint64_t length) { (void) length; return isOpen(); } // memory is never fragmented
+    bool     truncate() { return truncate(position); }
+    bool     truncate(uint64_t length);
+    bool     sync() { return isOpen(); }
+    bool     seekSet(uint64_t pos);
+    uint64_t curPosition() const { return position; }
+    uint64_t fileSize()    const { return isOpen() ? data->size() : 0; }
+    bool     isBusy()      const { return false; } // writes finish before write() returns
+
+  private:
+
+    std::vector<uint8_t> *data = nullptr;
+    uint64_t position  = 0;
+    bool     writable  = false;
+
+};
+
+class SdFs {
+
+  public:
+
+    bool begin(SdioConfig config) { (void) config; return hal::SdCard::instance().inserted; }
+    void end() {}
+
+    bool exists(const char *path)   { return hal::SdCard::instance().find(path) != nullptr; }
+    bool exists(const String &path) { return exists(path.c_str()); }
+    bool remove(const char *path)   { return hal::SdCard::instance().remove(path); }
+    FsFile open(const char *path, oflag_t oflag = O_RDONLY) {
+      FsFile file;
+      file.open(path, oflag);
+      return file;
+    }
+
+};
+
+#endif
@@ -0,0 +1,33 @@
+// Arduino Stream, a Print you can also read from
+
+#ifndef NATIVE_STREAM_H
+#define NATIVE_STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print {
+
+  public:
+
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long ms) { timeout = ms; }
+    unsigned long getTimeout()        { return timeout; }
+
+    // no waiting for bytes that might still come, on the host they are either there or not
+    size_t readBytes(char *buffer, size_t length) {
+      size_t n = 0;
+      while (n < length && available() > 0) buffer[n++] = (char) read();
+      return n;
+    }
+    size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *) buffer, length); }
+
+  protected:
+
+    unsigned long timeout = 1000;
+
+};
+
+#endif
@@ -0,0 +1,103 @@
+// Native stand-in for the Teensy-ICM-20948 library
+//
+// The real library uploads the InvenSense DMP firmware and talks to the DMP, there is no
+// point modelling that register by register. This keeps the same interface and serves
+// whatever hal::icm20948 (native_models.h) holds.
+
+#ifndef NATIVE_TEENSY_ICM_20948_H
+#define NATIVE_TEENSY_ICM_20948_H
+
+#include <SPI.h>
+
+struct inv_icm20948;
+extern struct inv_icm20948 *icm20948_instance;
+
+typedef struct {
+  int cs_pin                  = 0;
+  int spi_speed               = 1000000;
+  SPIClass *spi_bus           = &SPI1;
+  int mode                    = 1;
+  bool enable_gyroscope       = true;
+  bool enable_accelerometer   = true;
+  bool enable_magnetometer    = true;
+  bool enable_quaternion      = false;
+  bool enable_raw_gyroscope   = false;
+  bool enable_raw_accelerometer = false;
+  bool buffer_frames          = false;
+  int gyroscope_frequency     = 225;
+  int accelerometer_frequency = 225;
+  int magnetometer_frequency  = 225;
+  int quaternion_frequency    = 225;
+} TeensyICM20948Settings;
+
+#define ICM_FRAME_BUFFER 64
+
+enum TeensyICM20948FrameType : uint8_t {
+  ICM_FRAME_QUAT = 0,
+  ICM_FRAME_RAW_GYRO,
+  ICM_FRAME_RAW_ACCEL
+};
+
+typedef struct {
+  uint64_t timestamp;
+  uint8_t  type;
+  union {
+    float   quat[4];
+    int32_t raw[3];
+  };
+} TeensyICM20948Frame;
+
+class TeensyICM20948 {
+
+  public:
+
+    TeensyICM20948(TeensyICM20948Settings settings) : settings(settings) {}
+    TeensyICM20948(int cs_pin, SPIClass *spi_bus) {
+      settings.cs_pin  = cs_pin;
+      settings.spi_bus = spi_bus;
+    }
+
+    bool init();
+    void task();
+    bool connected();
+
+    bool gyroDataIsReady()  { return gyro_data_ready; }
+    bool accelDataIsReady() { return accel_data_ready; }
+    bool magDataIsReady()   { return mag_data_ready; }
+    bool quatDataIsReady()  { return quat_data_ready; }
+
+    void readGyroData(float *x, float *y, float *z);
+    void readAccelData(float *x, float *y, float *z);
+    void readMagData(float *x, float *y, float *z);
+    void readQuatData(float *w, float *x, float *y, float *z);
+
+    int readFrames(TeensyICM20948Frame *frames, int max);
+    uint32_t getFrameOverflows() { return frame_overflows; }
+
+  private:
+
+    TeensyICM20948Settings settings;
+
+    float gyro_x = 0, gyro_y = 0, gyro_z = 0;
+    float accel_x = 0, accel_y = 0, accel_z = 0;
+    float mag_x = 0, mag_y = 0, mag_z = 0;
+    float quat_w = 1, quat_x = 0, quat_y = 0, quat_z = 0;
+
+    bool accel_data_ready = false;
+    bool gyro_data_ready  = false;
+    bool mag_data_ready   = false;
+    bool quat_data_ready  = false;
+
+    // the DMP's output times, the ones task() hasn't queued yet
+    uint64_t next_quat_us = 0;
+    uint64_t next_raw_us  = 0;
+
+    TeensyICM20948Frame frames[ICM_FRAME_BUFFER];
+    int      frame_head = 0;
+    int      frame_count = 0;
+    uint32_t frame_overflows = 0;
+    TeensyICM20948Frame *pushFrame(uint8_t type, uint64_t timestamp);
+
+};
+
+#endif
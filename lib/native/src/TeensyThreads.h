@@ -0,0 +1,61 @@
+// Native TeensyThreads, every thread is a std::thread
+//
+// Host threads really run in parallel instead of taking turns in time slices, which is a
+// harsher test of anything shared between threads than the Teensy ever gives it.
+// A thread function usually never returns, so stop() parks every thread the next time it
+// calls yield() or delay(), after that the harness can look at shared state and exit.
+
+#ifndef NATIVE_TEENSYTHREADS_H
+#define NATIVE_TEENSYTHREADS_H
+
+#include <stdint.h>
+
+typedef void (*ThreadFunction)(void *);
+typedef void (*ThreadFunctionInt)(int);
+typedef void (*ThreadFunctionNone)();
+
+class Threads {
+
+  public:
+
+    int addThread(ThreadFunction p, void *arg = 0, int stack_size = -1, void *stack = 0);
+    int addThread(ThreadFunctionInt p, int arg = 0, int stack_size = -1, void *stack = 0) {
+      return addThread(runInt, new IntCall{p, arg}, stack_size, stack);
+    }
+    int addThread(ThreadFunctionNone p, int arg = 0, int stack_size = -1, void *stack = 0) {
+      (void) arg;
+      return addThread(runNone, new NoneCall{p}, stack_size, stack);
+    }
+
+    int setSliceMillis(int milliseconds) { (void) milliseconds; return 1; }
+    int setSliceMicros(int microseconds) { (void) microseconds; return 1; }
+    int setTimeSlice(int id, unsigned ticks) { (void) id; (void) ticks; return 1; }
+
+    static void yield();
+    void delay(int millisecond);
+
+    // harness side, returns once every thread is parked
+    void stop();
+
+  private:
+
+    // The int and no argument forms start through these, so a thread is always called as
+    // the type it was declared with instead of through a cast function pointer
+    struct IntCall  { ThreadFunctionInt p; int arg; };
+    struct NoneCall { ThreadFunctionNone p; };
+    static void runInt(void *call) {
+      IntCall c = *(IntCall *) call;
+      delete (IntCall *) call;
+      c.p(c.arg);
+    }
+    static void runNone(void *call) {
+      NoneCall c = *(NoneCall *) call;
+      delete (NoneCall *) call;
+      c.p();
+    }
+
+};
+
+extern Threads threads;
+
+#endif
@@ -0,0 +1,54 @@
+// Arduino String on top of std::string, only what shart and its libraries use
+
+#ifndef NATIVE_WSTRING_H
+#define NATIVE_WSTRING_H
+
+#include <string>
+#include <stdio.h>
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+class String {
+
+  public:
+
+    String(const char *s = "") : s(s ? s : "") {}
+    String(const std::string &s) : s(s) {}
+    String(const __FlashStringHelper *s) : String(reinterpret_cast<const char *>(s)) {}
+    explicit String(char c) : s(1, c) {}
+    explicit String(int n)                : s(std::to_string(n)) {}
+    explicit String(unsigned int n)       : s(std::to_string(n)) {}
+    explicit String(long n)               : s(std::to_string(n)) {}
+    explicit String(unsigned long n)      : s(std::to_string(n)) {}
+    explicit String(long long n)          : s(std::to_string(n)) {}
+    explicit String(unsigned long long n) : s(std::to_string(n)) {}
+    explicit String(double n, int digits = 2) {
+      char buf[64];
+      snprintf(buf, sizeof(buf), "%.*f", digits, n);
+      s = buf;
+    }
+
+    const char *c_str()  const { return s.c_str(); }
+    unsigned int length() const { return s.length(); }
+    char operator[](unsigned int i) const { return i < s.length() ? s[i] : 0; }
+
+    String &operator+=(const String &other) { s += other.s; return *this; }
+    String &operator+=(const char *other)   { s += other; return *this; }
+    String &operator+=(char c)              { s += c; return *this; }
+
+    friend String operator+(const String &a, const String &b) { return String(a.s + b.s); }
+    friend String operator+(const String &a, const char *b)   { return String(a.s + b); }
+    friend String operator+(const char *a, const String &b)   { return String(a + b.s); }
+
+    bool operator==(const String &other) const { return s == other.s; }
+    bool operator==(const char *other)   const { return s == other; }
+    bool operator!=(const String &other) const { return s != other.s; }
+
+  private:
+
+    std::string s;
+
+};
+
+#endif
@@ -0,0 +1,70 @@
+// Native I2C bus
+//
+// Transactions are buffered like the real TwoWire and delivered to the device attached at
+// the address (hal::attachI2c) as a whole. No device at an address means a NACK.
+
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include "Arduino.h"
+
+#define WIRE_BUFFER_LENGTH 136 // same as the Teensy 4 Wire library
+
+class TwoWire : public Stream {
+
+  public:
+
+    explicit TwoWire(const char *name) : name(name) {}
+
+    void begin() {}
+    void end() {}
+    void setClock(uint32_t frequency) { (void) frequency; }
+
+    void beginTransmission(uint8_t address) {
+      tx_address = address;
+      tx_len = 0;
+    }
+    // 0 on success, 2 for a NACK on the address, like the Teensy
+    uint8_t endTransmission(bool stop = true);
+
+    uint8_t requestFrom(uint8_t address, size_t len, bool stop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t len, uint8_t stop) { return requestFrom(address, (size_t) len, stop != 0); }
+    uint8_t requestFrom(int address, int len, int stop = 1) { return requestFrom((uint8_t) address, (size_t) len, stop != 0); }
+
+    size_t write(uint8_t b) override {
+      if (tx_len >= WIRE_BUFFER_LENGTH) return 0;
+      tx_buf[tx_len++] = b;
+      return 1;
+    }
+    size_t write(const uint8_t *buffer, size_t size) override {
+      size_t n = 0;
+      while (n < size && write(buffer[n])) n++;
+      return n;
+    }
+    using Print::write;
+
+    int available() override { return rx_len - rx_pos; }
+    int read() override      { return rx_pos < rx_len ? rx_buf[rx_pos++] : -1; }
+    int peek() override      { return rx_pos < rx_len ? rx_buf[rx_pos] : -1; }
+
+    uint64_t getTransactions() const { return transactions; }
+
+  private:
+
+    const char *name;
+
+    uint8_t tx_address = 0;
+    uint8_t tx_buf[WIRE_BUFFER_LENGTH];
+    size_t  tx_len = 0;
+
+    uint8_t rx_buf[WIRE_BUFFER_LENGTH];
+    size_t  rx_len = 0;
+    size_t  rx_pos = 0;
+
+    uint64_t transactions = 0;
+
+};
+
+extern TwoWire Wire, Wire1, Wire2;
+
+#endif
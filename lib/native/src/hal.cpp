@@ -0,0 +1,285 @@
+// Clock, pins, serial ports and buses of the native HAL
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+#include "Arduino.h"
+#include "IntervalTimer.h"
+#include "SPI.h"
+#include "Wire.h"
+
+namespace hal {
+
+/*******************************************************************************
+* Clock
+*******************************************************************************/
+static const auto start = std::chrono::steady_clock::now();
+static std::atomic<int>      clock_mode{REAL_TIME};
+static std::atomic<uint64_t> offset{0}; // delay()s, or all of the time when STEPPED
+
+void setClockMode(ClockMode mode) {
+  uint64_t t = now();
+  clock_mode = mode;
+  offset = 0;
+  offset = t - now(); // carry on from the same time, the clock never goes backwards
+}
+
+void advance(uint64_t us) { offset += us; }
+
+void spend(uint64_t us) {
+  if (clock_mode == STEPPED) {
+    advance(us);
+    return;
+  }
+  uint64_t end = now() + us;
+  while (now() < end) {}
+}
+
+uint64_t now() {
+  if (clock_mode == STEPPED) return offset;
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() + offset;
+}
+
+/*******************************************************************************
+* Pins
+*******************************************************************************/
+#define NUM_PINS 64
+
+struct ChipSelect {
+  SPIClass  *bus;
+  SpiDevice *device;
+};
+
+static uint8_t level[NUM_PINS];
+static int     analog[NUM_PINS];
+static void  (*isrs[NUM_PINS])(void);
+static std::map<int, ChipSelect> chip_selects;
+
+void setAnalog(int pin, int value) { if (pin >= 0 && pin < NUM_PINS) analog[pin] = value; }
+int  pinLevel(int pin)             { return pin >= 0 && pin < NUM_PINS ? level[pin] : LOW; }
+
+void trigger(int pin) {
+  if (pin >= 0 && pin < NUM_PINS && isrs[pin]) isrs[pin]();
+}
+
+/*******************************************************************************
+* Timers
+*******************************************************************************/
+static std::vector<IntervalTimer *> timers;
+
+void runTimers() {
+  uint64_t t = now();
+  for (size_t i = 0; i < timers.size(); i++) timers[i]->run(t); // a callback may end() its timer
+}
+
+/*******************************************************************************
+* Devices
+*******************************************************************************/
+static std::map<uint8_t, I2cDevice *> i2c_devices;
+
+void attachSpi(SPIClass &bus, int cs_pin, SpiDevice *device) {
+  chip_selects[cs_pin] = ChipSelect{&bus, device};
+  if (cs_pin >= 0 && cs_pin < NUM_PINS) level[cs_pin] = HIGH;
+}
+
+void attachI2c(uint8_t address, I2cDevice *device) { i2c_devices[address] = device; }
+
+void attachSerial(HardwareSerial &port, SerialDevice *device) { port.attach(device); }
+
+static void chipSelect(int pin, uint8_t value) {
+  auto cs = chip_selects.find(pin);
+  if (cs == chip_selects.end()) return;
+  if (value == LOW) {
+    cs->second.bus->select(cs->second.device);
+    cs->second.device->select();
+  } else {
+    cs->second.device->deselect();
+    cs->second.bus->deselect(cs->second.device);
+  }
+}
+
+static I2cDevice *i2cDevice(uint8_t address) {
+  auto d = i2c_devices.find(address);
+  return d == i2c_devices.end() ? nullptr : d->second;
+}
+
+}
+
+/*******************************************************************************
+* Arduino core
+*******************************************************************************/
+uint32_t micros() { return (uint32_t) hal::now(); }
+uint32_t millis() { return (uint32_t) (hal::now() / 1000); }
+
+void delay(uint32_t ms)            { hal::advance((uint64_t) ms * 1000); }
+void delayMicroseconds(uint32_t us) { hal::advance(us); }
+void yield() {
+  SPI.poll();
+  SPI1.poll();
+  SPI2.poll();
+  std::this_thread::yield();
+}
+
+void pinMode(uint8_t pin, uint8_t mode) { (void) pin; (void) mode; }
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin >= NUM_PINS) return;
+  value = value ? HIGH : LOW;
+  if (hal::level[pin] != value) hal::chipSelect(pin, value);
+  hal::level[pin] = value;
+}
+
+int digitalRead(uint8_t pin) { return hal::pinLevel(pin); }
+int analogRead(uint8_t pin)  { return pin < NUM_PINS ? hal::analog[pin] : 0; }
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) {
+  (void) mode;
+  if (pin < NUM_PINS) hal::isrs[pin] = isr;
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin < NUM_PINS) hal::isrs[pin] = nullptr;
+}
+
+bool IntervalTimer::begin(void (*function)(), uint32_t microseconds) {
+  if (!function || !microseconds) return false;
+  end();
+  this->function = function;
+  period_us = microseconds;
+  next_us   = hal::now() + microseconds;
+  hal::timers.push_back(this);
+  return true;
+}
+
+void IntervalTimer::end() {
+  for (size_t i = 0; i < hal::timers.size(); i++) {
+    if (hal::timers[i] == this) hal::timers.erase(hal::timers.begin() + i);
+  }
+  function = nullptr;
+}
+
+void IntervalTimer::run(uint64_t now_us) {
+  while (function && now_us >= next_us) {
+    next_us += period_us;
+    function();
+  }
+}
+
+/*******************************************************************************
+* Print
+*******************************************************************************/
+size_t Print::printNumber(unsigned long long n, int base) {
+  if (base < 2) base = DEC;
+  char buf[8 * sizeof(n) + 1];
+  char *p = buf + sizeof(buf);
+  do {
+    int digit = n % base;
+    *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    n /= base;
+  } while (n);
+  return write((const uint8_t *) p, buf + sizeof(buf) - p);
+}
+
+size_t Print::print(double n, int digits) {
+  char buf[64];
+  int len = snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write((const uint8_t *) buf, len > 0 ? len : 0);
+}
+
+/*******************************************************************************
+* Serial ports
+*******************************************************************************/
+usb_serial_class Serial("Serial");
+HardwareSerial   Serial1("Serial1"), Serial2("Serial2"), Serial3("Serial3"), Serial4("Serial4"),
+                 Serial5("Serial5"), Serial6("Serial6"), Serial7("Serial7"), Serial8("Serial8");
+
+void HardwareSerial::pump() {
+  if (device) device->pump(*this, hal::now());
+}
+
+int HardwareSerial::available() {
+  pump();
+  std::lock_guard<std::mutex> guard(rx_lock);
+  return rx.size();
+}
+
+int HardwareSerial::read() {
+  pump();
+  std::lock_guard<std::mutex> guard(rx_lock);
+  if (rx.empty()) return -1;
+  uint8_t b = rx.front();
+  rx.pop_front();
+  rx_count++;
+  return b;
+}
+
+int HardwareSerial::peek() {
+  pump();
+  std::lock_guard<std::mutex> guard(rx_lock);
+  return rx.empty() ? -1 : rx.front();
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  if (device) for (size_t i = 0; i < size; i++) device->received(*this, buffer[i]);
+  if (output) fwrite(buffer, 1, size, output);
+  tx_count += size;
+  return size;
+}
+
+void HardwareSerial::feed(const void *data, size_t len) {
+  const uint8_t *p = (const uint8_t *) data;
+  std::lock_guard<std::mutex> guard(rx_lock);
+  rx.insert(rx.end(), p, p + len);
+}
+
+/*******************************************************************************
+* SPI and I2C
+*******************************************************************************/
+SPIClass SPI("SPI"), SPI1("SPI1"), SPI2("SPI2");
+
+#define SPI_DMA_SETUP_US 2 // starting the DMA channels and LPSPI, roughly
+
+bool SPIClass::transfer(const void *tx, void *rx, size_t count, EventResponderRef event) {
+  if (pending) return false; // the Teensy's DMA is busy too
+  transfer(tx, rx, count);
+  async_transfers++;
+  pending_due_us = hal::now() + SPI_DMA_SETUP_US + ((uint64_t) count * 8 * 1000000 + clock - 1) / clock;
+  pending_data   = rx;
+  pending_count  = count;
+  pending_owner  = std::this_thread::get_id();
+  pending        = &event;
+  return true;
+}
+
+void SPIClass::poll() {
+  if (!pending || std::this_thread::get_id() != pending_owner) return; // pending is set last
+  uint64_t now = hal::now();
+  if (now < pending_due_us) {
+    if (hal::clock_mode == hal::STEPPED) hal::advance(pending_due_us - now);
+    else return;
+  }
+  EventResponder *event = pending;
+  pending = nullptr; // before the event, it may start the next transfer
+  event->triggerEvent(pending_count, pending_data);
+}
+TwoWire  Wire("Wire"), Wire1("Wire1"), Wire2("Wire2");
+
+uint8_t TwoWire::endTransmission(bool stop) {
+  (void) stop;
+  transactions++;
+  hal::I2cDevice *device = hal::i2cDevice(tx_address);
+  return device && device->write(tx_buf, tx_len) ? 0 : 2;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, size_t len, bool stop) {
+  (void) stop;
+  transactions++;
+  if (len > WIRE_BUFFER_LENGTH) len = WIRE_BUFFER_LENGTH;
+  hal::I2cDevice *device = hal::i2cDevice(address);
+  rx_len = device ? device->read(rx_buf, len) : 0;
+  rx_pos = 0;
+  return rx_len;
+}
@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include "log_replay.h"
+
+namespace hal {
+
+static_assert(sizeof(highg_batch_p) <= sizeof(imu_batch_p), "the replay buffer has to fit every packet");
+static_assert(sizeof(baro_batch_p) <= sizeof(imu_batch_p), "the replay buffer has to fit every packet");
+static_assert(sizeof(icm_batch_p) <= sizeof(imu_batch_p), "the replay buffer has to fit every packet");
+
+bool LogReplay::open(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  unsigned char chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) log.insert(log.end(), chunk, chunk + n);
+  fclose(f);
+  pos = 0;
+  decoder.reset();
+  return true;
+}
+
+const unsigned char *LogReplay::next(size_t &len) {
+  while (pos < log.size()) {
+    size_t n = decoder.decode(log.data() + pos, log.size() - pos, packet, packet_len);
+    if (n == 0) {
+      pos++;
+      skipped++;
+      continue;
+    }
+    pos += n;
+    if (packet_len == 0) { // a frame, but not a good one
+      skipped += n;
+      continue;
+    }
+
+    timed = packet[1] == TYPE_SENSOR || packet[1] == TYPE_GPS || packet[1] == TYPE_TIMESYNC;
+    if (timed) {
+      uint32_t us[2];
+      memcpy(us, packet + HEADER_LENGTH, sizeof(us)); // they all start with data.us, data.us_hi
+      uint64_t t = ((uint64_t) us[1] << 32) | us[0];
+      if (!started) first_us = t;
+      started = true;
+      elapsed = t - first_us;
+    }
+    packets++;
+    len = packet_len;
+    return packet;
+  }
+  return nullptr;
+}
+
+bool LogReplay::time(uint64_t &us) const {
+  if (!timed) return false;
+  us = elapsed;
+  return true;
+}
+
+}
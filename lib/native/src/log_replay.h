@@ -0,0 +1,59 @@
+// Reads a recorded dataN.poop back packet by packet, for Shart::replay()
+//
+// Delta frames are decoded and every packet is CRC checked, so what comes out is exactly
+// what send() had when the log was recorded. Bytes that aren't a good packet (a torn
+// write, the end of a preallocated file) are skipped and counted.
+
+#ifndef NATIVE_LOG_REPLAY_H
+#define NATIVE_LOG_REPLAY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <comms.h>
+#include <delta.h>
+
+namespace hal {
+
+class LogReplay {
+
+  public:
+
+    bool open(const char *path); // reads the whole file, false if it can't
+
+    // the next good packet, nullptr at the end of the log. Valid until the next call
+    const unsigned char *next(size_t &len);
+
+    // recorded time of the packet next() just returned, in us since the first timed packet of
+    // the log (sensor and gps packets). False for packets without a time of their own (batches
+    // are sent a while after their first sample, commands)
+    bool time(uint64_t &us) const;
+
+    uint32_t getPacketCount()  const { return packets; }
+    uint32_t getSkippedBytes() const { return skipped; }
+
+  private:
+
+    std::vector<unsigned char> log;
+    size_t pos = 0;
+
+    // the biggest plain packet a log can hold
+    static const size_t MAX_PACKET = sizeof(imu_batch_p) > sizeof(profile_p) ? sizeof(imu_batch_p) : sizeof(profile_p);
+
+    DeltaDecoder  decoder;
+    unsigned char packet[MAX_PACKET];
+    size_t        packet_len = 0;
+
+    bool     timed    = false;
+    bool     started  = false;
+    uint64_t first_us = 0;
+    uint64_t elapsed  = 0;
+
+    uint32_t packets = 0;
+    uint32_t skipped = 0;
+
+};
+
+}
+
+#endif
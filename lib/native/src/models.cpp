@@ -0,0 +1,581 @@
+// Sensor models of the native HAL, and the ICM-20948 library stand-in on top of its model
+
+#include "Arduino.h"
+#include "native_models.h"
+#include "Teensy-ICM-20948.h"
+
+namespace hal {
+
+Lsm6dso32Model lsm6dso32;
+Adxl375Model   adxl375;
+Bmp390Model    bmp390;
+Icm20948Model  icm20948;
+UbloxModel     ublox;
+
+/*******************************************************************************
+* LSM6DSO32
+*******************************************************************************/
+void Lsm6dso32Model::reset() {
+  memset(regs, 0, sizeof(regs));
+  regs[0x0F] = 0x6C; // WHO_AM_I
+  regs[0x12] = 0x04; // CTRL3_C, IF_INC
+  fifo_head  = fifo_count = 0;
+  fifo_ovr   = fifo_on = false;
+}
+
+void Lsm6dso32Model::writeRegister(uint8_t reg, uint8_t v) {
+  if (reg == 0x12 && (v & 0x01)) { // SW_RESET, done right away
+    reset();
+    reset_us = now(); // not in reset(), the constructor runs before the clock exists
+    return;
+  }
+  regs[reg] = v;
+  if (reg == 0x0A) { // FIFO_CTRL4, bypass empties the FIFO
+    fifo_on = (v & 0x07) == 0x06 && (regs[0x09] >> 4);
+    fifo_head = fifo_count = 0;
+    fifo_ovr  = false;
+    next_slot = chipTime();
+    slot      = 0;
+  }
+}
+
+double Lsm6dso32Model::chipTime() const {
+  return (now() - reset_us) * (1 + clock_ppm * 1e-6);
+}
+
+void Lsm6dso32Model::pushWord(uint8_t tag, const uint8_t *data) {
+  if (fifo_count == FIFO_WORDS) { // continuous mode, the oldest word goes
+    fifo_head = (fifo_head + 1) % FIFO_WORDS;
+    fifo_count--;
+    fifo_ovr = true;
+    fifo_overwrites++;
+  }
+  uint8_t *word = fifo[(fifo_head + fifo_count++) % FIFO_WORDS];
+  word[0] = tag << 3 | (slot & 0x03) << 1;
+  memcpy(word + 1, data, 6);
+}
+
+// every slot up to now: a timestamp every 1/8/32 slots (DEC_TS_BATCH), then gyro and accel
+void Lsm6dso32Model::fillFifo() {
+  if (!fifo_on) return;
+  double period = 150.0 * (1 << (10 - (regs[0x09] >> 4))); // BDR_GY, 6667 Hz >> (10 - code)
+  static const uint32_t ts_every[4] = {0, 1, 8, 32};
+  uint32_t every = ts_every[regs[0x0A] >> 6];
+  double t = chipTime();
+  while (next_slot <= t) {
+    uint8_t data[6] = {};
+    if (every && slot % every == 0) {
+      uint32_t ticks = next_slot / 25;
+      memcpy(data, &ticks, 4);
+      pushWord(0x04, data);
+    }
+    for (int i = 0; i < 3; i++) {
+      int16_t v = gyr[i] + noise.next(noise_lsb);
+      memcpy(data + 2 * i, &v, 2);
+    }
+    pushWord(0x01, data);
+    for (int i = 0; i < 3; i++) {
+      int16_t v = acc[i] + noise.next(noise_lsb);
+      memcpy(data + 2 * i, &v, 2);
+    }
+    pushWord(0x02, data);
+    slot++;
+    fifo_slots++;
+    next_slot += period;
+  }
+}
+
+void Lsm6dso32Model::beginRead(uint8_t reg) {
+  fillFifo();
+  if (covers(reg, 0x3A, 0x3B)) {
+    regs[0x3A] = fifo_count & 0xFF;
+    regs[0x3B] = (fifo_count >> 8) | (fifo_ovr ? 0x40 : 0);
+    fifo_ovr = false;
+  }
+  if (!covers(reg, 0x1E, 0x2D)) return;
+  regs[0x1E] = 0x07; // STATUS_REG, temp, gyro, accel all new
+  put(0x20, temp);
+  for (int i = 0; i < 3; i++) put(0x22 + 2 * i, gyr[i] + noise.next(noise_lsb));
+  for (int i = 0; i < 3; i++) put(0x28 + 2 * i, acc[i] + noise.next(noise_lsb));
+}
+
+// the FIFO word registers show the oldest word, reading its last byte pops it
+uint8_t Lsm6dso32Model::readRegister(uint8_t reg) {
+  if (reg < 0x78 || reg > 0x7E) return regs[reg];
+  if (fifo_count == 0) return 0;
+  uint8_t v = fifo[fifo_head][reg - 0x78];
+  if (reg == 0x7E) {
+    fifo_head = (fifo_head + 1) % FIFO_WORDS;
+    fifo_count--;
+  }
+  return v;
+}
+
+/*******************************************************************************
+* ADXL375
+*******************************************************************************/
+void Adxl375Model::writeRegister(uint8_t reg, uint8_t v) {
+  regs[reg] = v;
+  if (reg == 0x38 || reg == 0x2C) { // FIFO_CTL or BW_RATE, start over
+    fifo_head = fifo_count = 0;
+    next_sample = chipTime();
+  }
+}
+
+double Adxl375Model::chipTime() const {
+  return now() * (1 + clock_ppm * 1e-6);
+}
+
+// every sample up to now, stream mode keeps the newest 32
+void Adxl375Model::fillFifo() {
+  if (!fifoOn()) return;
+  double period = 312.5 * (1 << (15 - (regs[0x2C] & 0x0F))); // 3200 Hz >> (15 - rate code)
+  double t = chipTime();
+  while (next_sample <= t) {
+    if (fifo_count == FIFO_SAMPLES) {
+      fifo_head = (fifo_head + 1) % FIFO_SAMPLES;
+      fifo_count--;
+      fifo_overwrites++;
+    }
+    int16_t *s = fifo[(fifo_head + fifo_count++) % FIFO_SAMPLES];
+    for (int i = 0; i < 3; i++) s[i] = acc[i] + noise.next(noise_lsb);
+    fifo_samples++;
+    next_sample += period;
+  }
+}
+
+void Adxl375Model::beginRead(uint8_t reg) {
+  fillFifo();
+  if (covers(reg, 0x39, 0x39)) regs[0x39] = fifo_count; // FIFO_STATUS entries
+  if (!covers(reg, 0x32, 0x37)) return;
+  if (fifoOn()) {
+    if (fifo_count == 0) return; // nothing new, the registers keep the last sample
+    for (int i = 0; i < 3; i++) {
+      regs[0x32 + 2 * i] = fifo[fifo_head][i] & 0xFF;
+      regs[0x33 + 2 * i] = (fifo[fifo_head][i] >> 8) & 0xFF;
+    }
+  } else {
+    for (int i = 0; i < 3; i++) {
+      int32_t v = acc[i] + noise.next(noise_lsb);
+      regs[0x32 + 2 * i] = v & 0xFF;
+      regs[0x33 + 2 * i] = (v >> 8) & 0xFF;
+    }
+  }
+  regs[0x30] |= 0x80; // DATA_READY
+}
+
+// reading DATAZ1 pops the FIFO's oldest sample
+uint8_t Adxl375Model::readRegister(uint8_t reg) {
+  if (reg == 0x37 && fifoOn() && fifo_count) {
+    fifo_head = (fifo_head + 1) % FIFO_SAMPLES;
+    fifo_count--;
+  }
+  return regs[reg];
+}
+
+/*******************************************************************************
+* BMP390
+*******************************************************************************/
+
+// CRC over the calibration block the Adafruit driver checks against register 0x30
+static uint8_t bmpCalibrationCrc(const uint8_t *data, size_t len) {
+  uint8_t crc = 0xFF;
+  while (len--) {
+    uint8_t d = *data++;
+    for (int i = 0; i < 8; i++) {
+      bool bit = (crc ^ d) & 0x80;
+      crc = (crc << 1) ^ (bit ? 0x1D : 0);
+      d <<= 1;
+    }
+  }
+  return crc ^ 0xFF;
+}
+
+void Bmp390Model::reset() {
+  memset(regs, 0, sizeof(regs));
+  regs[0x00] = 0x60; // CHIP_ID
+  regs[0x01] = 0x01; // REV_ID
+  regs[0x03] = 0x70; // STATUS, command ready, pressure and temperature ready
+
+  uint8_t *calib = regs + 0x31;
+  calib[0] = PAR_T1 & 0xFF;
+  calib[1] = PAR_T1 >> 8;
+  calib[2] = PAR_T2 & 0xFF;
+  calib[3] = PAR_T2 >> 8;
+  calib[5] = PAR_P1 & 0xFF;
+  calib[6] = PAR_P1 >> 8;
+  calib[7] = 16384 & 0xFF; // P2 is stored with a 2^14 offset
+  calib[8] = 16384 >> 8;
+  regs[0x30] = bmpCalibrationCrc(calib, 21);
+
+  fifo_head = fifo_count = 0; // FIFO_CONFIG_1 is 0 now, the FIFO is off
+  time_left = 0;
+}
+
+void Bmp390Model::writeRegister(uint8_t reg, uint8_t v) {
+  if (reg == 0x7E) { // CMD
+    if (v == 0xB6) reset();
+    if (v == 0xB0) flushFifo();
+    return;
+  }
+  regs[reg] = v;
+  if (reg == 0x17 || reg == 0x1D) flushFifo(); // FIFO_CONFIG_1, ODR
+}
+
+double Bmp390Model::ticks() const {
+  return now() * (1 + clock_ppm * 1e-6) * 0.0256;
+}
+
+void Bmp390Model::flushFifo() {
+  fifo_head = fifo_count = 0;
+  double period = 128 << (regs[0x1D] & 0x1F);
+  next_frame = (floor(ticks() / period) + 1) * period;
+}
+
+// the inverse of the linear compensation described in native_models.h
+void Bmp390Model::sample(uint32_t &p, uint32_t &t) {
+  double raw_p = pressure * 1048576.0 / (PAR_P1 - 16384);
+  double raw_t = PAR_T1 * 256.0 + temperature * 1073741824.0 / PAR_T2;
+  p = (uint32_t) (raw_p + noise.next(noise_lsb)) & 0xFFFFFF;
+  t = (uint32_t) raw_t & 0xFFFFFF;
+}
+
+// every frame up to now, with fifo_stop_on_full off the oldest frames make room
+void Bmp390Model::fillFifo() {
+  uint8_t config = regs[0x17];
+  bool press = config & 0x08, temp = config & 0x10;
+  if (!(config & 0x01) || !(press || temp)) return;
+  int size = 1 + (press ? 3 : 0) + (temp ? 3 : 0);
+  double period = 128 << (regs[0x1D] & 0x1F);
+  double t = ticks();
+  while (next_frame <= t) {
+    next_frame += period;
+    if (fifo_count + size > FIFO_BYTES) {
+      if (config & 0x02) continue; // stop on full
+      fifo_head = (fifo_head + size) % FIFO_BYTES;
+      fifo_count -= size;
+      fifo_overwrites++;
+    }
+    uint32_t p, tr;
+    sample(p, tr);
+    uint8_t frame[7] = {(uint8_t) (0x80 | (temp ? 0x10 : 0) | (press ? 0x04 : 0))};
+    int n = 1;
+    if (temp)  for (int i = 0; i < 3; i++) frame[n++] = tr >> (8 * i);
+    if (press) for (int i = 0; i < 3; i++) frame[n++] = p >> (8 * i);
+    for (int i = 0; i < n; i++) fifo[(fifo_head + fifo_count++) % FIFO_BYTES] = frame[i];
+    fifo_frames++;
+  }
+}
+
+void Bmp390Model::beginRead(uint8_t reg) {
+  fillFifo();
+  uint32_t now_ticks = (uint32_t) ticks() & 0xFFFFFF;
+  if (reg == 0x14) { // a new FIFO burst, it ends with the time of this read
+    time_frame[0] = 0xA0;
+    for (int i = 0; i < 3; i++) time_frame[1 + i] = now_ticks >> (8 * i);
+    time_left = regs[0x17] & 0x04 ? 4 : 0;
+  }
+  if (covers(reg, 0x0C, 0x0E)) {
+    for (int i = 0; i < 3; i++) regs[0x0C + i] = now_ticks >> (8 * i);
+  }
+  if (covers(reg, 0x12, 0x13)) {
+    regs[0x12] = fifo_count & 0xFF;
+    regs[0x13] = fifo_count >> 8;
+  }
+  if (!covers(reg, 0x04, 0x09)) return;
+  uint32_t p, t;
+  sample(p, t);
+  regs[0x04] = p;
+  regs[0x05] = p >> 8;
+  regs[0x06] = p >> 16;
+  regs[0x07] = t;
+  regs[0x08] = t >> 8;
+  regs[0x09] = t >> 16;
+}
+
+uint8_t Bmp390Model::readRegister(uint8_t reg) {
+  if (reg != 0x14) return regs[reg];
+  if (fifo_count) {
+    uint8_t v = fifo[fifo_head];
+    fifo_head = (fifo_head + 1) % FIFO_BYTES;
+    fifo_count--;
+    return v;
+  }
+  if (time_left) return time_frame[4 - time_left--];
+  return 0x80; // empty frame
+}
+
+/*******************************************************************************
+* u-blox
+*******************************************************************************/
+UbloxModel::UbloxModel() {
+  memset(&pvt, 0, sizeof(pvt));
+  pvt.header.headerClass  = 0x01;
+  pvt.header.headerId     = 0x07;
+  pvt.header.headerLength = sizeof(NavPvtPacket) - sizeof(commonHeader);
+  pvt.year    = 2024;
+  pvt.month   = 4;
+  pvt.day     = 20;
+  pvt.valid   = 0x07;
+  pvt.fixType = 3;
+  pvt.flags   = 0x01;
+  pvt.numSV   = 11;
+  pvt.lat     = 421034100;   // Binghamton
+  pvt.lon     = -759690800;
+  pvt.alt     = 280000;
+  pvt.hMSL    = 314000;
+  pvt.hAcc    = 2500;
+  pvt.vAcc    = 4000;
+  pvt.sAcc    = 300;
+  pvt.pDOP    = 140;
+  parser.on(UBX_CLASS_MON, UBX_MON_VER, onCommand, this);
+  const uint8_t cfg[] = {UBX_CFG_PRT, UBX_CFG_MSG, UBX_CFG_RATE, UBX_CFG_GNSS, 0x09}; // 0x09 is CFG-CFG
+  for (uint8_t id : cfg) parser.on(UBX_CLASS_CFG, id, onCommand, this);
+}
+
+void UbloxModel::reset() {
+  present       = true;
+  baud          = 9600;
+  period_us     = 1000000;
+  nmea          = true;
+  pvt_on        = false;
+  max_baud      = 921600;
+  link_max_baud = 0;
+  min_period_ms = 100;
+  drop_acks     = 0;
+  started       = false;
+  timegps_on    = false;
+}
+
+void UbloxModel::received(HardwareSerial &port, uint8_t b) {
+  rx_bytes++;
+  this->port = &port;
+  if (!present || port.getBaud() != baud) return; // framing errors, nothing it can parse
+  parser.push(b);
+}
+
+void UbloxModel::onCommand(const UbxFrame &frame, void *context) {
+  ((UbloxModel *) context)->command(frame);
+}
+
+void UbloxModel::command(const UbxFrame &frame) {
+  commands++;
+  const uint8_t *p = frame.payload;
+  if (frame.cls == UBX_CLASS_MON) {
+    if (frame.length) return;
+    uint8_t version[40] = {};
+    strcpy((char *) version, "ROM CORE 1.00 (59842)");
+    strcpy((char *) version + 30, "00070000");
+    send(UBX_CLASS_MON, UBX_MON_VER, version, sizeof(version));
+    return;
+  }
+  switch (frame.id) {
+    case UBX_CFG_PRT: {
+      if (frame.length != 20 || p[0] != 1) return ack(frame, false);
+      uint32_t to;
+      memcpy(&to, p + 8, 4);
+      if (to > max_baud) return ack(frame, false);
+      ack(frame, true); // still at the old baud
+      baud = to;
+      nmea = p[14] & 0x02;
+      return;
+    }
+    case UBX_CFG_RATE: {
+      if (frame.length != 6) return ack(frame, false);
+      uint16_t ms = p[0] | (p[1] << 8);
+      if (ms < min_period_ms) return ack(frame, false);
+      period_us = ms * 1000;
+      return ack(frame, true);
+    }
+    case UBX_CFG_MSG:
+      if (frame.length < 3) return ack(frame, false);
+      if (p[0] == UBX_CLASS_NAV && p[1] == UBX_NAV_PVT) pvt_on = p[2] != 0;
+      if (p[0] == UBX_CLASS_NAV && p[1] == UBX_NAV_TIMEGPS) timegps_on = p[2] != 0;
+      return ack(frame, true);
+    default:
+      return ack(frame, true);
+  }
+}
+
+void UbloxModel::ack(const UbxFrame &frame, bool ok) {
+  if (drop_acks) {
+    drop_acks--;
+    return;
+  }
+  uint8_t payload[2] = {frame.cls, frame.id};
+  send(UBX_CLASS_ACK, ok ? UBX_ACK_ACK : UBX_ACK_NAK, payload, sizeof(payload));
+}
+
+// a frame at our baud, garbage to a port at another one or over a link that can't take it
+void UbloxModel::send(uint8_t cls, uint8_t id, const void *payload, uint16_t len) {
+  if (!port) return;
+  uint8_t frame[8 + 256];
+  uint8_t header[6] = {UBX_SYNC_1, UBX_SYNC_2, cls, id, (uint8_t) len, (uint8_t) (len >> 8)};
+  memcpy(frame, header, sizeof(header));
+  memcpy(frame + 6, payload, len);
+  uint8_t a = 0, b = 0;
+  for (size_t i = 2; i < 6u + len; i++) {
+    a += frame[i];
+    b += a;
+  }
+  frame[6 + len] = a;
+  frame[7 + len] = b;
+  if (port->getBaud() != baud || (link_max_baud && baud > link_max_baud)) {
+    for (size_t i = 0; i < 8u + len; i++) frame[i] ^= 0x5A;
+  }
+  port->feed(frame, 8 + len);
+}
+
+uint64_t UbloxModel::gpsNs(uint64_t us) const {
+  return gps_start_ns + us * 1000 - (int64_t) us * drift_ppb / 1000000;
+}
+
+uint64_t UbloxModel::ourUs(uint64_t ns) const {
+  return (uint64_t) ((ns - gps_start_ns) / (1000.0 - drift_ppb / 1e6));
+}
+
+void UbloxModel::pump(HardwareSerial &port, uint64_t now_us) {
+  static const uint64_t WEEK_NS = 604800ULL * 1000000000;
+  this->port = &port;
+  if (!started) {
+    started  = true;
+    epoch_ns = (gpsNs(now_us) / 1000000000 + 1) * 1000000000; // the rates all divide a second
+    out_us   = ourUs(epoch_ns) + latency_us + (jitter_us / 2 + noise.next(jitter_us / 2));
+    pps_ns   = epoch_ns;
+    return;
+  }
+  while (pps_pin >= 0 && ourUs(pps_ns) <= now_us) {
+    pps_ns += 1000000000;
+    if (present) trigger(pps_pin); // late by however long since the last pump(), like an ISR
+  }
+  while (now_us >= out_us) {
+    uint64_t ns = epoch_ns;
+    epoch_ns += (uint64_t) period_us * 1000;
+    out_us    = ourUs(epoch_ns) + latency_us + (jitter_us / 2 + noise.next(jitter_us / 2));
+    if (!present) continue;
+    pvt.iTOW = ns % WEEK_NS / 1000000;
+    pvt.nano = (ns - (uint64_t) leap_s * 1000000000) % 1000000000; // UTC, a whole number of seconds behind
+    if (nmea) {
+      static const char gga[] = "$GPGGA,123519,4207.038,N,07558.000,W,1,11,0.9,314.0,M,-34.0,M,,*4B\r\n";
+      uint8_t text[sizeof(gga)];
+      memcpy(text, gga, sizeof(text));
+      if (port.getBaud() != baud) for (uint8_t &c : text) c ^= 0x5A;
+      port.feed(text, sizeof(text) - 1);
+    }
+    if (pvt_on) {
+      send(UBX_CLASS_NAV, UBX_NAV_PVT, (const uint8_t *) &pvt + sizeof(commonHeader), sizeof(pvt) - sizeof(commonHeader));
+      frames++;
+    }
+    if (timegps_on) {
+      NavTimeGpsPacket t = {};
+      t.iTOW  = pvt.iTOW;
+      t.week  = ns / WEEK_NS;
+      t.leapS = leap_s;
+      t.valid = 0x07;
+      send(UBX_CLASS_NAV, UBX_NAV_TIMEGPS, (const uint8_t *) &t + sizeof(commonHeader), sizeof(t) - sizeof(commonHeader));
+    }
+  }
+}
+
+}
+
+/*******************************************************************************
+* TeensyICM20948
+*******************************************************************************/
+struct inv_icm20948 *icm20948_instance = nullptr;
+
+static hal::Noise icm_noise(0x49434D32);
+
+static float icmNoise() {
+  return hal::icm20948.noise * icm_noise.next(1000) / 1000.0f;
+}
+
+bool TeensyICM20948::init() {
+  next_quat_us = next_raw_us = 0;
+  frame_head = frame_count = 0;
+  return hal::icm20948.present;
+}
+bool TeensyICM20948::connected() { return hal::icm20948.present; }
+
+// the DMP always has a fresh sample when we ask
+void TeensyICM20948::task() {
+  if (!hal::icm20948.present) return;
+  const hal::Icm20948Model &m = hal::icm20948;
+  accel_x = m.acc[0] + icmNoise(); accel_y = m.acc[1] + icmNoise(); accel_z = m.acc[2] + icmNoise();
+  gyro_x  = m.gyr[0] + icmNoise(); gyro_y  = m.gyr[1] + icmNoise(); gyro_z  = m.gyr[2] + icmNoise();
+  mag_x   = m.mag[0] + icmNoise(); mag_y   = m.mag[1] + icmNoise(); mag_z   = m.mag[2] + icmNoise();
+  quat_w  = m.quat[0]; quat_x = m.quat[1]; quat_y = m.quat[2]; quat_z = m.quat[3];
+  accel_data_ready = gyro_data_ready = mag_data_ready = quat_data_ready = true;
+
+  if (!settings.buffer_frames) return;
+
+  // everything the DMP put out since the last task(), stamped like the library does, on
+  // micros(). Raw outputs are in the library's LSB: 2000 dps and 16 g full scale
+  uint64_t now = hal::now();
+  uint64_t quat_period = 1000000 / settings.quaternion_frequency;
+  uint64_t raw_period  = 1000000 / settings.gyroscope_frequency;
+  if (next_quat_us == 0) next_quat_us = now;
+  if (next_raw_us == 0) next_raw_us = now;
+  // in time order, like the DMP's FIFO packets: raw outputs first, then the quaternion
+  while (next_raw_us <= now || next_quat_us <= now) {
+    if (next_raw_us <= next_quat_us) {
+      if (settings.enable_raw_gyroscope) {
+        TeensyICM20948Frame *f = pushFrame(ICM_FRAME_RAW_GYRO, (uint32_t) next_raw_us);
+        for (int i = 0; i < 3; i++) f->raw[i] = lroundf((m.gyr[i] + icmNoise()) * 16.384f);
+      }
+      if (settings.enable_raw_accelerometer) {
+        TeensyICM20948Frame *f = pushFrame(ICM_FRAME_RAW_ACCEL, (uint32_t) next_raw_us);
+        for (int i = 0; i < 3; i++) f->raw[i] = lroundf((m.acc[i] + icmNoise()) * 2048);
+      }
+      next_raw_us += raw_period;
+    } else {
+      if (settings.enable_quaternion) {
+        TeensyICM20948Frame *f = pushFrame(ICM_FRAME_QUAT, (uint32_t) next_quat_us);
+        memcpy(f->quat, m.quat, sizeof(f->quat));
+      }
+      next_quat_us += quat_period;
+    }
+  }
+}
+
+TeensyICM20948Frame *TeensyICM20948::pushFrame(uint8_t type, uint64_t timestamp) {
+  if (frame_count == ICM_FRAME_BUFFER) {
+    frame_head = (frame_head + 1) % ICM_FRAME_BUFFER;
+    frame_count--;
+    frame_overflows++;
+  }
+  TeensyICM20948Frame *f = &frames[(frame_head + frame_count++) % ICM_FRAME_BUFFER];
+  f->timestamp = timestamp;
+  f->type = type;
+  return f;
+}
+
+int TeensyICM20948::readFrames(TeensyICM20948Frame *out, int max) {
+  int n = 0;
+  while (n < max && frame_count > 0) {
+    out[n++] = frames[frame_head];
+    frame_head = (frame_head + 1) % ICM_FRAME_BUFFER;
+    frame_count--;
+  }
+  return n;
+}
+
+void TeensyICM20948::readGyroData(float *x, float *y, float *z) {
+  *x = gyro_x; *y = gyro_y; *z = gyro_z;
+  gyro_data_ready = false;
+}
+
+void TeensyICM20948::readAccelData(float *x, float *y, float *z) {
+  *x = accel_x; *y = accel_y; *z = accel_z;
+  accel_data_ready = false;
+}
+
+void TeensyICM20948::readMagData(float *x, float *y, float *z) {
+  *x = mag_x; *y = mag_y; *z = mag_z;
+  mag_data_ready = false;
+}
+
+void TeensyICM20948::readQuatData(float *w, float *x, float *y, float *z) {
+  *w = quat_w; *x = quat_x; *y = quat_y; *z = quat_z;
+  quat_data_ready = false;
+}
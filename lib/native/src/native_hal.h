@@ -0,0 +1,100 @@
+// Simulation side of the native HAL
+//
+// The Arduino-facing headers (Arduino.h, SPI.h, Wire.h, SdFat.h, ...) only give the code
+// under test what it would see on the Teensy. Everything a test harness needs to drive
+// that code from the outside lives here: the clock, pins and interrupts, and the device
+// models hanging off the SPI and I2C buses and the serial ports.
+//
+// Devices are register-level: an SPI device sees every byte clocked while its chip select
+// is low, an I2C device sees the bytes of every transaction addressed to it. Models for
+// the actual sensors are in native_models.h.
+
+#ifndef NATIVE_HAL_H
+#define NATIVE_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class SPIClass;
+class HardwareSerial;
+
+namespace hal {
+
+/*******************************************************************************
+* Clock
+*
+*   REAL_TIME: micros() follows the host's steady clock, what you want for perf
+*   and for anything that measures how long the code takes.
+*   STEPPED: time only moves when advance() is called, runs are repeatable and
+*   go as fast as the host can go.
+*
+*   delay() never sleeps in either mode, it moves the clock forward instead, so
+*   setup() doesn't spend seconds waiting on hardware that isn't there.
+*
+*******************************************************************************/
+enum ClockMode { REAL_TIME, STEPPED };
+
+void     setClockMode(ClockMode mode);
+void     advance(uint64_t us);
+uint64_t now(); // us since start, never wraps (micros() does, like on the Teensy)
+
+// time taken by something that isn't really there (a slow SD write...). Burnt on a busy
+// wait in REAL_TIME so it shows up in profiles, just skipped over when STEPPED
+void spend(uint64_t us);
+
+/*******************************************************************************
+* Pins
+*******************************************************************************/
+void setAnalog(int pin, int value); // what analogRead() returns, 0 by default
+int  pinLevel(int pin);             // last digitalWrite()
+void trigger(int pin);              // fire the ISR attached to pin, if any, on the calling thread
+
+/*******************************************************************************
+* Timers
+*
+*   IntervalTimer callbacks are PIT interrupts on the Teensy. Here they fire from
+*   runTimers(), once for every period that has gone by, on the calling thread,
+*   so the harness decides where in the loop the interrupt lands.
+*
+*******************************************************************************/
+void runTimers();
+
+/*******************************************************************************
+* Bus devices
+*******************************************************************************/
+
+// A device on an SPI bus, selected by its (active low) chip select pin
+class SpiDevice {
+  public:
+    virtual ~SpiDevice() {}
+    virtual void    select()   {}
+    virtual uint8_t transfer(uint8_t out) = 0;
+    virtual void    deselect() {}
+};
+
+// A device on an I2C bus. write() is one whole write transaction, read() one whole read.
+// Return false / 0 to NACK
+class I2cDevice {
+  public:
+    virtual ~I2cDevice() {}
+    virtual bool   write(const uint8_t *data, size_t len) = 0;
+    virtual size_t read(uint8_t *data, size_t len) = 0;
+};
+
+// Whatever is on the other end of a serial port. received() gets every byte the code
+// writes (with the port, for its baud), pump() is called whenever the code looks at the
+// port and can push bytes into it with HardwareSerial::feed()
+class SerialDevice {
+  public:
+    virtual ~SerialDevice() {}
+    virtual void received(HardwareSerial &port, uint8_t b) { (void) port; (void) b; }
+    virtual void pump(HardwareSerial &port, uint64_t now_us) = 0;
+};
+
+void attachSpi(SPIClass &bus, int cs_pin, SpiDevice *device);
+void attachI2c(uint8_t address, I2cDevice *device); // there is only one I2C bus (Wire)
+void attachSerial(HardwareSerial &port, SerialDevice *device);
+
+}
+
+#endif
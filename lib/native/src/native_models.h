@@ -0,0 +1,422 @@
+// Register-level fakes of the flight computer's sensors
+//
+// Each model answers on its bus the way the chip does as far as the drivers we use care:
+// chip IDs, resets, the data registers and (BMP390) calibration. The data registers are
+// refreshed from the public fields at the start of every read burst, plus a little noise
+// so the health monitor doesn't think the sensor is stuck. A harness (or a replay) moves
+// the fields around; `present = false` unplugs a chip, SPI then reads 0xFF and I2C NACKs.
+//
+// The models are not attached to anything on their own, the pins and addresses belong to
+// the code under test, see main-native.cpp.
+
+#ifndef NATIVE_MODELS_H
+#define NATIVE_MODELS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <Packets.h>
+#include <UbxParser.h>
+#include "native_hal.h"
+
+namespace hal {
+
+// xorshift, so runs are repeatable
+class Noise {
+  public:
+    explicit Noise(uint32_t seed) : state(seed) {}
+    // uniform in [-amplitude, amplitude]
+    int32_t next(int32_t amplitude) {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return amplitude ? (int32_t) (state % (2 * amplitude + 1)) - amplitude : 0;
+    }
+  private:
+    uint32_t state;
+};
+
+/*******************************************************************************
+* Register files and bus framing
+*******************************************************************************/
+class RegisterFile {
+
+  public:
+
+    virtual ~RegisterFile() {}
+
+    bool    present = true;
+    uint8_t regs[256] = {};
+
+  protected:
+
+    virtual void    beginRead(uint8_t reg) { (void) reg; } // a read burst starts at reg
+    virtual uint8_t readRegister(uint8_t reg)              { return regs[reg]; }
+    virtual void    writeRegister(uint8_t reg, uint8_t v)  { regs[reg] = v; }
+    virtual uint8_t nextAddress(uint8_t reg)               { return reg + 1; } // auto increment
+
+    // true if a burst starting at reg runs over any of [first, last]
+    static bool covers(uint8_t reg, uint8_t first, uint8_t last) { return reg <= last && reg + 32 > first; }
+
+};
+
+// First byte is the register address, MSB set for a read. inc_bit is the chip's auto
+// increment bit in the address byte, 0 if it always increments. Reads on chips with a
+// dummy byte answer it with 0. With pair_writes every data byte is followed by the
+// next address (BMP3), otherwise writes increment like reads
+class SpiRegisterDevice : public SpiDevice, public RegisterFile {
+
+  public:
+
+    SpiRegisterDevice(uint8_t inc_bit, uint8_t dummy_bytes, bool pair_writes)
+      : inc_bit(inc_bit), dummy_bytes(dummy_bytes), pair_writes(pair_writes) {}
+
+    void select() override { phase = ADDRESS; }
+
+    uint8_t transfer(uint8_t out) override {
+      if (!present) return 0xFF;
+      switch (phase) {
+        case ADDRESS:
+          reading = out & 0x80;
+          address = out & ~(0x80 | inc_bit);
+          increment = inc_bit == 0 || (out & inc_bit);
+          dummies = reading ? dummy_bytes : 0;
+          phase = DATA;
+          if (reading) beginRead(address);
+          return 0;
+        case DATA:
+          if (dummies) {
+            dummies--;
+            return 0;
+          }
+          if (reading) {
+            uint8_t v = readRegister(address);
+            if (increment) address = nextAddress(address);
+            return v;
+          }
+          writeRegister(address, out);
+          if (pair_writes) phase = ADDRESS;
+          else if (increment) address = nextAddress(address);
+          return 0;
+      }
+      return 0;
+    }
+
+  private:
+
+    enum { ADDRESS, DATA } phase = ADDRESS;
+
+    uint8_t inc_bit;
+    uint8_t dummy_bytes;
+    bool    pair_writes;
+
+    bool    reading   = false;
+    bool    increment = false;
+    uint8_t address   = 0;
+    uint8_t dummies   = 0;
+
+};
+
+// A write sets the register pointer with its first byte and writes the rest from there,
+// a read starts at the pointer. Both auto increment
+class I2cRegisterDevice : public I2cDevice, public RegisterFile {
+
+  public:
+
+    bool write(const uint8_t *data, size_t len) override {
+      if (!present) return false;
+      if (len == 0) return true; // address probe
+      pointer = data[0];
+      for (size_t i = 1; i < len; i++) {
+        writeRegister(pointer, data[i]);
+        pointer = nextAddress(pointer);
+      }
+      return true;
+    }
+
+    size_t read(uint8_t *data, size_t len) override {
+      if (!present) return 0;
+      beginRead(pointer);
+      for (size_t i = 0; i < len; i++) {
+        data[i] = readRegister(pointer);
+        pointer = nextAddress(pointer);
+      }
+      return len;
+    }
+
+  private:
+
+    uint8_t pointer = 0;
+
+};
+
+/*******************************************************************************
+* LSM6DSO32, I2C. Raw counts, 32 g range is 0.976 mg/LSB
+*
+*   The FIFO is modelled in continuous mode: gyro and accel words every slot at
+*   the gyro's BDR, timestamp words as DEC_TS_BATCH says, and the oldest words
+*   overwritten when it is full. The chip runs on its own oscillator, clock_ppm
+*   off from ours, which its timestamps and slot times both follow.
+*
+*******************************************************************************/
+class Lsm6dso32Model : public I2cRegisterDevice {
+
+  public:
+
+    Lsm6dso32Model() { reset(); }
+
+    int16_t acc[3] = {0, 0, 1024};
+    int16_t gyr[3] = {0, 0, 0};
+    int16_t temp   = 0;      // 256 LSB/degree around 25 C
+    int32_t noise_lsb = 4;
+    int32_t clock_ppm = 0;
+
+    uint32_t getFifoSlots()     const { return fifo_slots; }
+    uint32_t getFifoOverwrites() const { return fifo_overwrites; }
+
+  protected:
+
+    void reset();
+    void writeRegister(uint8_t reg, uint8_t v) override;
+    void beginRead(uint8_t reg) override;
+    uint8_t readRegister(uint8_t reg) override;
+    // FIFO_DATA_OUT_Z_H wraps back to FIFO_DATA_OUT_TAG, so a burst reads word after word
+    uint8_t nextAddress(uint8_t reg) override { return reg == 0x7E ? 0x78 : reg + 1; }
+
+  private:
+
+    static const int FIFO_WORDS = 512;
+
+    void put(uint8_t reg, int32_t v) {
+      regs[reg]     = v & 0xFF;
+      regs[reg + 1] = (v >> 8) & 0xFF;
+    }
+
+    double chipTime() const; // us on the chip's oscillator since reset
+    void   fillFifo();
+    void   pushWord(uint8_t tag, const uint8_t *data);
+
+    Noise noise = Noise(0x4C534D36);
+
+    uint64_t reset_us = 0;
+    uint8_t  fifo[FIFO_WORDS][7];
+    int      fifo_head  = 0; // oldest word
+    int      fifo_count = 0;
+    bool     fifo_ovr   = false;
+    bool     fifo_on    = false;
+    double   next_slot  = 0; // chip time of the next slot
+    uint32_t slot       = 0;
+    uint32_t fifo_slots = 0;
+    uint32_t fifo_overwrites = 0;
+
+};
+
+/*******************************************************************************
+* ADXL375, SPI. Raw counts, 49 mg/LSB
+*
+*   With FIFO_CTL in FIFO/stream mode samples pile up at the BW_RATE ODR on the
+*   chip's own (clock_ppm off) oscillator, the data registers show the oldest one
+*   and reading DATAZ1 pops it, like the real chip.
+*
+*******************************************************************************/
+class Adxl375Model : public SpiRegisterDevice {
+
+  public:
+
+    Adxl375Model() : SpiRegisterDevice(0x40, 0, false) {
+      regs[0x00] = 0xE5; // DEVID
+      regs[0x2C] = 0x0A; // BW_RATE, 100 Hz
+      regs[0x30] = 0x02; // INT_SOURCE
+    }
+
+    int16_t acc[3] = {0, 0, 20};
+    int32_t noise_lsb = 2;
+    int32_t clock_ppm = 0;
+
+    uint32_t getFifoSamples()    const { return fifo_samples; }
+    uint32_t getFifoOverwrites() const { return fifo_overwrites; }
+
+  protected:
+
+    void writeRegister(uint8_t reg, uint8_t v) override;
+    void beginRead(uint8_t reg) override;
+    uint8_t readRegister(uint8_t reg) override;
+
+  private:
+
+    static const int FIFO_SAMPLES = 32;
+
+    bool   fifoOn() const { return regs[0x38] >> 6; }
+    double chipTime() const; // us on the chip's oscillator
+    void   fillFifo();
+
+    Noise noise = Noise(0x41445833);
+
+    int16_t  fifo[FIFO_SAMPLES][3];
+    int      fifo_head  = 0; // oldest sample
+    int      fifo_count = 0;
+    double   next_sample = 0; // chip time of the next sample
+    uint32_t fifo_samples    = 0;
+    uint32_t fifo_overwrites = 0;
+
+};
+
+/*******************************************************************************
+* BMP390, SPI with one dummy byte on reads
+*
+*   The calibration is made up so compensation is linear: temperature is
+*   (raw - T1 * 2^8) * T2 / 2^30 and pressure is raw * (P1 - 2^14) / 2^20, every
+*   other coefficient is zero. The driver still runs the full compensation.
+*
+*   With FIFO_CONFIG_1 on, frames pile up at the ODR on the chip's own (clock_ppm
+*   off) oscillator, on whole ODR periods of its 25.6 kHz sensor time. A read of
+*   FIFO_DATA stays on that register and pops bytes, once the FIFO is empty it
+*   gets a sensor time frame (if enabled) and then empty frames.
+*
+*******************************************************************************/
+class Bmp390Model : public SpiRegisterDevice {
+
+  public:
+
+    static const uint16_t PAR_T1 = 27000;
+    static const uint16_t PAR_T2 = 19000;
+    static const int16_t  PAR_P1 = 16384 + 13281;
+
+    Bmp390Model() : SpiRegisterDevice(0, 1, true) { reset(); }
+
+    double  pressure    = 101325; // Pa
+    double  temperature = 25;     // C
+    int32_t noise_lsb   = 200;    // raw pressure counts, about 2.5 Pa
+    int32_t clock_ppm   = 0;
+
+    uint32_t getFifoFrames()     const { return fifo_frames; }
+    uint32_t getFifoOverwrites() const { return fifo_overwrites; }
+
+  protected:
+
+    void reset();
+    void writeRegister(uint8_t reg, uint8_t v) override;
+    void beginRead(uint8_t reg) override;
+    uint8_t readRegister(uint8_t reg) override;
+    uint8_t nextAddress(uint8_t reg) override { return reg == 0x14 ? reg : reg + 1; }
+
+  private:
+
+    static const int FIFO_BYTES = 512;
+
+    void   sample(uint32_t &p, uint32_t &t); // raw ADC words
+    double ticks() const;                    // sensor time, 25.6 kHz on the chip's oscillator
+    void   fillFifo();
+    void   flushFifo();
+
+    Noise noise = Noise(0x424D5033);
+
+    uint8_t  fifo[FIFO_BYTES];
+    int      fifo_head  = 0; // oldest byte
+    int      fifo_count = 0;
+    double   next_frame = 0; // sensor time of the next frame
+    uint8_t  time_frame[4];
+    int      time_left  = 0; // bytes of time_frame still to be read
+    uint32_t fifo_frames     = 0;
+    uint32_t fifo_overwrites = 0;
+
+};
+
+/*******************************************************************************
+* ICM-20948, what the TeensyICM20948 stand-in reports. Units are the library's
+* (g, dps, uT)
+*******************************************************************************/
+struct Icm20948Model {
+  bool  present = true;
+  float acc[3]  = {0, 0, 1};
+  float gyr[3]  = {0, 0, 0};
+  float mag[3]  = {20, -5, -40};
+  float quat[4] = {1, 0, 0, 0};
+  float noise   = 0.2; // on every axis, the DMP output is never exactly the same twice
+};
+
+/*******************************************************************************
+* u-blox receiver on a serial port. Starts out like one from the factory: 9600
+* baud, an NMEA sentence every 1 s measurement, NAV-PVT off. Understands what
+* UbxGpsConfig sends and ACKs or NAKs it (answers at the baud it is at, a port at
+* another baud gets garbage both ways):
+*
+*   MON-VER poll    the version
+*   CFG-PRT         baud (NAK over max_baud, switches after the ACK), NMEA out
+*   CFG-RATE        measurement period (NAK under min_period_ms)
+*   CFG-MSG         NAV-PVT on or off, anything else is ACKed and ignored
+*   CFG-GNSS/CFG-CFG ACKed
+*
+* The fields are the script: set them up front (or between steps) to play a
+* receiver left configured by the last boot, one that can't go fast, a link that
+* garbles what the receiver sends above some baud, lost ACKs...
+*******************************************************************************/
+class UbloxModel : public SerialDevice {
+
+  public:
+
+    bool     present       = true;
+    uint32_t baud          = 9600;
+    uint32_t period_us     = 1000000;
+    bool     nmea          = true;
+    bool     pvt_on        = false;
+    uint32_t max_baud      = 921600;
+    uint32_t link_max_baud = 0;     // above this what the receiver sends arrives garbled, 0 for no limit
+    uint16_t min_period_ms = 100;   // a u-blox 7 does 10 Hz at most
+    uint32_t drop_acks     = 0;     // the next ones are lost on the way
+    NavPvtPacket pvt;               // payload of every frame, iTOW and nano are set by the model
+
+    // GPS time is gps_start_ns at hal::now() 0, our clock runs drift_ppb faster. Epochs are on
+    // the GPS time grid, each one goes out latency_us plus up to jitter_us later. pps_pin gets
+    // a trigger() at every GPS second
+    uint64_t gps_start_ns  = (2310 * 604800ULL + 576000) * 1000000000; // Sat 20 Apr 2024 16:00
+    int32_t  drift_ppb     = 25000;
+    uint32_t latency_us    = 30000;
+    uint32_t jitter_us     = 5000;
+    int8_t   leap_s        = 18;
+    int      pps_pin       = -1;
+
+    UbloxModel();
+
+    // back to the factory state, keeps the position
+    void reset();
+
+    void received(HardwareSerial &port, uint8_t b) override;
+    void pump(HardwareSerial &port, uint64_t now_us) override;
+
+    uint32_t getFrameCount() const { return frames; }
+    uint64_t getRxBytes()    const { return rx_bytes; } // bytes the code sent us
+    uint32_t getCommands()   const { return commands; } // good frames in them
+
+  private:
+
+    static void onCommand(const UbxFrame &frame, void *context);
+    void command(const UbxFrame &frame);
+    void send(uint8_t cls, uint8_t id, const void *payload, uint16_t len);
+    void ack(const UbxFrame &frame, bool ok);
+    uint64_t gpsNs(uint64_t us) const; // GPS time at our time us
+    uint64_t ourUs(uint64_t ns) const; // and back
+
+    HardwareSerial *port = nullptr;
+    UbxParser<64>   parser;
+
+    bool     started    = false;
+    bool     timegps_on = false;
+    uint64_t epoch_ns   = 0; // GPS time of the next epoch, and our time it goes out at
+    uint64_t out_us     = 0;
+    uint64_t pps_ns     = 0; // GPS time of the next PPS edge
+    Noise    noise      = Noise(0x55424C58);
+    uint32_t frames     = 0;
+    uint64_t rx_bytes   = 0;
+    uint32_t commands   = 0;
+
+};
+
+extern Lsm6dso32Model lsm6dso32;
+extern Adxl375Model   adxl375;
+extern Bmp390Model    bmp390;
+extern Icm20948Model  icm20948;
+extern UbloxModel     ublox;
+
+}
+
+#endif
@@ -0,0 +1,108 @@
+// In-memory SD card of the native HAL
+
+#include <errno.h>
+#include <sys/stat.h>
+#include "SdFat.h"
+
+namespace hal {
+
+SdCard &SdCard::instance() {
+  static SdCard card;
+  return card;
+}
+
+std::vector<uint8_t> *SdCard::find(const std::string &name) {
+  std::lock_guard<std::mutex> guard(lock);
+  auto f = files.find(name);
+  return f == files.end() ? nullptr : &f->second;
+}
+
+std::vector<uint8_t> *SdCard::create(const std::string &name) {
+  std::lock_guard<std::mutex> guard(lock);
+  return &files[name];
+}
+
+bool SdCard::remove(const std::string &name) {
+  std::lock_guard<std::mutex> guard(lock);
+  return files.erase(name) != 0;
+}
+
+bool SdCard::save(const char *dir) {
+  if (mkdir(dir, 0755) != 0 && errno != EEXIST) return false;
+  std::lock_guard<std::mutex> guard(lock);
+  bool ok = true;
+  for (auto &f : files) {
+    std::string path = std::string(dir) + "/" + f.first;
+    FILE *out = fopen(path.c_str(), "wb");
+    if (!out) {
+      ok = false;
+      continue;
+    }
+    ok &= fwrite(f.second.data(), 1, f.second.size(), out) == f.second.size();
+    ok &= fclose(out) == 0;
+  }
+  return ok;
+}
+
+}
+
+static void writeCost(size_t bytes) {
+  uint32_t cost = hal::SdCard::instance().write_us_per_sector;
+  if (cost) hal::spend((uint64_t) cost * ((bytes + 511) / 512));
+}
+
+bool FsFile::open(const char *path, oflag_t oflag) {
+  hal::SdCard &card = hal::SdCard::instance();
+  if (!card.inserted) return false;
+  data = card.find(path);
+  if (!data) {
+    if (!(oflag & O_CREAT)) return false;
+    data = card.create(path);
+  } else if (oflag & O_TRUNC) {
+    data->clear();
+  }
+  writable = (oflag & O_ACCMODE) != O_RDONLY;
+  position = (oflag & O_APPEND) ? data->size() : 0;
+  return true;
+}
+
+size_t FsFile::write(const uint8_t *buffer, size_t size) {
+  if (!isOpen() || !writable) return 0;
+  if (position + size > data->size()) data->resize(position + size);
+  memcpy(data->data() + position, buffer, size);
+  position += size;
+  writeCost(size);
+  return size;
+}
+
+int FsFile::read(void *buffer, size_t size) {
+  if (!isOpen()) return -1;
+  size_t n = position < data->size() ? data->size() - position : 0;
+  if (n > size) n = size;
+  memcpy(buffer, data->data() + position, n);
+  position += n;
+  return n;
+}
+
+int FsFile::read() {
+  uint8_t b;
+  return read(&b, 1) == 1 ? b : -1;
+}
+
+int FsFile::peek() {
+  if (!isOpen() || position >= data->size()) return -1;
+  return (*data)[position];
+}
+
+bool FsFile::truncate(uint64_t length) {
+  if (!isOpen() || !writable) return false;
+  if (length < data->size()) data->resize(length);
+  if (position > length) position = length;
+  return true;
+}
+
+bool FsFile::seekSet(uint64_t pos) {
+  if (!isOpen() || pos > data->size()) return false;
+  position = pos;
+  return true;
+}
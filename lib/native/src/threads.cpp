@@ -0,0 +1,42 @@
+// TeensyThreads on std::thread
+
+#include <atomic>
+#include <thread>
+#include "Arduino.h"
+#include "TeensyThreads.h"
+
+Threads threads;
+
+static std::atomic<bool> stopping{false};
+static std::atomic<int>  running{0};
+static std::atomic<int>  parked{0};
+
+int Threads::addThread(ThreadFunction p, void *arg, int stack_size, void *stack) {
+  (void) stack_size;
+  (void) stack;
+  running++;
+  std::thread([p, arg] {
+    p(arg);
+    running--;
+  }).detach();
+  return running;
+}
+
+void Threads::yield() {
+  if (!stopping) {
+    std::this_thread::yield();
+    return;
+  }
+  parked++;
+  for (;;) std::this_thread::sleep_for(std::chrono::seconds(1));
+}
+
+void Threads::delay(int millisecond) {
+  uint32_t start = millis();
+  while (millis() - start < (uint32_t) millisecond) yield();
+}
+
+void Threads::stop() {
+  stopping = true;
+  while (parked < running) std::this_thread::yield();
+}
@@ -2,6 +2,7 @@
 
 Shart::Shart() {
   // meow
+  for (SensorHealth &h : health) h.setProbeInterval(HEALTH_PROBE_INTERVAL_US);
 }
 
 // Initialize some stuff plus everything on shart
@@ -19,13 +20,18 @@ void Shart::init() {
   initLSM6DSO32();
   initBMP388();
   initADXL375();
+  initScheduler();
 
-  
   initGTU7();
   #ifndef START_ON_POWERUP
   awaitStart();
   #endif
 
+  #ifdef STORAGE_THREAD
+  storage_started = true; // from here on MAIN_SERIAL_PORT belongs to the storage thread
+  threads.addThread(storageThread, this, STORAGE_THREAD_STACK);
+  #endif
+
 }
 
 // Wait until we receive a start command packet
@@ -35,6 +41,8 @@ void Shart::awaitStart() {
 
   for (;;) {
 
+    if (!gps_started) configureGTU7(); // the receiver gets set up while we wait
+
     RECEIVE_PACKET(command_packet, MAIN_SERIAL_PORT, packet_received)
     if (packet_received && command_packet.data.command == START_COMMAND) return; 
 
@@ -44,30 +52,104 @@ void Shart::awaitStart() {
 
 void Shart::collect() {
 
-  // Get time since program start in us
-  collectTime();
+  // 64 bit time since start, the sensors' sample times below are extended from it
+  clock.update(micros() - chipTimeOffset);
+
+  // Only touch a sensor when sampleDue() says so. Reads that run on their own (ASYNC_I2C,
+  // ASYNC_SPI) are started first, the blocking ones are done while they run, and then the
+  // async ones are finished. The ICM goes last, it shares SPI1 with the BMP
+  #ifdef LSM_ASYNC
+  bool lsm_read = sampleDue(LSM_SLOT);
+  if (lsm_read) lsm.startRaw();
+  #endif
+  #ifdef ADXL_ASYNC
+  bool adxl_read = sampleDue(ADXL_SLOT);
+  if (adxl_read) adxl.startXYZ();
+  #endif
+  #ifdef BMP_ASYNC
+  bool bmp_read = sampleDue(BMP_SLOT);
+  if (bmp_read) bmp.startReading();
+  #endif
+
+  #ifndef LSM_ASYNC
+  if (sampleDue(LSM_SLOT))  PROFILE(profiler, PROFILE_COLLECT_LSM,  collectDataLSM6DSO32())
+  #endif
+  #ifndef ADXL_ASYNC
+  if (sampleDue(ADXL_SLOT)) PROFILE(profiler, PROFILE_COLLECT_ADXL, collectDataADXL375())
+  #endif
+  #ifndef BMP_ASYNC
+  if (sampleDue(BMP_SLOT))  PROFILE(profiler, PROFILE_COLLECT_BMP,  collectDataBMP388())
+  #endif
+
+  #ifdef ADXL_ASYNC
+  if (adxl_read) PROFILE(profiler, PROFILE_COLLECT_ADXL, collectDataADXL375())
+  #endif
+  #ifdef BMP_ASYNC
+  if (bmp_read)  PROFILE(profiler, PROFILE_COLLECT_BMP,  collectDataBMP388())
+  #endif
+  #ifdef LSM_ASYNC
+  if (lsm_read)  PROFILE(profiler, PROFILE_COLLECT_LSM,  collectDataLSM6DSO32())
+  #endif
 
-  // Only collect data when sensors are marked as AVAILABLE
-  updateStatusICM20948();  if (ICMStatus  == AVAILABLE) collectDataICM20948();
-  updateStatusBMP388();    if (BMPStatus  == AVAILABLE) collectDataBMP388();
-  updateStatusADXL375();   if (ADXLStatus == AVAILABLE) collectDataADXL375();
-  updateStatusLSM6DSO32(); if (LSMStatus  == AVAILABLE) collectDataLSM6DSO32();
-  collectDataGTU7(); // GPS status doesn't matter here
+  if (sampleDue(ICM_SLOT))  PROFILE(profiler, PROFILE_COLLECT_ICM,  collectDataICM20948())
+  PROFILE(profiler, PROFILE_COLLECT_GPS, collectDataGTU7()) // GPS status doesn't matter here, bytes are buffered by the UART
 
+  collectTime();
   setStatusByte();
 
 }
 
 void Shart::send() {
 
-  // Generate checksums for each packet
-  CHECKSUM(sensor_packet)
-  CHECKSUM(gps_packet)
-
+  // ahead of the sensor packets that need it
+  if (sensor_ready) sendBaroCalib();
+  sendTimeSync();
+
+  // Generate checksums for the packets that actually go out
+  if (sensor_ready) CHECKSUM(sensor_packet)
+  if (gps_ready) CHECKSUM(gps_packet)
+
+  #ifdef STORAGE_THREAD
+  // hand everything to the storage thread, nothing in here can block on the SD card
+  uint32_t start = micros();
+  if (sensor_ready) queuePacket(&sensor_packet, sizeof(sensor_p), sensor_packet_counter++ % RADIO_SEND_EVERY_N == 0);
+  if (gps_ready) queuePacket(&gps_packet, sizeof(gps_p), true);
+  #ifdef BATCH_MODE
+  while (imu_batch_p *full = imu_batches.takeFull()) {
+    imu_batch_p &batch = *full;
+    BATCH_CHECKSUM(batch)
+    queuePacket(&batch, batchLength(batch), false);
+  }
+  while (highg_batch_p *full = highg_batches.takeFull()) {
+    highg_batch_p &batch = *full;
+    BATCH_CHECKSUM(batch)
+    queuePacket(&batch, batchLength(batch), false);
+  }
+  while (baro_batch_p *full = baro_batches.takeFull()) {
+    baro_batch_p &batch = *full;
+    BATCH_CHECKSUM(batch)
+    queuePacket(&batch, batchLength(batch), false);
+  }
+  while (icm_batch_p *full = icm_batches.takeFull()) {
+    icm_batch_p &batch = *full;
+    BATCH_CHECKSUM(batch)
+    queuePacket(&batch, batchLength(batch), false);
+  }
+  #endif
+  send_latency.add(micros() - start);
+  #ifdef DEBUG_MODE_STATUS
+  queueStorageStats();
+  #endif
+  #else
   // Write to flash, send to radio
-  if (SDStatus != PERMANENTLY_UNAVAILABLE) saveData();
-  transmitData(); // check radio status?
-  // set gps_ready flag to false no matter what to make sure we don't send the same data twice
+  if (SDStatus != PERMANENTLY_UNAVAILABLE) PROFILE(profiler, PROFILE_SAVE, saveData())
+  PROFILE(profiler, PROFILE_TRANSMIT, transmitData()) // check radio status?
+  #endif
+  #ifdef DEBUG_MODE_DATARATE
+  sendProfile();
+  #endif
+  // clear the ready flags no matter what to make sure we don't send the same data twice
+  sensor_ready = false;
   gps_ready = false;
 
 }
@@ -77,10 +159,12 @@ void Shart::reconnect() {
 
   #ifdef ATTEMPT_RECONNECT
   // reconnect storage and sensors
-  if (getStatusBMP388()    == UNINITIALIZED) initBMP388();
-  if (getStatusADXL375()   == UNINITIALIZED) initADXL375();
-  if (getStatusICM20948()  == UNINITIALIZED) initICM20948();
-  if (getStatusLSM6DSO32() == UNINITIALIZED) initLSM6DSO32();
+  PROFILE(profiler, PROFILE_RECONNECT, {
+    if (getStatusBMP388()    == UNINITIALIZED) initBMP388();
+    if (getStatusADXL375()   == UNINITIALIZED) initADXL375();
+    if (getStatusICM20948()  == UNINITIALIZED) initICM20948();
+    if (getStatusLSM6DSO32() == UNINITIALIZED) initLSM6DSO32();
+  })
 
   #endif
   
@@ -97,11 +181,22 @@ void Shart::threadedReconnect() {
 // stuff to do when Shart wraps up
 void Shart::maybeFinish() {
 
+  // the storage thread owns the file and the serial port, it checks for the stop command itself
+  #ifndef STORAGE_THREAD
+  checkStopCommand();
+  #endif
+
+}
+
+// close the log and start a new one when the ground station says stop
+void Shart::checkStopCommand() {
+
   bool packet_received;
 
   RECEIVE_PACKET(command_packet, MAIN_SERIAL_PORT, packet_received)
 
   if (packet_received && command_packet.data.command == STOP_COMMAND && SDStatus == AVAILABLE) {
+    rb.sync(); // the last partial sector, truncate() would cut it off
     file.truncate();
     file.close();
     sd.end();
@@ -134,6 +229,9 @@ void Shart::setStatusByte() {
   sensor_packet.data.status |= (LSMStatus == AVAILABLE)  << LSM_STATUS_OFFSET;
   sensor_packet.data.status |= (SDStatus == AVAILABLE)   << SD_STATUS_OFFSET;
   sensor_packet.data.status |= (analogRead(41) > 712) << PYRO_STATUS_OFFSET;
+  #ifdef RAW_BARO
+  sensor_packet.data.status |= RAW_BARO_FLAG;
+  #endif
   sensor_packet.data.reserved = sd_file_opened;
 }
 
@@ -158,11 +256,58 @@ void Shart::initPins() {
 
 }
 
-// get current chip time in milliseconds
+// Whether the sensor in slot gets read this loop: the scheduler has a new sample for it,
+// its chip ID was checked if the health monitor wanted a probe, and it is AVAILABLE. The
+// read is stamped with its DRDY edge, or with the due() check. Any due sensor counts
+// towards the sensor packet, read or not
+bool Shart::sampleDue(uint8_t slot) {
+
+  // each slot's probe, its profiler stage and the status it updates
+  static const struct {
+    void (Shart::*probe)();
+    uint8_t stage;
+    Status Shart::*status;
+  } sensors[NUM_SENSOR_SLOTS] = {
+    {&Shart::updateStatusLSM6DSO32, PROFILE_STATUS_LSM,  &Shart::LSMStatus},
+    {&Shart::updateStatusADXL375,   PROFILE_STATUS_ADXL, &Shart::ADXLStatus},
+    {&Shart::updateStatusBMP388,    PROFILE_STATUS_BMP,  &Shart::BMPStatus},
+    {&Shart::updateStatusICM20948,  PROFILE_STATUS_ICM,  &Shart::ICMStatus},
+  };
+
+  uint32_t now = micros();
+  if (!scheduler.due(slot, now)) return false;
+  sensor_ready = true;
+  if (health[slot].probeDue(now)) PROFILE(profiler, sensors[slot].stage, (this->*sensors[slot].probe)())
+  if (this->*sensors[slot].status != AVAILABLE) return false;
+  sample_us[slot] = sampleTime(slot);
+  return true;
+
+}
+
+// 64 bit time of the sample the scheduler last served slot for
+uint64_t Shart::sampleTime(uint8_t slot) {
+
+  return clock.extend(scheduler.getSampleTime(slot) - chipTimeOffset);
+
+}
+
+// how long before now a sensor's data in the packet was sampled, saturated to 16 bits
+static uint16_t sampleAge(uint64_t now, uint64_t sample) {
+
+  if (sample == 0 || now - sample >= 0xFFFF) return 0xFFFF;
+  return now - sample;
+
+}
+
+// stamp the sensor packet with the time it was put together and the age of each sensor's data
 void Shart::collectTime() {
 
-  // populate packets with current time minus offset from start
-  sensor_packet.data.us = micros() - chipTimeOffset;
-  gps_packet.data.us    = micros() - chipTimeOffset;
+  uint64_t now = clock.extend(micros() - chipTimeOffset);
+  sensor_packet.data.us       = (uint32_t) now;
+  sensor_packet.data.us_hi    = now >> 32;
+  sensor_packet.data.lsm_age  = sampleAge(now, sample_us[LSM_SLOT]);
+  sensor_packet.data.icm_age  = sampleAge(now, sample_us[ICM_SLOT]);
+  sensor_packet.data.bmp_age  = sampleAge(now, sample_us[BMP_SLOT]);
+  sensor_packet.data.adxl_age = sampleAge(now, sample_us[ADXL_SLOT]);
 
 }
\ No newline at end of file
@@ -36,8 +36,14 @@
 #ifndef SHART_H
 #define SHART_H
  
+#include <atomic>
 #include "shart/util/status_enums.h"
 #include "shart/util/debug.h"
+#include "shart/util/scheduler.h"
+#include "shart/util/health.h"
+#include "shart/util/flush.h"
+#include "shart/util/clock.h"
+#include "shart/util/baro_fixed.h"
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Preprocessor directives for SENSOR and GPS
@@ -46,12 +52,34 @@
 #include <Adafruit_ADXL375.h>
 #include <Teensy-ICM-20948.h>
 #include <Adafruit_LSM6DSO32.h>
-#include <UbloxGPS.h>
+#include <UbloxGps.h>
 #include <UbxGpsConfig.h>
 
 // GPS pins, not that these are RX and TX on the microcontroller, NOT the GTU7 (i.e. GTU_RX_PIN goes to the TX pin on the GTU)
 #define GPS_SERIAL_PORT Serial2
-#define GPS_BAUD_RATE   9600
+#define GPS_BAUD_RATES  460800, 230400, 115200, 38400, 9600 // tried fastest first, see UbxGpsConfig
+#define GPS_RATES_MS    50, 100, 200, 1000                   // measurement periods, fastest first
+#define GPS_PPS_PIN     NO_DRDY_PIN // the receiver's timepulse (PPS), NO_DRDY_PIN if it isn't wired
+
+// GPS time for our clock, see GpsClock and timesync_p
+#define GPS_CLOCK_WINDOW_US  10000000 // the best observation of each window is a point of the fit
+#define GPS_PPS_TIMEOUT_US   2000000  // no PPS edge for this long and the clock goes back to NAV-PVTs
+#define GPS_SYNC_INTERVAL_MS 1000     // how often a timesync packet goes out
+
+#ifdef GPS_ISR
+#include <IntervalTimer.h>
+#include <lockfree.h>
+#define GPS_RX_BUFFER_BYTES 1024 // added to the UART's receive ring, a second of bytes at 9600 baud
+#define GPS_ISR_PERIOD_US   1000 // how often the timer drains the ring into the parser
+#define GPS_ISR_PRIORITY    192  // below the UART (64) and the DRDY pins (128), lower is more urgent
+#define GPS_QUEUE_DEPTH     4    // solutions parsed but not picked up by collect() yet, power of two
+
+// A NAV-PVT parsed in the GPS timer ISR, waiting for collect()
+struct gps_solution {
+  uint32_t     rx_us; // micros() when its last byte was parsed
+  NavPvtPacket pvt;
+};
+#endif
 
 // SPI bus for BMP388, default SPI bus (shared)
 #define BMP_SPI_BUS  SPI1
@@ -65,6 +93,100 @@
 #define ICM_CS  38
 #define LSM_I2C_ADDR 106U
 
+// Data ready (INT) pins, NO_DRDY_PIN if the line isn't wired. Sensors without a pin
+// are read on a fixed period instead, see the sample periods below
+#define LSM_DRDY_PIN  NO_DRDY_PIN
+#define ADXL_DRDY_PIN NO_DRDY_PIN
+#define BMP_DRDY_PIN  NO_DRDY_PIN
+
+// Sample periods in microseconds. These must match the ODR each sensor is configured
+// with in sensors.cpp. With a DRDY pin they only act as a watchdog for a silent sensor
+#ifdef LSM_FIFO
+#define LSM_PERIOD_US  10000 // FIFO drain, ~8 samples at 833 Hz
+#else
+#define LSM_PERIOD_US  4808  // 208 Hz
+#endif
+#ifdef ADXL_FIFO
+#define ADXL_PERIOD_US 5000  // FIFO drain, 16 of the FIFO's 32 samples at 3200 Hz
+#else
+#define ADXL_PERIOD_US 10000 // 100 Hz, ADXL375 power-on BW_RATE
+#endif
+#ifdef BMP_FIFO
+#define BMP_PERIOD_US  20000 // FIFO drain, 4 frames at 200 Hz
+#else
+#define BMP_PERIOD_US  5000  // 200 Hz
+#endif
+#ifdef ICM_FIFO
+#define ICM_PERIOD_US  20000 // DMP FIFO drain, ~4 outputs of each kind at 225 Hz
+#else
+#define ICM_PERIOD_US  4444  // 225 Hz DMP output, the DMP has no DRDY line we use
+#endif
+
+// LSM6DSO32 FIFO streaming (LSM_FIFO). A drain reads everything that is waiting, up to
+// LSM_FIFO_MAX_SAMPLES (and what the IMU batches have room for with BATCH_MODE), so a loop
+// held up for less than the ~290 ms the FIFO holds at 833 Hz loses nothing. With LSM_DRDY_PIN
+// the pin is the FIFO watermark interrupt instead of data ready
+#define LSM_FIFO_RATE        LSM6DS_RATE_833_HZ
+#define LSM_FIFO_WATERMARK   32     // words, a sample is 2 words + a timestamp every 8
+#define LSM_FIFO_MAX_SAMPLES 256    // more than the FIFO's 512 words can hold
+#define LSM_FIFO_SLEW_PPM    1000   // how fast the LSM's clock can drift from ours, see SensorClock
+#ifdef ASYNC_I2C
+#define LSM_I2C_CLOCK        1000000 // Fast-mode Plus, the LSM6DSO32 does 1 MHz. Wants stiffer pull-ups (2.2k) than 400 kHz
+#else
+#define LSM_I2C_CLOCK        400000 // a drain is a few hundred bytes, 100 kHz is too slow for 833 Hz
+#endif
+
+// ADXL375 FIFO streaming (ADXL_FIFO). The FIFO only holds 10 ms at 3200 Hz, a loop held up
+// for longer than that loses the oldest samples. With ADXL_DRDY_PIN the pin is the watermark
+// interrupt instead of data ready
+#define ADXL_FIFO_RATE      ADXL3XX_DATARATE_3200_HZ
+#define ADXL_FIFO_PERIOD_NS 312500 // nominal, the real one is measured, see SampleClock
+#define ADXL_FIFO_WATERMARK 16     // samples
+#define ADXL_FIFO_SLEW_PPM  300    // the period is measured, what is left to follow is small
+#ifdef ADXL_FIFO
+#define ADXL_SPI_FREQ 5000000      // 3200 Hz needs 2 MHz or more, the ADXL375 goes up to 5
+#else
+#define ADXL_SPI_FREQ 1000000
+#endif
+
+// BMP390 FIFO (BMP_FIFO). The FIFO holds 73 frames, 365 ms at 200 Hz. With BMP_DRDY_PIN the
+// pin is the FIFO watermark interrupt instead of data ready
+#define BMP_FIFO_WATERMARK 4       // frames
+#define BMP_FIFO_PERIOD_NS 5000000 // nominal 200 Hz, the real one is measured, see SampleClock
+#define BMP_FIFO_SLEW_PPM  300
+
+// ICM-20948 DMP FIFO batching (ICM_FIFO). task() drains the whole DMP FIFO, the library
+// queues every quaternion and raw gyro/acc output with its DMP timestamp, up to
+// ICM_FRAME_BUFFER (64) frames, 95 ms of all three at 225 Hz
+#define ICM_DMP_RATE_HZ 225
+
+#if (defined(RAW_BARO) || defined(FIXED_BARO)) && defined(BMP_FIFO)
+#error "RAW_BARO and FIXED_BARO read the data registers, FIFO frames are compensated by the driver"
+#endif
+
+// Async SPI (ASYNC_SPI). The ADXL's and BMP's register reads go out by DMA, each on its own
+// bus, while the LSM is read over I2C. FIFO drains don't, they are too long for a
+// SPIDEVICE_ASYNC_MAX burst. The BMP read is done before the ICM's, they share SPI1
+#ifdef ASYNC_SPI
+#ifndef ADXL_FIFO
+#define ADXL_ASYNC
+#endif
+#ifndef BMP_FIFO
+#define BMP_ASYNC
+#endif
+#endif
+
+// Async I2C (ASYNC_I2C). The LSM's register read is run by the LPI2C interrupt on Wire, at
+// 1 MHz, while the SPI sensors are read. Not the FIFO drain (LSM_FIFO), it only gets the clock
+#if defined(ASYNC_I2C) && !defined(LSM_FIFO)
+#define LSM_ASYNC
+#endif
+
+#define SEA_LEVEL_PA 101325 // for the on-board altitude (FIXED_BARO)
+
+// Chip ID probes happen at most this often per sensor, unless a read looks wrong
+#define HEALTH_PROBE_INTERVAL_US 100000
+
 // LED pins (not implemented)
 #define ONBOARD_LED_PIN 13
 #define OK_LED_PIN 23
@@ -78,6 +200,15 @@
 #define ADXL_CHIP_ID 0xE5
 #define LSM_CHIP_ID  0x6C
 
+// Scheduler slots, when several sensors are due at once they are read in this order
+enum SensorSlot {
+  LSM_SLOT = 0,
+  ADXL_SLOT,
+  BMP_SLOT,
+  ICM_SLOT,
+  NUM_SENSOR_SLOTS
+};
+
 // Define bit offsets for status bitmap
 #define ICM_STATUS_OFFSET  0
 #define BMP_STATUS_OFFSET  1
@@ -105,10 +236,51 @@
 #define LOG_FILE_SIZE                  2147483648//536870912  // 512MB allocated before logging to save time, maybe increase on launch day
 #define RING_BUF_CAPACITY              200 * 512//16384 //(400 * 512)
 #define SD_MAX_NUM_CONNECTION_ATTEMPTS 1
+#define SD_FLUSH_BUDGET_US             500 // time per loop saveData() may spend writing sectors out
+#define SD_FLUSH_MAX_SECTORS           16  // most sectors in a single write
+
+// Definitions for the storage thread (STORAGE_THREAD in shart.config)
+#define STORAGE_QUEUE_BYTES      16384 // packet bytes in flight between send() and the storage thread, power of two
+#define STORAGE_THREAD_STACK     4096
+#define STORAGE_STATS_INTERVAL_MS 1000 // how often queue/latency stats are printed with DEBUG_MODE_STATUS
 #define LOG_FILENAME                   "data"
 
+// Definitions for the loop profiler (DEBUG_MODE_DATARATE in shart.config)
+#define PROFILE_INTERVAL_MS 1000 // how often each thread sends a profile packet
+
 // Communications library
 #include <comms.h>
+#include <delta.h>
+#include "shart/util/batch_buffer.h"
+#include "shart/util/profiler.h"
+
+#ifdef STORAGE_THREAD
+#include <TeensyThreads.h>
+#include <lockfree.h>
+#include "shart/util/latency.h"
+
+// What a record in the storage queue carries
+#define QUEUED_PACKET 0 // a packet, logged and sent over the radio if radio is set
+#define QUEUED_TEXT   1 // debug text printed on the sampling thread, see DEBUG_SERIAL_PORT
+#define QUEUED_STATS  2 // a sampling_stats, the sampling thread's half of the storage stats
+
+// Every record in the storage queue is this, followed by the packet (or text, or stats)
+struct queued_packet {
+  uint32_t queued_us; // when send() pushed it, for the latency stats
+  uint16_t kind;      // QUEUED_*
+  uint16_t radio;     // also goes out over the radio
+};
+
+// Snapshot of the storage stats only the sampling thread may touch, taken and reset there
+struct sampling_stats {
+  uint32_t send_max;
+  uint32_t send_mean;
+  uint32_t queue_max_used;
+  uint32_t queue_drops;
+};
+
+#define STORAGE_TEXT_LINE 128 // longest line of debug text handed to the storage thread in one go
+#endif
 
 // USB serial baud rate
 #define USB_SERIAL_BAUD_RATE 9600
@@ -122,6 +294,14 @@
   #define MAIN_SERIAL_PORT RADIO_SERIAL_PORT
 #endif
 
+// Where the sampling thread prints debug text (UPDATE_STATUS, ERROR). With STORAGE_THREAD the
+// storage thread owns MAIN_SERIAL_PORT, so once it runs the text goes through the storage queue
+#ifdef STORAGE_THREAD
+  #define DEBUG_SERIAL_PORT debug_port
+#else
+  #define DEBUG_SERIAL_PORT MAIN_SERIAL_PORT
+#endif
+
 class Shart {
   public:
     Shart();
@@ -132,6 +312,17 @@ class Shart {
     void threadedReconnect(); // this must be thread-safe, as it will not be running on the main thread
     bool getSystemStatus(); // return true if system ok
     void maybeFinish(); // check if ground station has asked us to stop shart
+    const FlushPolicy &getFlushStats() { return flush; } // max ring buffer usage, SD stalls
+    void replay(const unsigned char *packet, size_t len); // collect() from a recorded log, see shart/replay.cpp
+    #ifdef FIXED_BARO
+    int32_t getAltitudeCm() const { return altitude_cm; } // from the last BMP read, for deployment logic
+    #endif
+    #ifdef ICM_FIFO
+    void getOrientation(float q[4]) const { memcpy(q, icm_quat, sizeof(icm_quat)); } // w, x, y, z from the DMP's last quaternion
+    #endif
+    #ifdef STORAGE_THREAD
+    void storageLoop(); // one pass of the storage thread: drain the queue to SD and radio, flush
+    #endif
 
   private:
   //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -142,6 +333,8 @@ class Shart {
     void initBMP388();
     void initADXL375();
     void initGTU7();
+    void initScheduler();
+    static TeensyICM20948Settings icmSettings();
 
     // individual sensor collectors
     void collectDataICM20948();
@@ -149,10 +342,24 @@ class Shart {
     void collectDataBMP388();
     void collectDataADXL375();
     void collectDataGTU7();
+    void configureGTU7();
+    static void onNavPvt(const UbxFrame &frame, void *context); // gps handlers, see initGTU7()
+    static void onNavTimeGps(const UbxFrame &frame, void *context);
+    void handleNavPvt(const NavPvtPacket &packet, uint32_t rx_us);
+    void observeGpsTime(const NavPvtPacket &packet, uint64_t rx_us);
+    #if GPS_PPS_PIN != NO_DRDY_PIN
+    void collectPps();
+    #endif
+    #ifdef GPS_ISR
+    static void gpsIsr(); // drains the UART into gps, on a timer instead of in collect()
+    #endif
     void collectTime();
+    bool sampleDue(uint8_t slot); // scheduler, health probe and status checks before a read
+    uint64_t sampleTime(uint8_t slot);
     
     // These perform simple checks on the sensors to tell if they are connected
     // If a sensor is not connected, we do not want to try to collect data from it.
+    // They cost a bus transaction each, so they only run when the health monitor asks
     void updateStatusICM20948();
     void updateStatusBMP388();
     void updateStatusADXL375();
@@ -160,12 +367,37 @@ class Shart {
     void setStatusByte();
 
     // Sensor objects from respective libraries
-    UbloxGps<NavPvtPacket> gps  = UbloxGps<NavPvtPacket>(GPS_SERIAL_PORT);
+    UbloxGps               gps  = UbloxGps(GPS_SERIAL_PORT);
+    UbxGpsConfig           gps_config = UbxGpsConfig(gps);
+    bool                   gps_started = false; // configured (or given up on) and handing out solutions
+    #ifdef GPS_ISR
+    IntervalTimer                            gps_timer;
+    SpscQueue<gps_solution, GPS_QUEUE_DEPTH> gps_queue; // gpsIsr() to collectDataGTU7()
+    uint8_t                                  gps_rx_buffer[GPS_RX_BUFFER_BYTES];
+    #endif
+
+    // GPS time of our clock. NAV-PVT has no week, NAV-TIMEGPS does. Its handler runs in
+    // gpsIsr() with GPS_ISR, so what it has is one word: week | leap_s << 16 | valid << 24
+    GpsClock              gps_clock = GpsClock(GPS_CLOCK_WINDOW_US);
+    std::atomic<uint32_t> gps_time_info{0};
+    uint16_t              gps_week = 0; // of the last NAV-PVT, with its iTOW, to catch the week rolling over
+    uint32_t              gps_tow  = 0;
+    #if GPS_PPS_PIN != NO_DRDY_PIN
+    uint32_t pps_seen    = 0;     // edges picked up by collectPps()
+    uint64_t pps_last_us = 0;
+    bool     pps_live    = false; // gps_clock is on PPS edges
+    #endif
     Adafruit_BMP3XX        bmp  = Adafruit_BMP3XX();
-    Adafruit_ADXL375       adxl = Adafruit_ADXL375(ADXL_CS, &ADXL_SPI_BUS);
-    TeensyICM20948         icm  = TeensyICM20948(ICM_CS, &ICM_SPI_BUS);
+    Adafruit_ADXL375       adxl = Adafruit_ADXL375(ADXL_CS, &ADXL_SPI_BUS, -1, ADXL_SPI_FREQ);
+    TeensyICM20948         icm  = TeensyICM20948(icmSettings());
     Adafruit_LSM6DSO32     lsm  = Adafruit_LSM6DSO32();
 
+    // Decides which sensors actually have a new sample on this pass through collect()
+    SampleScheduler<NUM_SENSOR_SLOTS> scheduler;
+
+    // Liveness inferred from the data reads, one per scheduler slot
+    SensorHealth health[NUM_SENSOR_SLOTS];
+
     // Component statuses, note: We only care about components that need to be initialized! 
     Status BMPStatus  = UNINITIALIZED;
     Status ICMStatus  = UNINITIALIZED;
@@ -173,6 +405,41 @@ class Shart {
     Status LSMStatus  = UNINITIALIZED;
 
     uint32_t chipTimeOffset;
+    Clock64  clock;                            // us since chipTimeOffset, 64 bits
+    uint64_t sample_us[NUM_SENSOR_SLOTS] = {}; // when each sensor's data in sensor_packet was sampled, 0 if never
+
+    #ifdef LSM_FIFO
+    lsm6dsox_fifo_sample_t lsm_fifo[LSM_FIFO_MAX_SAMPLES];
+    Clock64     lsm_ticks;       // the LSM's timestamp counter, extended to 64 bits
+    SensorClock lsm_clock = SensorClock(LSM_FIFO_SLEW_PPM);
+    uint64_t    lsm_last_us = 0; // our time of the newest FIFO sample
+    #endif
+
+    #ifdef ICM_FIFO
+    TeensyICM20948Frame icm_fifo[ICM_FRAME_BUFFER];
+    float    icm_quat[4] = {1, 0, 0, 0};
+    uint64_t icm_last_us = 0; // our time of the newest frame
+    #endif
+
+    #ifdef FIXED_BARO
+    BaroFixed    baro_fixed;
+    BaroAltitude baro_altitude;
+    int32_t      altitude_cm = 0;
+    #endif
+
+    #ifdef BMP_FIFO
+    struct bmp3_data bmp_fifo[BMP3_FIFO_MAX_FRAMES];
+    SampleClock bmp_clock = SampleClock(BMP_FIFO_PERIOD_NS, BMP_FIFO_SLEW_PPM);
+    uint32_t    bmp_overflows = 0; // last getFifoOverflows(), a new one resyncs bmp_clock
+    uint64_t    bmp_last_us   = 0; // our time of the newest frame
+    #endif
+
+    #ifdef ADXL_FIFO
+    int16_t     adxl_fifo[ADXL3XX_FIFO_DEPTH][3];
+    SampleClock adxl_clock = SampleClock(ADXL_FIFO_PERIOD_NS, ADXL_FIFO_SLEW_PPM);
+    uint32_t    adxl_overflows = 0; // last getFifoOverflows(), a new one resyncs adxl_clock
+    uint64_t    adxl_last_us   = 0; // our time of the newest FIFO sample
+    #endif
 
   //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   // PRIVATE EXPORT MEMBERS
@@ -183,19 +450,55 @@ class Shart {
     // data functions, take byte arrays as arguments
     void saveData();
     void transmitData();
+    bool flushSD();
+    void logPacket(const unsigned char *bytes, size_t len);
+    void checkStopCommand();
 
     SdFs sd;
     FsFile file;
     RingBuf<FsFile, RING_BUF_CAPACITY> rb;
+    FlushPolicy flush = FlushPolicy(SD_FLUSH_BUDGET_US, SD_FLUSH_MAX_SECTORS);
     
     //File data_file; // The data file on the SD card
     uint16_t sd_num_connection_attempts = 0;
     uint8_t bigassbuffer[1024]; // buffer for radio TX
 
-    Status SDStatus = UNINITIALIZED;
+    #ifdef STORAGE_THREAD
+    // send() only queues packets, everything that can block runs on the storage thread
+    void queuePacket(const void *bytes, size_t len, bool radio, uint16_t kind = QUEUED_PACKET);
+    void queueStorageStats();
+    void printStorageStats(const sampling_stats &stats);
+    static void storageThread(void *arg);
+
+    // DEBUG_SERIAL_PORT. Prints straight to MAIN_SERIAL_PORT until the storage thread is
+    // started, after that every line is queued for the storage thread to print
+    class DebugPrint : public Print {
+      public:
+        explicit DebugPrint(Shart *shart) : shart(shart) {}
+        size_t write(uint8_t b) override;
+        using Print::write;
+      private:
+        Shart        *shart;
+        unsigned char line[STORAGE_TEXT_LINE];
+        size_t        len = 0;
+    };
+    DebugPrint debug_port{this};
+    bool       storage_started = false;
+
+    SpscByteQueue<STORAGE_QUEUE_BYTES> storage_queue;
+    LatencyStat send_latency;    // send() on the sampling thread
+    LatencyStat queue_latency;   // send() pushing a packet to the storage thread picking it up
+    LatencyStat storage_latency; // one storageLoop() pass
+    uint32_t    last_stats_ms = 0; // sampling thread
+    #endif
+
+    // atomic because with STORAGE_THREAD the storage thread (re)opens the log while
+    // setStatusByte() reads these on the sampling thread
+    std::atomic<Status> SDStatus{UNINITIALIZED};
 
   //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-    // flag to tell us when to send gps data
+    // flags to tell us when to send sensor and gps data
+    bool sensor_ready = false;
     bool gps_ready = false;
 
     // Persistent packet objects used to store and transmit data
@@ -203,10 +506,52 @@ class Shart {
     gps_p     gps_packet;
     command_p command_packet;
 
+    #ifdef COMPRESS_LOG
+    DeltaEncoder log_encoder;
+    #endif
+
+    // The BMP's calibration, sent ahead of the first sensor packet of every log file when they
+    // carry raw baro words (RAW_BARO, or a replayed raw log). initSD() sets pending for a new
+    // file, on the storage thread with STORAGE_THREAD
+    void sendBaroCalib();
+    baro_calib_p      baro_calib_packet;
+    bool              baro_calib_valid = false;
+    std::atomic<bool> baro_calib_pending{false};
+
+    // GPS time at the time of a gps packet, every GPS_SYNC_INTERVAL_MS once there is one. The
+    // ground maps every packet's us to GPS time with it
+    void sendTimeSync();
+    timesync_p timesync_packet;
+    bool       timesync_ready   = false;
+    uint32_t   last_timesync_ms = 0;
+
+    #ifdef BATCH_MODE
+    // Every sample of the fast sensors, written to SD when a batch fills up
+    BatchBuffer<imu_batch_p>   imu_batches;
+    BatchBuffer<highg_batch_p> highg_batches;
+    BatchBuffer<baro_batch_p>  baro_batches;
+    BatchBuffer<icm_batch_p>   icm_batches;
+    #endif
+
+    #ifdef DEBUG_MODE_DATARATE
+    // stage timings of the sampling loop, and of the storage thread when there is one
+    void sendProfile();
+    LoopProfiler profiler;
+    profile_p    profile_packet;
+    uint32_t     last_profile_ms = 0;
+    uint32_t     last_batch_drops = 0;
+    #ifdef STORAGE_THREAD
+    void sendStorageProfile();
+    LoopProfiler storage_profiler;
+    profile_p    storage_profile_packet;
+    uint32_t     last_storage_profile_ms = 0;
+    #endif
+    #endif
+
     // The current and previous times as recorded by a 'micros()' call
     uint32_t current_time = 0;
     uint32_t sensor_packet_counter = 0;
-    uint8_t sd_file_opened = 0;
+    std::atomic<uint8_t> sd_file_opened{0};
 
     // other initializers
     void awaitStart();
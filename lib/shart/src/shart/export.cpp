@@ -66,6 +66,10 @@ void Shart::initSD() {
   // initialize the RingBuf.
   sd_num_connection_attempts = 0;
   rb.begin(&file);
+  #ifdef COMPRESS_LOG
+  log_encoder.reset(); // new file, start with keyframes
+  #endif
+  baro_calib_pending = true; // raw baro words in this file need it again
   UPDATE_STATUS(SDStatus, AVAILABLE, MAIN_SERIAL_PORT)
   return;
 
@@ -94,28 +98,88 @@ void Shart::initRadio() {
 
 }
 
-// Save data to SD card, this code copied from example in SDFat library
-// this might be faster once QSPI is implemented w/ integrated memory.
-void Shart::saveData() {
+// Write one packet to the ring buffer. With COMPRESS_LOG, sensor and gps packets are delta
+// encoded straight into ring buffer memory. A frame can be up to DELTA_MAX_PACKET bytes but is
+// usually much smaller, so that is only done while the biggest one fits in one piece. Near the
+// wrap or when the buffer is nearly full the frame goes through a local copy, and only a frame
+// that really doesn't fit is a write error
+void Shart::logPacket(const unsigned char *bytes, size_t len) {
+
+  #ifdef COMPRESS_LOG
+  if (len <= DELTA_MAX_PACKET) {
+    unsigned char *frame = rb.bytesFree() >= DELTA_MAX_PACKET ? rb.reserveContiguous(DELTA_MAX_PACKET) : nullptr;
+    if (frame) {
+      rb.commit(log_encoder.encode(bytes, len, frame));
+    } else {
+      unsigned char local[DELTA_MAX_PACKET];
+      size_t n = log_encoder.encode(bytes, len, local);
+      // the next delta would be against a packet that isn't in the log, start over with a keyframe
+      if (rb.write(local, n) != n) log_encoder.reset();
+    }
+    return;
+  }
+  #endif
+  rb.write(bytes, len);
+
+}
+
+// Write out whole sectors while the card is idle and the loop's flush budget lasts,
+// several at a time so they go out as one multi-sector write. See util/flush.h
+// Returns false if nothing should be logged (file full or write failed)
+bool Shart::flushSD() {
 
   size_t n = rb.bytesUsed();
   if ((n + file.curPosition()) > (LOG_FILE_SIZE - 20)) {
     UPDATE_STATUS(SDStatus, UNAVAILABLE, MAIN_SERIAL_PORT)
     ERROR("File full!", MAIN_SERIAL_PORT)
-    return;
+    return false;
   }
-  if (n >= 512 && !file.isBusy()) {
-    // Not busy only allows one sector before possible busy wait.
-    // Write one sector from RingBuf to file.
-    if (512 != rb.writeOut(512)) {// || !file.sync()) {
+  flush.begin(n, micros());
+  while (size_t count = flush.next(rb.bytesUsed(), file.isBusy(), micros())) {
+    uint32_t start = micros();
+    if (count != rb.writeOut(count)) {// || !file.sync()) {
       UPDATE_STATUS(SDStatus, UNAVAILABLE, MAIN_SERIAL_PORT)
       ERROR("Writeout failed!", MAIN_SERIAL_PORT)
-      return;
+      return false;
     }
+    flush.wrote(count, micros() - start);
   }
+  return true;
+
+}
 
-  rb.write(reinterpret_cast<unsigned char *>(&sensor_packet), sizeof(sensor_p));
-  if (gps_ready) rb.write(reinterpret_cast<unsigned char *>(&gps_packet), sizeof(gps_p));
+// Save data to SD card, this code copied from example in SDFat library
+// this might be faster once QSPI is implemented w/ integrated memory.
+void Shart::saveData() {
+
+  if (!flushSD()) return;
+
+  if (sensor_ready) logPacket(reinterpret_cast<unsigned char *>(&sensor_packet), sizeof(sensor_p));
+  if (gps_ready) logPacket(reinterpret_cast<unsigned char *>(&gps_packet), sizeof(gps_p));
+
+  #ifdef BATCH_MODE
+  // batches only go to storage, the radio can't keep up with every sample
+  while (imu_batch_p *full = imu_batches.takeFull()) {
+    imu_batch_p &batch = *full;
+    BATCH_CHECKSUM(batch)
+    logPacket(reinterpret_cast<unsigned char *>(&batch), batchLength(batch));
+  }
+  while (highg_batch_p *full = highg_batches.takeFull()) {
+    highg_batch_p &batch = *full;
+    BATCH_CHECKSUM(batch)
+    logPacket(reinterpret_cast<unsigned char *>(&batch), batchLength(batch));
+  }
+  while (baro_batch_p *full = baro_batches.takeFull()) {
+    baro_batch_p &batch = *full;
+    BATCH_CHECKSUM(batch)
+    logPacket(reinterpret_cast<unsigned char *>(&batch), batchLength(batch));
+  }
+  while (icm_batch_p *full = icm_batches.takeFull()) {
+    icm_batch_p &batch = *full;
+    BATCH_CHECKSUM(batch)
+    logPacket(reinterpret_cast<unsigned char *>(&batch), batchLength(batch));
+  }
+  #endif
   
   if (rb.getWriteError()) {
     // Error caused by too few free bytes in RingBuf.
@@ -129,9 +193,212 @@ void Shart::saveData() {
 // Transmit binary data via radio, beware of endian-ness. Network standard is big endian, but no point in converting twice
 // TODO: packet should include a byte indicating the status of all sensors
 void Shart::transmitData() {
-  if (sensor_packet_counter % RADIO_SEND_EVERY_N == 0)
-    MAIN_SERIAL_PORT.write(reinterpret_cast<unsigned char *>(&sensor_packet), sizeof(sensor_p));
-  sensor_packet_counter++;
+  if (sensor_ready) {
+    if (sensor_packet_counter % RADIO_SEND_EVERY_N == 0)
+      MAIN_SERIAL_PORT.write(reinterpret_cast<unsigned char *>(&sensor_packet), sizeof(sensor_p));
+    sensor_packet_counter++;
+  }
   if (gps_ready) MAIN_SERIAL_PORT.write(reinterpret_cast<unsigned char *>(&gps_packet), sizeof(gps_p));
 
-}
\ No newline at end of file
+}
+
+// The BMP's calibration goes out once per file, to the log and the radio, like a gps packet.
+// Nothing to send unless we have one (RAW_BARO, or replaying a raw log)
+void Shart::sendBaroCalib() {
+
+  if (!baro_calib_valid || !baro_calib_pending.exchange(false)) return;
+  CHECKSUM(baro_calib_packet)
+  #ifdef STORAGE_THREAD
+  queuePacket(&baro_calib_packet, sizeof(baro_calib_p), true);
+  #else
+  if (SDStatus == AVAILABLE) logPacket(reinterpret_cast<unsigned char *>(&baro_calib_packet), sizeof(baro_calib_p));
+  MAIN_SERIAL_PORT.write(reinterpret_cast<unsigned char *>(&baro_calib_packet), sizeof(baro_calib_p));
+  #endif
+
+}
+
+// GPS time goes out like a gps packet, to the log and the radio
+void Shart::sendTimeSync() {
+
+  if (!timesync_ready) return;
+  timesync_ready = false;
+  CHECKSUM(timesync_packet)
+  #ifdef STORAGE_THREAD
+  queuePacket(&timesync_packet, sizeof(timesync_p), true);
+  #else
+  if (SDStatus == AVAILABLE) logPacket(reinterpret_cast<unsigned char *>(&timesync_packet), sizeof(timesync_p));
+  MAIN_SERIAL_PORT.write(reinterpret_cast<unsigned char *>(&timesync_packet), sizeof(timesync_p));
+  #endif
+
+}
+
+#ifdef DEBUG_MODE_DATARATE
+// Every PROFILE_INTERVAL_MS the sampling loop's stage timings go out like a gps packet would,
+// to the log and the radio. See util/profiler.h
+void Shart::sendProfile() {
+
+  if (millis() - last_profile_ms < PROFILE_INTERVAL_MS) return;
+  last_profile_ms = millis();
+  profiler.fill(profile_packet, micros() - chipTimeOffset, 0);
+  #ifdef BATCH_MODE
+  uint32_t drops = imu_batches.getDropCount() + highg_batches.getDropCount() + baro_batches.getDropCount() + icm_batches.getDropCount();
+  profile_packet.data.batch_drops = min(drops - last_batch_drops, (uint32_t) 0xFFFF);
+  last_batch_drops = drops;
+  #endif
+  CHECKSUM(profile_packet)
+  #ifdef STORAGE_THREAD
+  queuePacket(&profile_packet, sizeof(profile_p), true);
+  #else
+  if (SDStatus == AVAILABLE) logPacket(reinterpret_cast<unsigned char *>(&profile_packet), sizeof(profile_p));
+  MAIN_SERIAL_PORT.write(reinterpret_cast<unsigned char *>(&profile_packet), sizeof(profile_p));
+  #endif
+
+}
+
+#ifdef STORAGE_THREAD
+// same for the storage thread's stages, sent from the storage thread since it owns the log
+void Shart::sendStorageProfile() {
+
+  if (millis() - last_storage_profile_ms < PROFILE_INTERVAL_MS) return;
+  last_storage_profile_ms = millis();
+  storage_profiler.fill(storage_profile_packet, micros() - chipTimeOffset, 1);
+  CHECKSUM(storage_profile_packet)
+  if (SDStatus == AVAILABLE) logPacket(reinterpret_cast<unsigned char *>(&storage_profile_packet), sizeof(profile_p));
+  MAIN_SERIAL_PORT.write(reinterpret_cast<unsigned char *>(&storage_profile_packet), sizeof(profile_p));
+
+}
+#endif
+#endif
+
+#ifdef STORAGE_THREAD
+/*******************************************************************************
+* Storage thread
+*
+*   With STORAGE_THREAD, send() only checksums packets and pushes them into
+*   storage_queue. SD flushing, logging and the radio all happen here, on a
+*   TeensyThreads thread, so a slow SD write never delays the next sample.
+*   The queue is lock-free (lockfree.h) and holds packets of any length back
+*   to back, so a sensor packet doesn't take up a batch sized slot. If it is
+*   full the packet is dropped and counted instead of blocking the sampling loop.
+*
+*   Everything touching the file, the ring buffer or the main serial port
+*   belongs to this thread, including the stop command.
+*
+*******************************************************************************/
+
+// copy a finished packet into the storage queue
+void Shart::queuePacket(const void *bytes, size_t len, bool radio, uint16_t kind) {
+
+  unsigned char *record = storage_queue.reserve(sizeof(queued_packet) + len);
+  if (!record) return; // counted as a drop by the queue
+  queued_packet header = {micros(), kind, radio};
+  memcpy(record, &header, sizeof(queued_packet));
+  memcpy(record + sizeof(queued_packet), bytes, len);
+  storage_queue.commit(sizeof(queued_packet) + len);
+
+}
+
+void Shart::storageThread(void *arg) {
+
+  Shart *shart = (Shart *) arg;
+  for (;;) {
+    shart->storageLoop();
+    threads.yield();
+  }
+
+}
+
+void Shart::storageLoop() {
+
+  uint32_t start = micros();
+
+  bool sd = false;
+  PROFILE(storage_profiler, PROFILE_SAVE, sd = SDStatus != PERMANENTLY_UNAVAILABLE && flushSD())
+  size_t len;
+  while (const unsigned char *record = storage_queue.front(len)) {
+    queued_packet header;
+    memcpy(&header, record, sizeof(queued_packet));
+    const unsigned char *bytes = record + sizeof(queued_packet);
+    len -= sizeof(queued_packet);
+    if (header.kind == QUEUED_TEXT) {
+      MAIN_SERIAL_PORT.write(bytes, len);
+    } else if (header.kind == QUEUED_STATS) {
+      sampling_stats stats;
+      memcpy(&stats, bytes, sizeof(stats));
+      printStorageStats(stats);
+    } else {
+      queue_latency.add(micros() - header.queued_us);
+      if (sd) PROFILE(storage_profiler, PROFILE_LOG, logPacket(bytes, len))
+      if (header.radio) PROFILE(storage_profiler, PROFILE_TRANSMIT, MAIN_SERIAL_PORT.write(bytes, len))
+    }
+    storage_queue.pop();
+  }
+  if (sd && rb.getWriteError()) {
+    UPDATE_STATUS(SDStatus, UNAVAILABLE, MAIN_SERIAL_PORT)
+    ERROR("Write error!", MAIN_SERIAL_PORT)
+  }
+
+  #ifdef DEBUG_MODE_DATARATE
+  sendStorageProfile();
+  #endif
+
+  checkStopCommand();
+  storage_latency.add(micros() - start);
+
+}
+
+// Sampling thread. Every STORAGE_STATS_INTERVAL_MS, its half of the stats goes to the storage
+// thread through the queue, so nothing is read or reset across threads
+void Shart::queueStorageStats() {
+
+  if (millis() - last_stats_ms < STORAGE_STATS_INTERVAL_MS) return;
+  last_stats_ms = millis();
+  sampling_stats stats = {send_latency.getMax(), send_latency.getMean(), storage_queue.getMaxUsed(), storage_queue.getDropCount()};
+  queuePacket(&stats, sizeof(stats), false, QUEUED_STATS);
+  send_latency.reset();
+
+}
+
+// Storage thread. Queue usage in bytes and drops, then max/mean latency in us of each thread,
+// then start a new window
+void Shart::printStorageStats(const sampling_stats &stats) {
+
+  MAIN_SERIAL_PORT.print("[STORAGE] queue ");
+  MAIN_SERIAL_PORT.print(storage_queue.bytesUsed());
+  MAIN_SERIAL_PORT.print("/");
+  MAIN_SERIAL_PORT.print(storage_queue.capacity());
+  MAIN_SERIAL_PORT.print(" max ");
+  MAIN_SERIAL_PORT.print(stats.queue_max_used);
+  MAIN_SERIAL_PORT.print(" drops ");
+  MAIN_SERIAL_PORT.print(stats.queue_drops);
+  MAIN_SERIAL_PORT.print(" | send ");
+  MAIN_SERIAL_PORT.print(stats.send_max);
+  MAIN_SERIAL_PORT.print("/");
+  MAIN_SERIAL_PORT.print(stats.send_mean);
+  MAIN_SERIAL_PORT.print(" queued ");
+  MAIN_SERIAL_PORT.print(queue_latency.getMax());
+  MAIN_SERIAL_PORT.print("/");
+  MAIN_SERIAL_PORT.print(queue_latency.getMean());
+  MAIN_SERIAL_PORT.print(" storage ");
+  MAIN_SERIAL_PORT.print(storage_latency.getMax());
+  MAIN_SERIAL_PORT.print("/");
+  MAIN_SERIAL_PORT.println(storage_latency.getMean());
+  queue_latency.reset();
+  storage_latency.reset();
+
+}
+
+// Sampling thread. Collect a line, then hand it to the storage thread as one record. A line
+// that doesn't fit in the queue is dropped like a packet would be
+size_t Shart::DebugPrint::write(uint8_t b) {
+
+  if (!shart->storage_started) return MAIN_SERIAL_PORT.write(b);
+  line[len++] = b;
+  if (b == '\n' || len == sizeof(line)) {
+    shart->queuePacket(line, len, false, QUEUED_TEXT);
+    len = 0;
+  }
+  return 1;
+
+}
+#endif
@@ -1,52 +1,237 @@
 #include "shart.h"
 
+#ifdef GPS_ISR
+static Shart *gps_owner; // for gpsIsr(), there is only one Shart
+#endif
+
+#define GPS_WEEK_NS 604800000000000ULL
+
+#if GPS_PPS_PIN != NO_DRDY_PIN
+// Stamped by the PPS pin's interrupt. A new edge changes the count, they are a second apart
+// so the stamp can't change under collectPps()
+static volatile uint32_t pps_us;
+static volatile uint32_t pps_count;
+
+static void ppsIsr() {
+  pps_us = micros();
+  pps_count++;
+}
+#endif
+
+// The receiver is set up in the background, a step per configureGTU7() from awaitStart() and
+// collect(), every command checked by its ACK (see UbxGpsConfig)
 void Shart::initGTU7() {
-  // Config code seems to always work but will fail silently if not, maybe modify the library to wait for acknowledgement
-  UbxGpsConfig<HardwareSerial, usb_serial_class> *ubxGpsConfig = 
-    new UbxGpsConfig<HardwareSerial, usb_serial_class>(GPS_SERIAL_PORT, USB_SERIAL_PORT);
-  ubxGpsConfig->setBaudrate(GPS_BAUD_RATE);
-  ubxGpsConfig->setMessage(UbxGpsConfigMessage::NavPvt);
-  ubxGpsConfig->setRate(100);
-  ubxGpsConfig->configure();
-  delete ubxGpsConfig;
-
-    
-  gps.begin(GPS_BAUD_RATE);
-  while (!GPS_SERIAL_PORT);
+
+  static const uint32_t bauds[] = {GPS_BAUD_RATES};
+  static const uint16_t rates[] = {GPS_RATES_MS};
+  gps_config.setBauds(bauds, sizeof(bauds) / sizeof(*bauds));
+  gps_config.setRates(rates, sizeof(rates) / sizeof(*rates));
+  gps_config.enable(UBX_CLASS_NAV, UBX_NAV_TIMEGPS, sizeof(NavTimeGpsPacket) + 4); // the week, for GPS time
+
+  #ifdef GPS_ISR
+  // the UART's own interrupt fills the ring, a bigger one rides out a slow timer pass
+  GPS_SERIAL_PORT.addMemoryForRead(gps_rx_buffer, sizeof(gps_rx_buffer));
+  #endif
+  gps_config.start();
+
+}
+
+// One step of the receiver's configuration, the GPS proper starts once it is done. If it
+// failed we still listen, at whatever baud it was left at
+void Shart::configureGTU7() {
+
+  if (!gps_config.update()) return;
+
+  #ifdef DEBUG_MODE_STATUS
+  DEBUG_SERIAL_PORT.print("[STATUS] GPS: ");
+  gps_config.report(DEBUG_SERIAL_PORT);
+  #endif
+
+  // frames are handed to these in place, from inside gps.update()
+  gps.on(UBX_CLASS_NAV, UBX_NAV_PVT, &Shart::onNavPvt, this);
+  gps.on(UBX_CLASS_NAV, UBX_NAV_TIMEGPS, &Shart::onNavTimeGps, this);
+  gps_started = true;
+
+  #if GPS_PPS_PIN != NO_DRDY_PIN
+  pinMode(GPS_PPS_PIN, INPUT);
+  attachInterrupt(digitalPinToInterrupt(GPS_PPS_PIN), ppsIsr, RISING);
+  #endif
+
+  #ifdef GPS_ISR
+  // from here on only the timer reads the port
+  gps_owner = this;
+  gps_timer.priority(GPS_ISR_PRIORITY);
+  gps_timer.begin(gpsIsr, GPS_ISR_PERIOD_US);
+  #endif
 
 }
 
 // Collect data from the GTU7
-// Here we are checking if there is new data from the GPS
-// If we have new data, we populate shart's packet and flag it to be written to SD and sent to serial
+// Here we are checking if there is new data from the GPS, every complete frame goes to its
+// handler below. Until the receiver is configured this only moves that along. With GPS_ISR
+// the parsing already happened in gpsIsr(), and all that is left is picking up a finished
+// solution, if there is one
 void Shart::collectDataGTU7() {
 
+  if (!gps_started) {
+    configureGTU7();
+    return;
+  }
+
+  #if GPS_PPS_PIN != NO_DRDY_PIN
+  collectPps();
+  #endif
+
+  #ifdef GPS_ISR
+  // one per pass, send() only has the one gps packet. More than one waiting means the loop
+  // stalled for a whole GPS period, the rest come out on the next passes
+  gps_solution *solution = gps_queue.front();
+  if (!solution) return;
+  handleNavPvt(solution->pvt, solution->rx_us);
+  gps_queue.pop();
+  #else
   // UBX protocol for GPS data
   gps.update();
-  
-  if (gps.isReady()) {
-    const NavPvtPacket &packet = gps.getPacket();
-    gps_packet.data.lat = packet.lat;
-    gps_packet.data.lon = packet.lon;
-    gps_packet.data.alt = packet.hMSL;
-    gps_packet.data.veln = packet.velN;
-    gps_packet.data.vele = packet.velE;
-    gps_packet.data.veld = packet.velD;
-    gps_packet.data.eph = packet.hAcc;
-    gps_packet.data.epv = packet.vAcc;
-    gps_packet.data.sacc = packet.sAcc;
-    gps_packet.data.gspeed = packet.gSpeed;
-    gps_packet.data.pdop = ((float) packet.pDOP) / 100;
-    gps_packet.data.nsats = packet.numSV;
-    gps_packet.data.fix_type = packet.fixType;
-    gps_packet.data.valid = packet.valid;
-    gps_packet.data.flags = packet.flags;
-
-    // flag packet to be sent at this iteration of the loop
-    gps_ready = true;
+  #endif
+
+}
+
+#ifdef GPS_ISR
+void Shart::gpsIsr() {
+  gps_owner->gps.update();
+}
+#endif
+
+// gps handlers, they get the frame in the parser's buffer
+void Shart::onNavPvt(const UbxFrame &frame, void *context) {
+  const NavPvtPacket *packet = frame.as<NavPvtPacket>();
+  if (!packet) return; // too short is some other version
+  Shart *shart = (Shart *) context;
+  #ifdef GPS_ISR
+  // in the timer ISR: the clock and gps_packet belong to the loop, so just queue it. A full
+  // queue drops it (and counts it)
+  gps_solution *solution = shart->gps_queue.reserve();
+  if (!solution) return;
+  solution->rx_us = micros();
+  solution->pvt   = *packet;
+  shart->gps_queue.publish();
+  #else
+  shart->handleNavPvt(*packet, micros());
+  #endif
+}
+
+// in gpsIsr() with GPS_ISR, so it only leaves the one word for handleNavPvt()
+void Shart::onNavTimeGps(const UbxFrame &frame, void *context) {
+  const NavTimeGpsPacket *packet = frame.as<NavTimeGpsPacket>();
+  if (!packet) return;
+  Shart *shart = (Shart *) context;
+  shart->gps_time_info = (uint16_t) packet->week | (uint32_t) (uint8_t) packet->leapS << 16 | (uint32_t) packet->valid << 24;
+}
+
+// A NAV-PVT came in at rx_us, we populate shart's packet and flag it to be written to SD and sent to serial
+void Shart::handleNavPvt(const NavPvtPacket &packet, uint32_t rx_us) {
+
+  uint64_t now = clock.extend(rx_us - chipTimeOffset); // when the frame came in, near enough
+  gps_packet.data.us    = (uint32_t) now;
+  gps_packet.data.us_hi = now >> 32;
+  gps_packet.data.lat = packet.lat;
+  gps_packet.data.lon = packet.lon;
+  gps_packet.data.alt = packet.hMSL;
+  gps_packet.data.veln = packet.velN;
+  gps_packet.data.vele = packet.velE;
+  gps_packet.data.veld = packet.velD;
+  gps_packet.data.eph = packet.hAcc;
+  gps_packet.data.epv = packet.vAcc;
+  gps_packet.data.sacc = packet.sAcc;
+  gps_packet.data.gspeed = packet.gSpeed;
+  gps_packet.data.pdop = ((float) packet.pDOP) / 100;
+  gps_packet.data.nsats = packet.numSV;
+  gps_packet.data.fix_type = packet.fixType;
+  gps_packet.data.valid = packet.valid;
+  gps_packet.data.flags = packet.flags;
+
+  // flag packet to be sent at this iteration of the loop
+  gps_ready = true;
+
+  observeGpsTime(packet, now);
+
+}
+
+// The NAV-PVT's epoch is an observation for gps_clock (unless PPS edges are coming in), and
+// every GPS_SYNC_INTERVAL_MS the time of its gps packet goes out in a timesync packet
+void Shart::observeGpsTime(const NavPvtPacket &packet, uint64_t rx_us) {
+
+  uint32_t info = gps_time_info;
+  if ((info >> 24 & 0x03) != 0x03) return; // no time of week and week yet
+  // the week from NAV-TIMEGPS may be a NAV-PVT behind, iTOW going back means a new one
+  uint16_t week = info;
+  if (week < gps_week) week = gps_week;
+  if (packet.iTOW < gps_tow && week == gps_week) week++;
+  gps_week = week;
+  gps_tow  = packet.iTOW;
+
+  bool from_pvt = true;
+  #if GPS_PPS_PIN != NO_DRDY_PIN
+  if (pps_live && rx_us - pps_last_us > GPS_PPS_TIMEOUT_US) {
+    pps_live = false;
+    gps_clock.reset(); // the PVTs' lag has the receiver's latency in it, the edges' didn't
+  }
+  from_pvt = !pps_live;
+  #endif
+  if (from_pvt) {
+    // the epoch is iTOW, to the ms. nano has the rest: GPS and UTC are whole seconds apart
+    int32_t sub_ns = packet.nano % 1000000;
+    if (sub_ns < -500000) sub_ns += 1000000;
+    if (sub_ns >= 500000) sub_ns -= 1000000;
+    uint64_t epoch_ns = week * GPS_WEEK_NS + (uint64_t) packet.iTOW * 1000000 + sub_ns;
+    // the handler ran once the last byte was in, the frame started coming out before that
+    uint32_t baud = gps_config.getBaud();
+    uint64_t wire_us = baud ? (uint64_t) (sizeof(NavPvtPacket) + 4) * 10 * 1000000 / baud : 0;
+    gps_clock.observe(rx_us - wire_us, epoch_ns);
+  }
+
+  if (!gps_clock.valid() || millis() - last_timesync_ms < GPS_SYNC_INTERVAL_MS) return;
+  last_timesync_ms = millis();
+  uint64_t gps_ns = gps_clock.map(rx_us);
+  uint64_t tow_ns = gps_ns % GPS_WEEK_NS;
+  timesync_packet.data.us        = gps_packet.data.us;
+  timesync_packet.data.us_hi     = gps_packet.data.us_hi;
+  timesync_packet.data.week      = gps_ns / GPS_WEEK_NS;
+  timesync_packet.data.tow_ms    = tow_ns / 1000000;
+  timesync_packet.data.tow_ns    = tow_ns % 1000000;
+  timesync_packet.data.drift_ppb = gps_clock.getDriftPpb();
+  timesync_packet.data.spread_ns = gps_clock.getSpreadNs();
+  timesync_packet.data.leap_s    = (int8_t) (info >> 16);
+  timesync_packet.data.flags     = (gps_clock.locked() ? TIMESYNC_LOCKED : 0) | (info >> 24 & 0x04 ? TIMESYNC_LEAP : 0);
+  #if GPS_PPS_PIN != NO_DRDY_PIN
+  if (pps_live) timesync_packet.data.flags |= TIMESYNC_PPS;
+  #endif
+  timesync_ready = true;
+
+}
+
+#if GPS_PPS_PIN != NO_DRDY_PIN
+// A PPS edge is the start of a GPS second, which one we know from gps_clock as the NAV-PVTs
+// set it up, good to far better than half a second. Once they come in the clock only goes by
+// the edges, they don't have the receiver's latency
+void Shart::collectPps() {
+
+  uint32_t count = pps_count;
+  if (count == pps_seen) return;
+  pps_seen = count;
+  uint64_t edge = clock.extend(pps_us - chipTimeOffset);
+  if (!gps_clock.valid()) return;
+
+  uint64_t second = (gps_clock.map(edge) + 500000000) / 1000000000;
+  if (!pps_live) {
+    pps_live = true;
+    gps_clock.reset();
   }
+  gps_clock.observe(edge, second * 1000000000);
+  pps_last_us = edge;
 
 }
+#endif
 
 /*
 struct gps_message {
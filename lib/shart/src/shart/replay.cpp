@@ -0,0 +1,92 @@
+#include "shart.h"
+
+// Stand-in for collect() when the data comes from a recorded log instead of the drivers.
+// Takes one packet as it was logged (checked, and delta frames already decoded) and puts it
+// where collect() would have, so send() stores and transmits it the same way. Times and
+// the status byte are the recorded ones.
+// Call it for every packet of one loop, then send(), the packets are overwritten otherwise
+void Shart::replay(const unsigned char *packet, size_t len) {
+
+  if (len < HEADER_LENGTH || packet[0] != SYNC) return;
+
+  switch (packet[1]) {
+
+    case TYPE_SENSOR:
+      if (len != sizeof(sensor_p)) return;
+      memcpy(&sensor_packet.data, packet + HEADER_LENGTH, sizeof(sensor_packet.data));
+      sensor_ready = true;
+      break;
+
+    case TYPE_GPS:
+      if (len != sizeof(gps_p)) return;
+      memcpy(&gps_packet.data, packet + HEADER_LENGTH, sizeof(gps_packet.data));
+      gps_ready = true;
+      break;
+
+    case TYPE_BARO_CALIB:
+      if (len != sizeof(baro_calib_p)) return;
+      memcpy(&baro_calib_packet.data, packet + HEADER_LENGTH, sizeof(baro_calib_packet.data));
+      baro_calib_valid = true;
+      baro_calib_pending = true;
+      break;
+
+    case TYPE_TIMESYNC:
+      if (len != sizeof(timesync_p)) return;
+      memcpy(&timesync_packet.data, packet + HEADER_LENGTH, sizeof(timesync_packet.data));
+      timesync_ready = true;
+      break;
+
+    #ifdef BATCH_MODE
+    // the samples go back in one by one, so batches come out the same but a packet later
+    // than in the log (a batch only goes out once the next sample doesn't fit)
+    case TYPE_IMU_BATCH: {
+      imu_batch_p batch;
+      if (!batchDecode(packet, len, batch)) return;
+      uint64_t us = ((uint64_t) batch.data.us_hi << 32) | batch.data.us;
+      for (unsigned int i = 0; i < batch.data.count; i++) {
+        us += batch.data.samples[i].dt;
+        imu_batches.add(us, batch.data.samples[i]);
+      }
+      break;
+    }
+
+    case TYPE_HIGHG_BATCH: {
+      highg_batch_p batch;
+      if (!batchDecode(packet, len, batch)) return;
+      uint64_t us = ((uint64_t) batch.data.us_hi << 32) | batch.data.us;
+      for (unsigned int i = 0; i < batch.data.count; i++) {
+        us += batch.data.samples[i].dt;
+        highg_batches.add(us, batch.data.samples[i]);
+      }
+      break;
+    }
+
+    case TYPE_BARO_BATCH: {
+      baro_batch_p batch;
+      if (!batchDecode(packet, len, batch)) return;
+      uint64_t us = ((uint64_t) batch.data.us_hi << 32) | batch.data.us;
+      for (unsigned int i = 0; i < batch.data.count; i++) {
+        us += batch.data.samples[i].dt;
+        baro_batches.add(us, batch.data.samples[i]);
+      }
+      break;
+    }
+
+    case TYPE_ICM_BATCH: {
+      icm_batch_p batch;
+      if (!batchDecode(packet, len, batch)) return;
+      uint64_t us = ((uint64_t) batch.data.us_hi << 32) | batch.data.us;
+      for (unsigned int i = 0; i < batch.data.count; i++) {
+        us += batch.data.samples[i].dt;
+        icm_batches.add(us, batch.data.samples[i]);
+      }
+      break;
+    }
+    #endif
+
+    default:
+      break; // commands, and batches when we aren't batching
+
+  }
+
+}
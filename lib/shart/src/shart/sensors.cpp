@@ -34,17 +34,62 @@
 void Shart::initLSM6DSO32() {
 
   if (!lsm.begin_I2C(LSM_I2C_ADDR, &LSM_I2C_BUS)) {
-    UPDATE_STATUS(ICMStatus, UNINITIALIZED, MAIN_SERIAL_PORT)
-    ERROR("LSM initialization failed!", MAIN_SERIAL_PORT)
+    UPDATE_STATUS(ICMStatus, UNINITIALIZED, DEBUG_SERIAL_PORT)
+    ERROR("LSM initialization failed!", DEBUG_SERIAL_PORT)
     return;
   }
 
   lsm.setAccelRange(LSM6DSO32_ACCEL_RANGE_32_G);
   lsm.setGyroRange(LSM6DS_GYRO_RANGE_2000_DPS);
+
+  #if defined(LSM_FIFO) || defined(ASYNC_I2C)
+  LSM_I2C_BUS.setClock(LSM_I2C_CLOCK); // after begin_I2C(), Wire.begin() sets it back to 100 kHz
+  #endif
+
+  #ifdef LSM_FIFO
+  lsm.enableFifo(LSM_FIFO_RATE, LSM_FIFO_WATERMARK);
+  lsm_ticks = Clock64(); // the chip was reset, its timestamp starts over
+  lsm_clock.reset();
+  #else
   lsm.setAccelDataRate(LSM6DS_RATE_208_HZ);
   lsm.setGyroDataRate(LSM6DS_RATE_208_HZ);
+  #endif
+
+  #if LSM_DRDY_PIN != NO_DRDY_PIN
+  #ifdef LSM_FIFO
+  lsm.configInt1Fifo(true);
+  #else
+  // accel and gyro run at the same ODR, accel data ready on INT1 is enough
+  lsm.configInt1(false, false, true);
+  #endif
+  #endif
+
+  UPDATE_STATUS(LSMStatus, AVAILABLE, DEBUG_SERIAL_PORT)
+}
+
+// The library's defaults on our bus. With ICM_FIFO the DMP also puts out quaternions and
+// raw gyro/acc, and the library queues them for collectDataICM20948(). The calibrated
+// gyro/acc outputs are never read, so they are off then
+TeensyICM20948Settings Shart::icmSettings() {
+
+  TeensyICM20948Settings settings;
+  settings.cs_pin  = ICM_CS;
+  settings.spi_bus = &ICM_SPI_BUS;
+
+  #ifdef ICM_FIFO
+  settings.enable_gyroscope         = false;
+  settings.enable_accelerometer     = false;
+  settings.enable_quaternion        = true;
+  settings.enable_raw_gyroscope     = true;
+  settings.enable_raw_accelerometer = true;
+  settings.buffer_frames            = true;
+  settings.gyroscope_frequency      = ICM_DMP_RATE_HZ;
+  settings.accelerometer_frequency  = ICM_DMP_RATE_HZ;
+  settings.quaternion_frequency     = ICM_DMP_RATE_HZ;
+  #endif
+
+  return settings;
 
-  UPDATE_STATUS(LSMStatus, AVAILABLE, MAIN_SERIAL_PORT)
 }
 
 void Shart::initICM20948() {
@@ -52,11 +97,11 @@ void Shart::initICM20948() {
   icm20948_instance = 0;
   
   if (!icm.init()) {
-    UPDATE_STATUS(ICMStatus, UNINITIALIZED, MAIN_SERIAL_PORT)
-    ERROR("ICM initialization failed!", MAIN_SERIAL_PORT)
+    UPDATE_STATUS(ICMStatus, UNINITIALIZED, DEBUG_SERIAL_PORT)
+    ERROR("ICM initialization failed!", DEBUG_SERIAL_PORT)
     return;
   }
-  UPDATE_STATUS(ICMStatus, AVAILABLE, MAIN_SERIAL_PORT)
+  UPDATE_STATUS(ICMStatus, AVAILABLE, DEBUG_SERIAL_PORT)
 
 }
 
@@ -68,8 +113,8 @@ void Shart::initBMP388() {
   //delay(100);
   //if (!bmp.begin_SPI(BMP_CS, BMP_SCK, BMP_MISO, BMP_MOSI)) {
   if (!bmp.begin_SPI(BMP_CS, &BMP_SPI_BUS)) {
-    UPDATE_STATUS(BMPStatus, UNINITIALIZED, MAIN_SERIAL_PORT)
-    ERROR("BMP initialization failed!", MAIN_SERIAL_PORT)
+    UPDATE_STATUS(BMPStatus, UNINITIALIZED, DEBUG_SERIAL_PORT)
+    ERROR("BMP initialization failed!", DEBUG_SERIAL_PORT)
     return;
   }
 
@@ -79,7 +124,32 @@ void Shart::initBMP388() {
   bmp.setIIRFilterCoeff(BMP3_IIR_FILTER_COEFF_3);
   bmp.setOutputDataRate(BMP3_ODR_200_HZ);
 
-  UPDATE_STATUS(BMPStatus, AVAILABLE, MAIN_SERIAL_PORT)
+  #if defined(RAW_BARO) || defined(FIXED_BARO)
+  if (bmp.readCalibration(baro_calib_packet.data.nvm)) {
+    #ifdef RAW_BARO
+    baro_calib_valid = true;
+    baro_calib_pending = true;
+    #endif
+    #ifdef FIXED_BARO
+    baro_fixed.setCalibration(baro_calib_packet.data.nvm);
+    baro_altitude.setSeaLevel(SEA_LEVEL_PA);
+    #endif
+  }
+  #endif
+
+  #ifdef BMP_FIFO
+  bmp.enableFifo(BMP_FIFO_WATERMARK); // routes the watermark to the INT pin too
+  bmp_overflows = 0;
+  bmp_clock.resync(); // same oscillator, the measured period still holds
+  #endif
+
+  #if BMP_DRDY_PIN != NO_DRDY_PIN
+  #ifndef BMP_FIFO
+  bmp.enableDataReadyInterrupt();
+  #endif
+  #endif
+
+  UPDATE_STATUS(BMPStatus, AVAILABLE, DEBUG_SERIAL_PORT)
 
 }
 
@@ -89,12 +159,60 @@ void Shart::initBMP388() {
 void Shart::initADXL375() {
 
   if (!adxl.begin()) {
-    UPDATE_STATUS(ADXLStatus, UNINITIALIZED, MAIN_SERIAL_PORT);
-    ERROR("ADXL initialization failed!", MAIN_SERIAL_PORT)
+    UPDATE_STATUS(ADXLStatus, UNINITIALIZED, DEBUG_SERIAL_PORT);
+    ERROR("ADXL initialization failed!", DEBUG_SERIAL_PORT)
     return;
   }
 
-  UPDATE_STATUS(ADXLStatus, AVAILABLE, MAIN_SERIAL_PORT)
+  #ifdef ADXL_FIFO
+  adxl.setDataRate(ADXL_FIFO_RATE);
+  adxl.setFifoMode(ADXL3XX_FIFO_STREAM, ADXL_FIFO_WATERMARK);
+  adxl_overflows = 0;
+  adxl_clock.resync(); // same oscillator, the measured period still holds
+  #endif
+
+  #if ADXL_DRDY_PIN != NO_DRDY_PIN
+  // data ready (or the FIFO watermark) on INT1 (a 0 in INT_MAP routes to INT1)
+  int_config drdy = {};
+  #ifdef ADXL_FIFO
+  drdy.bits.watermark = true;
+  #else
+  drdy.bits.data_ready = true;
+  #endif
+  adxl.mapInterrupts(int_config{});
+  adxl.enableInterrupts(drdy);
+  #endif
+
+  UPDATE_STATUS(ADXLStatus, AVAILABLE, DEBUG_SERIAL_PORT)
+
+}
+
+// Hook every sensor up to the scheduler, either through its DRDY pin or on a fixed period.
+// Called once from init(), reinitializing a sensor later re-enables its DRDY output but
+// doesn't need to touch the scheduler
+void Shart::initScheduler() {
+
+  uint32_t now = micros();
+
+  #if LSM_DRDY_PIN != NO_DRDY_PIN
+  scheduler.attach(LSM_SLOT, LSM_DRDY_PIN, LSM_PERIOD_US);
+  #else
+  scheduler.setPeriod(LSM_SLOT, LSM_PERIOD_US, now);
+  #endif
+
+  #if ADXL_DRDY_PIN != NO_DRDY_PIN
+  scheduler.attach(ADXL_SLOT, ADXL_DRDY_PIN, ADXL_PERIOD_US);
+  #else
+  scheduler.setPeriod(ADXL_SLOT, ADXL_PERIOD_US, now);
+  #endif
+
+  #if BMP_DRDY_PIN != NO_DRDY_PIN
+  scheduler.attach(BMP_SLOT, BMP_DRDY_PIN, BMP_PERIOD_US);
+  #else
+  scheduler.setPeriod(BMP_SLOT, BMP_PERIOD_US, now);
+  #endif
+
+  scheduler.setPeriod(ICM_SLOT, ICM_PERIOD_US, now);
 
 }
 
@@ -103,57 +221,91 @@ void Shart::initADXL375() {
 * Status checkers
 *
 *   Before collecting data, check and update the status of sensors. Depending on
-*   the determined status, init or collect functions may be flagged.
+*   the determined status, init or collect functions may be flagged. Each of these
+*   costs a bus transaction, so collect() only calls them when the sensor's health
+*   monitor asks for a probe (see util/health.h).
 *
 *******************************************************************************/
 
 void Shart::updateStatusBMP388() {
 
+  health[BMP_SLOT].reportProbe(micros());
+
   // The chipID() function has been modified to ACTUALLY read the chip_id register
   if (bmp.chipID() != BMP_CHIP_ID) {
-    UPDATE_STATUS(BMPStatus, UNAVAILABLE, MAIN_SERIAL_PORT)
-    ERROR("BMP not found!", MAIN_SERIAL_PORT)
+    UPDATE_STATUS(BMPStatus, UNAVAILABLE, DEBUG_SERIAL_PORT)
+    ERROR("BMP not found!", DEBUG_SERIAL_PORT)
+    return;
+  }
+
+  #ifdef BMP_FIFO
+  // a BMP that was reset has its FIFO off
+  if (!bmp.fifoEnabled()) {
+    initBMP388();
     return;
   }
+  #endif
 
-  UPDATE_STATUS(BMPStatus, AVAILABLE, MAIN_SERIAL_PORT);
+  UPDATE_STATUS(BMPStatus, AVAILABLE, DEBUG_SERIAL_PORT);
 }
 
 // See if icm is connected (under the covers, checks device id)
 void Shart::updateStatusICM20948() {
-  
+
+  health[ICM_SLOT].reportProbe(micros());
+
   if (!icm.connected()) {
-    UPDATE_STATUS(ICMStatus, UNINITIALIZED, MAIN_SERIAL_PORT)
-    ERROR("ICM reading failed!", MAIN_SERIAL_PORT)
+    UPDATE_STATUS(ICMStatus, UNINITIALIZED, DEBUG_SERIAL_PORT)
+    ERROR("ICM reading failed!", DEBUG_SERIAL_PORT)
     return;
   }
 
-  UPDATE_STATUS(ICMStatus, AVAILABLE, MAIN_SERIAL_PORT)
+  UPDATE_STATUS(ICMStatus, AVAILABLE, DEBUG_SERIAL_PORT)
   
 }
 
 // Check if device id matches expected
 void Shart::updateStatusADXL375() {
 
+  health[ADXL_SLOT].reportProbe(micros());
+
   if (adxl.getDeviceID() != ADXL_CHIP_ID) {
-    UPDATE_STATUS(ADXLStatus, UNAVAILABLE, MAIN_SERIAL_PORT);
-    ERROR("ADXL not found!", MAIN_SERIAL_PORT)
+    UPDATE_STATUS(ADXLStatus, UNAVAILABLE, DEBUG_SERIAL_PORT);
+    ERROR("ADXL not found!", DEBUG_SERIAL_PORT)
     return;
   }
 
-  UPDATE_STATUS(ADXLStatus, AVAILABLE, MAIN_SERIAL_PORT)
+  #ifdef ADXL_FIFO
+  // like the LSM, a chip that lost power comes back with its FIFO in bypass
+  if (adxl.getFifoMode() != ADXL3XX_FIFO_STREAM) {
+    initADXL375();
+    return;
+  }
+  #endif
+
+  UPDATE_STATUS(ADXLStatus, AVAILABLE, DEBUG_SERIAL_PORT)
 
 }
 
 void Shart::updateStatusLSM6DSO32() {
 
+  health[LSM_SLOT].reportProbe(micros());
+
   if (lsm.chipID() != LSM_CHIP_ID) {
-    UPDATE_STATUS(LSMStatus, UNAVAILABLE, MAIN_SERIAL_PORT);
-    ERROR("LSM not found!", MAIN_SERIAL_PORT)
+    UPDATE_STATUS(LSMStatus, UNAVAILABLE, DEBUG_SERIAL_PORT);
+    ERROR("LSM not found!", DEBUG_SERIAL_PORT)
+    return;
+  }
+
+  #ifdef LSM_FIFO
+  // a chip that browned out answers fine but comes back with the FIFO in bypass
+  if (!lsm.fifoEnabled()) {
+    initLSM6DSO32();
     return;
   }
+  #endif
 
-  UPDATE_STATUS(LSMStatus, AVAILABLE, MAIN_SERIAL_PORT)
+  UPDATE_STATUS(LSMStatus, AVAILABLE, DEBUG_SERIAL_PORT)
 }
 
 /*******************************************************************************
@@ -167,23 +319,142 @@ void Shart::updateStatusLSM6DSO32() {
 *
 *******************************************************************************/
 
+#ifdef ADXL_FIFO
+#ifdef BATCH_MODE
+static_assert((BATCH_RING_SIZE - 1) * BATCH_MAX_SAMPLES >= ADXL3XX_FIFO_DEPTH, "a full ADXL FIFO has to fit in the high-g batch ring");
+#endif
+
+// Drain the ADXL's FIFO. Every sample goes into the high-g batches, the newest one also into
+// the sensor packet. The ADXL has no timestamps, adxl_clock times the samples by counting them,
+// so a drain always takes the whole FIFO (see the BMP's)
+void Shart::collectDataADXL375() {
+
+  uint64_t read_us = sample_us[ADXL_SLOT]; // collect() stamped the read
+  int n = adxl.readFifo(adxl_fifo, ADXL3XX_FIFO_DEPTH);
+
+  if (adxl.getFifoOverflows() != adxl_overflows) {
+    adxl_overflows = adxl.getFifoOverflows();
+    adxl_clock.resync(); // samples were dropped, counting starts over from this read
+  }
+
+  if (n <= 0) {
+    sample_us[ADXL_SLOT] = adxl_last_us;
+    // an empty FIFO isn't a read, the old sample would count as a stuck one
+    if (n < 0) health[ADXL_SLOT].reportRead(false, &sensor_packet.data.adxl_acc_x, 3 * sizeof(int16_t));
+    return;
+  }
+
+  uint64_t first = adxl_clock.add(read_us, n);
+  uint32_t period_ns = adxl_clock.getPeriodNs();
+
+  for (int i = 0; i < n; i++) {
+    uint64_t t = first + (uint64_t) i * period_ns / 1000;
+    if (t <= adxl_last_us) t = adxl_last_us + 1;
+    adxl_last_us = t;
+
+    #ifdef BATCH_MODE
+    highg_sample s = {0, adxl_fifo[i][0], adxl_fifo[i][1], adxl_fifo[i][2]};
+    highg_batches.add(t, s);
+    #endif
+  }
+
+  sensor_packet.data.adxl_acc_x = adxl_fifo[n - 1][0];
+  sensor_packet.data.adxl_acc_y = adxl_fifo[n - 1][1];
+  sensor_packet.data.adxl_acc_z = adxl_fifo[n - 1][2];
+  sample_us[ADXL_SLOT] = adxl_last_us;
+
+  health[ADXL_SLOT].reportRead(true, &sensor_packet.data.adxl_acc_x, 3 * sizeof(int16_t));
+
+}
+#else
 // collect data from the ADXL375, 49mG per LSB so multiply by 49/1000 = 0.049 for units in G
 void Shart::collectDataADXL375() {
 
   // Collect raw data from axis registers
   int16_t x, y, z;
-  adxl.getXYZ(x, y, z);
+  #ifdef ADXL_ASYNC
+  bool ok = adxl.finishXYZ(x, y, z); // collect() started it
+  #else
+  bool ok = adxl.getXYZ(x, y, z);
+  #endif
   
   sensor_packet.data.adxl_acc_x = x;
   sensor_packet.data.adxl_acc_y = y;
   sensor_packet.data.adxl_acc_z = z;
 
+  // x, y, z are contiguous in the packet
+  health[ADXL_SLOT].reportRead(ok, &sensor_packet.data.adxl_acc_x, 3 * sizeof(int16_t));
+
+  #ifdef BATCH_MODE
+  highg_sample s = {0, x, y, z};
+  highg_batches.add(sample_us[ADXL_SLOT], s);
+  #endif
+
 }
+#endif
+
+#ifdef LSM_FIFO
+#ifdef BATCH_MODE
+static_assert((BATCH_RING_SIZE - 1) * BATCH_MAX_SAMPLES >= LSM_FIFO_MAX_SAMPLES, "a whole LSM drain has to fit in the IMU batch ring");
+#endif
+
+// Drain the LSM's FIFO. Every sample goes into the IMU batches at its own time (the chip's
+// timestamp put on our clock), the newest one also goes into the sensor packet. With
+// BATCH_MODE a drain stops at what the batch ring has room for, the rest stays in the FIFO
+// for the next one
+void Shart::collectDataLSM6DSO32(){
+
+  uint64_t read_us = sample_us[LSM_SLOT]; // collect() stamped the read
+  size_t max_samples = LSM_FIFO_MAX_SAMPLES;
+  #ifdef BATCH_MODE
+  if (imu_batches.room() < max_samples) max_samples = imu_batches.room();
+  #endif
+  int n = lsm.readFifo(lsm_fifo, max_samples);
+
+  if (n <= 0) {
+    sample_us[LSM_SLOT] = lsm_last_us; // nothing new, the packet keeps the last sample
+    // an empty drain (the batches full while the SD card is down) isn't a read, the old
+    // sample would count as a stuck one
+    if (n < 0) health[LSM_SLOT].reportRead(false, &sensor_packet.data.acc_x, 6 * sizeof(int16_t));
+    return;
+  }
+
+  uint32_t tick_ns = lsm.timestampPeriodNs();
+  lsm_clock.observe(read_us, lsm_ticks.update(lsm_fifo[n - 1].timestamp) * tick_ns / 1000);
+
+  for (int i = 0; i < n; i++) {
+    const lsm6dsox_fifo_sample_t &f = lsm_fifo[i];
+    uint64_t t = lsm_clock.map(lsm_ticks.extend(f.timestamp) * tick_ns / 1000);
+    if (t <= lsm_last_us) t = lsm_last_us + 1; // the offset can step down a little, keep samples in order
+    lsm_last_us = t;
+
+    #ifdef BATCH_MODE
+    imu_sample s = {0, f.acc[0], f.acc[1], f.acc[2], f.gyro[0], f.gyro[1], f.gyro[2]};
+    imu_batches.add(t, s);
+    #endif
+  }
+
+  const lsm6dsox_fifo_sample_t &newest = lsm_fifo[n - 1];
+  sensor_packet.data.acc_x = newest.acc[0];
+  sensor_packet.data.acc_y = newest.acc[1];
+  sensor_packet.data.acc_z = newest.acc[2];
+  sensor_packet.data.gyr_x = newest.gyro[0];
+  sensor_packet.data.gyr_y = newest.gyro[1];
+  sensor_packet.data.gyr_z = newest.gyro[2];
+  sample_us[LSM_SLOT] = lsm_last_us;
 
+  health[LSM_SLOT].reportRead(true, &sensor_packet.data.acc_x, 6 * sizeof(int16_t));
+
+}
+#else
 //lsm data collection
 void Shart::collectDataLSM6DSO32(){
   
-  lsm.getRaw();
+  #ifdef LSM_ASYNC
+  bool ok = lsm.finishRaw(); // collect() started it
+  #else
+  bool ok = lsm.getRaw();
+  #endif
 
   sensor_packet.data.acc_x = lsm.rawAccX;
   sensor_packet.data.acc_y = lsm.rawAccY;
@@ -192,9 +463,74 @@ void Shart::collectDataLSM6DSO32(){
   sensor_packet.data.gyr_y = lsm.rawGyroY;
   sensor_packet.data.gyr_z = lsm.rawGyroZ;
   //sensor_packet.data.temp_lsm  = temp.temperature;
+
+  // acc and gyr are contiguous in the packet
+  health[LSM_SLOT].reportRead(ok, &sensor_packet.data.acc_x, 6 * sizeof(int16_t));
+
+  #ifdef BATCH_MODE
+  imu_sample s = {0, lsm.rawAccX, lsm.rawAccY, lsm.rawAccZ, lsm.rawGyroX, lsm.rawGyroY, lsm.rawGyroZ};
+  imu_batches.add(sample_us[LSM_SLOT], s);
+  #endif
   
 }
+#endif
+
+#ifdef ICM_FIFO
+#ifdef BATCH_MODE
+static_assert((BATCH_RING_SIZE - 1) * BATCH_MAX_SAMPLES >= ICM_FRAME_BUFFER, "a full ICM frame buffer has to fit in the ICM batch ring");
+#endif
+
+static int16_t icmClamp(int32_t v) {
+  return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : v;
+}
+
+// Drain the DMP's FIFO. Every quaternion and raw gyro/acc output goes into the ICM batches at
+// its DMP timestamp, the newest quaternion is kept for getOrientation(). The magnetometer
+// still goes into the sensor packet. With BATCH_MODE only as many frames as the batch ring
+// has room for are taken, the rest wait in the library's frame buffer
+void Shart::collectDataICM20948() {
 
+  float mag_x, mag_y, mag_z;
+
+  icm.task(); // everything in the DMP FIFO, into the library's frame buffer
+  icm.readMagData(&mag_x, &mag_y, &mag_z);
+  sensor_packet.data.mag_x = mag_x;
+  sensor_packet.data.mag_y = mag_y;
+  sensor_packet.data.mag_z = mag_z;
+
+  int max_frames = ICM_FRAME_BUFFER;
+  #ifdef BATCH_MODE
+  if (icm_batches.room() < (unsigned int) max_frames) max_frames = icm_batches.room();
+  #endif
+  int n = icm.readFrames(icm_fifo, max_frames);
+  for (int i = 0; i < n; i++) {
+    const TeensyICM20948Frame &f = icm_fifo[i];
+
+    // the library stamps frames with micros() at the FIFO read, stepped back by the ODR, so
+    // they are on our clock already. Kinds have their own timestamps, keep them in order
+    uint64_t t = clock.extend((uint32_t) f.timestamp - chipTimeOffset);
+    if (t < icm_last_us) t = icm_last_us;
+    icm_last_us = t;
+
+    if (f.type == ICM_FRAME_QUAT) memcpy(icm_quat, f.quat, sizeof(icm_quat));
+
+    #ifdef BATCH_MODE
+    icm_sample s = {};
+    if (f.type == ICM_FRAME_QUAT) {
+      s.kind = ICM_SAMPLE_QUAT;
+      for (int j = 0; j < 4; j++) s.v[j] = icmClamp(lroundf(f.quat[j] * 16384));
+    } else {
+      s.kind = f.type == ICM_FRAME_RAW_GYRO ? ICM_SAMPLE_GYRO : ICM_SAMPLE_ACC;
+      for (int j = 0; j < 3; j++) s.v[j] = icmClamp(f.raw[j]);
+    }
+    icm_batches.add(t, s);
+    #endif
+  }
+
+  health[ICM_SLOT].reportRead(true, &sensor_packet.data.mag_x, 3 * sizeof(float));
+
+}
+#else
 // collect data from the ICM w/ modified ZaneL's library
 void Shart::collectDataICM20948() {
 
@@ -219,16 +555,109 @@ void Shart::collectDataICM20948() {
   sensor_packet.data.mag_x = mag_x;
   sensor_packet.data.mag_y = mag_y;
   sensor_packet.data.mag_z = mag_z;
+
+  // the DMP gives us no error codes, a frozen magnetometer is the only hint we get
+  health[ICM_SLOT].reportRead(true, &sensor_packet.data.mag_x, 3 * sizeof(float));
   
 }
+#endif
+
+#ifdef BMP_FIFO
+#ifdef BATCH_MODE
+static_assert((BATCH_RING_SIZE - 1) * BATCH_MAX_SAMPLES >= BMP3_FIFO_MAX_FRAMES, "a full BMP FIFO has to fit in the baro batch ring");
+#endif
+
+// Drain the BMP's FIFO. Every frame goes into the baro batches, the newest one also into the
+// sensor packet. The chip's sensor time runs on its own untrimmed oscillator, a few percent
+// off, so frames are timed like the ADXL's, by counting them on a measured period.
+// readFifo() reads the whole FIFO in one burst, frames can't be left in it for later, and
+// counting needs every frame of the read anyway. The static_assert makes sure a full FIFO
+// fits in the batch ring once send() has emptied it
+void Shart::collectDataBMP388() {
+
+  uint64_t read_us = sample_us[BMP_SLOT]; // collect() stamped the read
+  int n = bmp.readFifo(bmp_fifo, BMP3_FIFO_MAX_FRAMES);
 
+  if (bmp.getFifoOverflows() != bmp_overflows) {
+    bmp_overflows = bmp.getFifoOverflows();
+    bmp_clock.resync(); // frames were dropped, counting starts over from this read
+  }
+
+  if (n <= 0) {
+    sample_us[BMP_SLOT] = bmp_last_us;
+    // an empty FIFO isn't a read, the old temp and pres would count as a stuck sample
+    if (n < 0) health[BMP_SLOT].reportRead(false, &sensor_packet.data.temp, 2 * sizeof(float));
+    return;
+  }
+
+  uint64_t first = bmp_clock.add(read_us, n);
+  uint32_t period_ns = bmp_clock.getPeriodNs();
+
+  for (int i = 0; i < n; i++) {
+    uint64_t t = first + (uint64_t) i * period_ns / 1000;
+    if (t <= bmp_last_us) t = bmp_last_us + 1;
+    bmp_last_us = t;
+
+    #ifdef BATCH_MODE
+    baro_sample s = {};
+    float temp = bmp_fifo[i].temperature, pres = bmp_fifo[i].pressure;
+    memcpy(s.temp, &temp, sizeof(temp));
+    memcpy(s.pres, &pres, sizeof(pres));
+    baro_batches.add(t, s);
+    #endif
+  }
+
+  sensor_packet.data.temp = bmp_fifo[n - 1].temperature;
+  sensor_packet.data.pres = bmp_fifo[n - 1].pressure;
+  sample_us[BMP_SLOT] = bmp_last_us;
+
+  if (isnan(sensor_packet.data.pres)) health[BMP_SLOT].reportInvalid();
+  else health[BMP_SLOT].reportRead(true, &sensor_packet.data.temp, 2 * sizeof(float));
+
+}
+#else
 // collect data from the BMP388 over SPI
 // VERY IMPORTANT: "the_sensor.settings.op_mode = BMP3_MODE_NORMAL" in begin_SPI in Adafruit_BMP3XX.cpp or else very slow
 void Shart::collectDataBMP388() {
 
+  #if defined(RAW_BARO) || defined(FIXED_BARO)
+  #ifdef BMP_ASYNC
+  bool ok = bmp.finishRawReading(); // collect() started it
+  #else
+  bool ok = bmp.performRawReading();
+  #endif
+  // a disconnected BMP reads all zeros or all ones
+  bool invalid = bmp.raw_pressure == 0 || bmp.raw_pressure == 0xFFFFFF;
+  #ifdef FIXED_BARO
+  // integer compensation and altitude, see util/baro_fixed.h
+  int32_t temp;
+  uint32_t pres;
+  baro_fixed.compensate(bmp.raw_temperature, bmp.raw_pressure, temp, pres);
+  if (ok && !invalid) altitude_cm = baro_altitude.altitudeCm(pres);
+  #endif
+  #ifdef RAW_BARO
+  // only the ADC words, compensated on the ground with the calibration (baro.h in comms)
+  memcpy(&sensor_packet.data.temp, &bmp.raw_temperature, sizeof(uint32_t));
+  memcpy(&sensor_packet.data.pres, &bmp.raw_pressure, sizeof(uint32_t));
+  #else
+  sensor_packet.data.temp = temp * 0.01f; // in *C
+  sensor_packet.data.pres = pres * 0.01f; // in Pa
+  #endif
+  #else
   // take temperature and pressure, ignore altitude estimate to avoid expensive calculations
-  bmp.performReading();
+  #ifdef BMP_ASYNC
+  bool ok = bmp.finishReading(); // collect() started it
+  #else
+  bool ok = bmp.performReading();
+  #endif
   sensor_packet.data.temp = bmp.temperature; // in *C
   sensor_packet.data.pres = bmp.pressure; // in HPa
+  // a disconnected BMP happily "compensates" garbage into NaN
+  bool invalid = isnan(sensor_packet.data.pres);
+  #endif
 
-}
\ No newline at end of file
+  if (ok && invalid) health[BMP_SLOT].reportInvalid();
+  else health[BMP_SLOT].reportRead(ok, &sensor_packet.data.temp, 2 * sizeof(float));
+
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,68 @@
+// Ring of batch packets
+//
+// Samples are added to the active batch. When it can't take another one (full, or the
+// sample is too far from the batch's base time) the active batch is queued as "full"
+// and the next free buffer takes over, so nothing has to be written out in the middle
+// of collect(). send() drains the full batches with takeFull() until it returns nullptr.
+//
+// A FIFO drain can add several batches worth of samples in one collect(), so up to
+// BATCH_RING_SIZE - 1 full batches can wait. If they are all still waiting when the
+// active batch fills up, its samples are dropped and counted instead of overwriting a
+// batch that was never sent. sensors.cpp static_asserts that each sensor's largest drain
+// fits in an emptied ring. The drains of sensors with timestamps (LSM, ICM) also ask
+// room() first and leave whatever wouldn't fit in the FIFO. The count-timed ones (ADXL,
+// BMP) need every sample of a read, so they can only drop if send() stalls.
+
+#ifndef SHART_BATCH_BUFFER_H
+#define SHART_BATCH_BUFFER_H
+
+#include <stdint.h>
+#include <comms.h>
+
+// one active batch plus up to 8 full ones, enough for the largest FIFO drain
+#define BATCH_RING_SIZE 9
+
+template <typename Batch>
+class BatchBuffer {
+
+  public:
+
+    template <typename Sample>
+    void add(uint64_t us, const Sample &s) {
+      if (batchAdd(batches[active], us, s)) return;
+      if (waiting == BATCH_RING_SIZE - 1) {
+        dropped += batches[active].data.count;
+      } else {
+        waiting++;
+        active = (active + 1) % BATCH_RING_SIZE;
+      }
+      batchReset(batches[active]);
+      batchAdd(batches[active], us, s);
+    }
+
+    // oldest batch waiting to be sent, or nullptr. Only returns it once, and it is only
+    // good until the next add()
+    Batch *takeFull() {
+      if (waiting == 0) return nullptr;
+      Batch *b = &batches[(active + BATCH_RING_SIZE - waiting) % BATCH_RING_SIZE];
+      waiting--;
+      return b;
+    }
+
+    // samples that can be added before any get dropped, even if the first one starts a
+    // new batch because of its time
+    unsigned int room() const { return (BATCH_RING_SIZE - 1 - waiting) * BATCH_MAX_SAMPLES; }
+
+    // samples dropped since startup because no buffer was free
+    uint32_t getDropCount() const { return dropped; }
+
+  private:
+
+    Batch    batches[BATCH_RING_SIZE];
+    uint8_t  active  = 0;
+    uint8_t  waiting = 0;
+    uint32_t dropped = 0;
+
+};
+
+#endif
@@ -0,0 +1,271 @@
+// 64 bit microsecond clock on top of micros()
+//
+// micros() is 32 bits and wraps every 71.6 minutes. update() folds each reading into a 64
+// bit count, which stays right as long as it is called at least once per wrap (collect()
+// calls it every pass). extend() turns a 32 bit reading taken close to the last update()
+// (an ISR's DRDY stamp, or a read a few us later) into the same 64 bit time base.
+//
+// Only the thread calling update() may use it. Like the scheduler, it is fed the time
+// instead of reading it, so it runs the same on the host. It works on any 32 bit counter,
+// not just micros().
+//
+// SensorClock, below, maps a sensor's own timestamps onto this time base, SampleClock does
+// the same for a sensor that only has a FIFO and no timestamps. GpsClock maps this time base
+// onto GPS time.
+
+#ifndef SHART_CLOCK_H
+#define SHART_CLOCK_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+class Clock64 {
+
+  public:
+
+    uint64_t update(uint32_t now_us) {
+      if (now_us < last) high++;
+      last = now_us;
+      return full();
+    }
+
+    // anything within +-35 minutes of the last update(), clamped to 0 (a DRDY edge from
+    // before the clock started)
+    uint64_t extend(uint32_t us) const {
+      int32_t d = us - last;
+      if (d < 0 && (uint64_t) -(int64_t) d > full()) return 0;
+      return full() + d;
+    }
+
+  private:
+
+    uint64_t full() const { return ((uint64_t) high << 32) | last; }
+
+    uint32_t last = 0;
+    uint32_t high = 0;
+
+};
+
+// Puts a sensor's own sample times (its FIFO timestamps) on our clock
+//
+// Every FIFO read gives a pair: our time of the read, and the sensor time of the newest
+// sample in it, which was taken at or before the read. So read - sample is never below the
+// real offset between the two clocks, and the offset is the smallest one seen. It may creep
+// up by slew_ppm of the time between reads, so a sensor clock slower than ours is still
+// followed. Sample spacing comes from the sensor's clock, only the offset is ours.
+class SensorClock {
+
+  public:
+
+    explicit SensorClock(uint32_t slew_ppm) : slew_ppm(slew_ppm) {}
+
+    // the sensor's clock restarted (chip reset, FIFO re-enabled)
+    void reset() { valid = false; }
+
+    void observe(uint64_t read_us, uint64_t sensor_us) {
+      int64_t measured = read_us - sensor_us;
+      if (!valid || measured < offset) {
+        offset = measured;
+      } else {
+        uint64_t slew = (read_us - last_read) * slew_ppm / 1000000;
+        offset += (uint64_t) (measured - offset) < slew ? measured - offset : slew;
+      }
+      valid = true;
+      last_read = read_us;
+    }
+
+    uint64_t map(uint64_t sensor_us) const { return sensor_us + offset; }
+
+  private:
+
+    uint32_t slew_ppm;
+    bool     valid     = false;
+    int64_t  offset    = 0;
+    uint64_t last_read = 0;
+
+};
+
+// fewest samples SampleClock measures a period over, it is good to 1/320 then
+#define SAMPLE_CLOCK_MIN_SAMPLES 320
+
+// Times for a sensor's FIFO samples when the sensor has no usable timestamps (ADXL375, BMP390)
+//
+// Samples are one ODR period apart, so the sample count times the period is the sensor's
+// time, and a SensorClock puts it on ours. The chip's oscillator can be off by a few percent
+// from its nominal ODR though, so the period is measured: our time since the first read over
+// the samples that came in since. Each end of that is off by at most a period, which
+// averages out as the window grows. A FIFO that overflowed lost samples we couldn't count,
+// resync() starts the window over.
+class SampleClock {
+
+  public:
+
+    SampleClock(uint32_t nominal_ns, uint32_t slew_ppm)
+      : nominal_ns(nominal_ns), period_ns(nominal_ns), clock(slew_ppm) {}
+
+    void resync() {
+      started = false;
+      clock.reset();
+    }
+
+    // a read at read_us brought n > 0 samples, returns the time of the first one. The
+    // others follow getPeriodNs() apart
+    uint64_t add(uint64_t read_us, uint32_t n) {
+      if (!started) {
+        started    = true;
+        first_read = read_us;
+        counted    = 0;
+      } else {
+        counted += n;
+        uint64_t window = read_us - first_read;
+        uint64_t p = counted ? window * 1000 / counted : 0;
+        if (counted >= SAMPLE_CLOCK_MIN_SAMPLES && p > nominal_ns * 9 / 10 && p < nominal_ns * 11 / 10) {
+          measured  = true;
+          period_ns = p;
+        }
+      }
+      // on the nominal period the sensor time runs off ours as fast as the chip is off, more
+      // than the slew follows, so until it is measured every read sets the offset
+      if (!measured) clock.reset();
+      sensor_ns += (uint64_t) n * period_ns;
+      uint64_t newest = sensor_ns - period_ns;
+      clock.observe(read_us, newest / 1000);
+      return clock.map((newest - (uint64_t) (n - 1) * period_ns) / 1000);
+    }
+
+    uint32_t getPeriodNs() const { return period_ns; }
+
+  private:
+
+    uint32_t    nominal_ns;
+    uint32_t    period_ns;
+    SensorClock clock;
+
+    bool     started    = false;
+    bool     measured   = false;
+    uint64_t first_read = 0;
+    uint64_t counted    = 0; // samples since first_read
+    uint64_t sensor_ns  = 0;
+
+};
+
+// GpsClock's drift is the slope across this many window points, so it follows a change in
+// drift (the crystal warming up) over that many windows
+#define GPS_CLOCK_POINTS      8
+// a crystal is good to 100 ppm or so, a drift past this means GPS time jumped (receiver
+// reset, wrong week) and GpsClock starts over. So does an observation this far off
+#define GPS_CLOCK_MAX_PPB     1000000
+#define GPS_CLOCK_MAX_STEP_NS 500000000
+
+// Our clock against GPS time
+//
+// Every observation is a pair: our time something came in, and the GPS time it happened at
+// (a NAV-PVT's epoch, or a PPS edge stamped by its ISR). It came in at or after that, so like
+// with SensorClock the lag, ours - GPS, is never below the real offset, and the smallest
+// one is the best. Our crystal is off by tens of ppm though, and it moves with temperature,
+// so the lag walks. The smallest lag of each window_us is a point, the slope from the oldest
+// of the last few points to the newest is the drift, and map() goes on from the newest point
+// along it. Within a window lags are compared with the drift taken out, so the best one
+// isn't always at one end.
+//
+// Without PPS the receiver's shortest output latency is still in the lag, a constant offset
+// in everything mapped (a few ms to tens of ms), the drift is the same. PPS edges only have
+// the ISR's latency.
+class GpsClock {
+
+  public:
+
+    explicit GpsClock(uint32_t window_us) : window_us(window_us) {}
+
+    // GPS time isn't what it was (receiver reset, another time source)
+    void reset() {
+      windows   = 0;
+      open      = false;
+      drift_ppb = 0;
+      spread_ns = 0;
+    }
+
+    void observe(uint64_t our_us, uint64_t gps_ns) {
+      int64_t lag = (int64_t) (our_us * 1000 - gps_ns);
+      if (valid() && llabs(lag - predict(our_us)) > GPS_CLOCK_MAX_STEP_NS) reset();
+
+      if (!open) {
+        open       = true;
+        start_us   = our_us;
+        best_us    = our_us;
+        best_lag   = lag;
+        best_flat  = lag;
+        worst_flat = lag;
+      } else {
+        int64_t flat = lag - drift_ppb * (int64_t) (our_us - start_us) / 1000000;
+        if (flat < best_flat) {
+          best_us   = our_us;
+          best_lag  = lag;
+          best_flat = flat;
+        }
+        if (flat > worst_flat) worst_flat = flat;
+      }
+      if (!windows) { // nothing better until the first window is over
+        point_us  = best_us;
+        point_lag = best_lag;
+      }
+      if (our_us - start_us < window_us) return;
+
+      // a window is over, its best lag is the new point
+      if (windows) {
+        const Point &oldest = points[windows < GPS_CLOCK_POINTS ? 0 : windows % GPS_CLOCK_POINTS];
+        int64_t drift = (best_lag - oldest.lag) * 1000000 / (int64_t) (best_us - oldest.us);
+        if (llabs(drift) > GPS_CLOCK_MAX_PPB) {
+          reset();
+          return;
+        }
+        drift_ppb = drift;
+      }
+      points[windows % GPS_CLOCK_POINTS] = {best_us, best_lag};
+      point_us  = best_us;
+      point_lag = best_lag;
+      spread_ns = worst_flat - best_flat;
+      windows++;
+      open = false;
+    }
+
+    // there is a point to map from, and a drift once two windows are over
+    bool valid()  const { return windows || open; }
+    bool locked() const { return windows >= 2; }
+
+    // GPS ns (since the GPS epoch, 6 Jan 1980) at our_us
+    uint64_t map(uint64_t our_us) const { return our_us * 1000 - predict(our_us); }
+
+    int32_t  getDriftPpb() const { return drift_ppb; }  // we run this much faster than GPS time
+    uint32_t getSpreadNs() const { return spread_ns > UINT32_MAX ? UINT32_MAX : spread_ns; } // lags in the last window
+
+  private:
+
+    int64_t predict(uint64_t our_us) const {
+      return point_lag + drift_ppb * (int64_t) (our_us - point_us) / 1000000;
+    }
+
+    struct Point {
+      uint64_t us;
+      int64_t  lag;
+    };
+
+    uint32_t window_us;
+    uint32_t windows   = 0; // finished ones
+    Point    points[GPS_CLOCK_POINTS] = {}; // of the last ones, windows % GPS_CLOCK_POINTS is the next
+    int64_t  drift_ppb = 0;
+    uint64_t spread_ns = 0;
+
+    uint64_t point_us  = 0;
+    int64_t  point_lag = 0;
+
+    bool     open       = false; // a window is being filled
+    uint64_t start_us   = 0;
+    uint64_t best_us    = 0;
+    int64_t  best_lag   = 0;
+    int64_t  best_flat  = 0; // lag with the drift since start_us taken out
+    int64_t  worst_flat = 0;
+
+};
+
+#endif
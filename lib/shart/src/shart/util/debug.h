@@ -50,4 +50,17 @@
     sensor = status;
 #endif
 
+// Time a statement as one run of a profiler stage (PROFILE_* in comms.h), see util/profiler.h
+#ifdef DEBUG_MODE_DATARATE
+  #define PROFILE(profiler, stage, statement) \
+    { \
+      uint32_t profile_start = profileCycles(); \
+      statement; \
+      profiler.add(stage, profileCycles() - profile_start); \
+    }
+#else
+  #define PROFILE(profiler, stage, statement) \
+    statement;
+#endif
+
 #endif
\ No newline at end of file
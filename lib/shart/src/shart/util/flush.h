@@ -0,0 +1,92 @@
+// SD flush policy, decides how much of the ring buffer saveData() writes out per loop
+//
+// Writing one sector per loop caps the card at one sector per loop, and any time the card
+// spends busy (erasing, wear leveling) the ring buffer backs up with no way to catch up.
+// Instead we keep writing while the loop's time budget lasts, and ask for several sectors
+// per write so SdFat can turn them into one multi-sector transfer. How many sectors fit is
+// estimated from how long previous writes took per sector.
+//
+// A write is only started when the card isn't busy, a busy card would block us for however
+// long it likes. When sectors are queued but the card is busy before we wrote anything,
+// that loop counts as a stall.
+//
+// Nothing here touches hardware, the caller passes in the times and the busy flag.
+
+#ifndef SHART_FLUSH_H
+#define SHART_FLUSH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FLUSH_SECTOR_SIZE 512
+
+class FlushPolicy {
+
+  public:
+
+    FlushPolicy(uint32_t budget_us, uint16_t max_sectors) : budget(budget_us), max_sectors(max_sectors) {}
+
+    // call once per loop before asking next()
+    void begin(size_t used, uint32_t now_us) {
+      start = now_us;
+      written = 0;
+      if (used > max_used) max_used = used;
+    }
+
+    // Bytes to write out now, always whole sectors, 0 when this loop is done flushing
+    size_t next(size_t used, bool busy, uint32_t now_us) {
+
+      size_t queued = used / FLUSH_SECTOR_SIZE;
+      if (queued == 0) return 0;
+      if (busy) {
+        if (written == 0) stalls++;
+        return 0;
+      }
+
+      // as many sectors as the rest of the budget fits, by the current estimate. At
+      // least one per loop no matter what, that's what we always did
+      uint32_t elapsed = now_us - start;
+      uint32_t left    = elapsed < budget ? budget - elapsed : 0;
+      size_t sectors   = us_per_sector ? left / us_per_sector : 1;
+      if (sectors == 0) {
+        if (written) return 0;
+        sectors = 1;
+      }
+      if (sectors > max_sectors) sectors = max_sectors;
+      if (sectors > queued) sectors = queued;
+      return sectors * FLUSH_SECTOR_SIZE;
+
+    }
+
+    // call after every write with how long it took
+    void wrote(size_t bytes, uint32_t took_us) {
+      size_t sectors = bytes / FLUSH_SECTOR_SIZE;
+      if (sectors == 0) return;
+      written += sectors;
+      total_sectors += sectors;
+      // slow moving average, a single long write shouldn't shut the flush down for good
+      uint32_t per_sector = took_us / sectors;
+      us_per_sector = us_per_sector ? (3 * us_per_sector + per_sector) / 4 : per_sector;
+    }
+
+    size_t   getMaxUsed()      const { return max_used; }      // most bytes ever waiting in the ring buffer
+    uint32_t getStallCount()   const { return stalls; }        // loops where the card was busy with sectors queued
+    uint32_t getSectorCount()  const { return total_sectors; } // sectors written so far
+    uint32_t getUsPerSector()  const { return us_per_sector; } // current write time estimate
+
+  private:
+
+    uint32_t budget;
+    uint16_t max_sectors;
+
+    uint32_t start         = 0;
+    uint32_t written       = 0;
+    uint32_t us_per_sector = 0;
+
+    size_t   max_used      = 0;
+    uint32_t stalls        = 0;
+    uint32_t total_sectors = 0;
+
+};
+
+#endif
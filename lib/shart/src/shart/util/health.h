@@ -0,0 +1,100 @@
+// Sensor health monitor
+//
+// Reading a WHO_AM_I register before every sample doubles the bus traffic just to find
+// out what the sample read itself usually tells us. Instead, every data read is fed in
+// here, and we only ask for an explicit chip ID probe when:
+//   - the last read failed on the bus, or returned garbage (NaN pressure etc.)
+//   - the sample hasn't changed in HEALTH_STUCK_LIMIT reads (a dead chip on SPI
+//     tends to return the same bytes forever, usually 0x00 or 0xFF)
+//   - the probe budget elapsed, one probe every probe_interval_us no matter what.
+//     This is also how a sensor that is marked unavailable gets picked back up.
+//
+// A probe only decides the status, the monitor never changes it on its own.
+
+#ifndef SHART_HEALTH_H
+#define SHART_HEALTH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// consecutive identical samples before a sensor is considered suspect
+#define HEALTH_STUCK_LIMIT 64
+
+class SensorHealth {
+
+  public:
+
+    void setProbeInterval(uint32_t interval_us) { probe_interval = interval_us; }
+
+    // feed every data read, ok is false on a bus error. data is the raw sample
+    void reportRead(bool ok, const void *data, size_t len) {
+      reads++;
+      if (!ok) {
+        errors++;
+        suspect = true;
+        return;
+      }
+      uint32_t h = hash(data, len);
+      if (h == last_hash) {
+        if (++repeats >= HEALTH_STUCK_LIMIT) {
+          stuck++;
+          repeats = 0;
+          suspect = true;
+        }
+      } else {
+        repeats = 0;
+      }
+      last_hash = h;
+    }
+
+    // the bus transaction went fine but the value makes no sense
+    void reportInvalid() {
+      errors++;
+      suspect = true;
+    }
+
+    // true if an explicit ID probe should be issued now
+    bool probeDue(uint32_t now_us) const {
+      return suspect || (uint32_t)(now_us - last_probe) >= probe_interval;
+    }
+
+    // call after every probe, whatever the result
+    void reportProbe(uint32_t now_us) {
+      probes++;
+      suspect = false;
+      last_probe = now_us;
+    }
+
+    // counters, reads + probes is the number of bus transactions this sensor cost us
+    uint32_t getReadCount()  const { return reads; }
+    uint32_t getProbeCount() const { return probes; }
+    uint32_t getErrorCount() const { return errors; }
+    uint32_t getStuckCount() const { return stuck; }
+
+  private:
+
+    // FNV-1a, only used to tell "same as last time" apart
+    static uint32_t hash(const void *data, size_t len) {
+      const uint8_t *bytes = (const uint8_t *) data;
+      uint32_t h = 2166136261u;
+      for (size_t i = 0; i < len; i++) {
+        h ^= bytes[i];
+        h *= 16777619u;
+      }
+      return h;
+    }
+
+    uint32_t probe_interval = 0;
+    uint32_t last_probe     = 0;
+    uint32_t last_hash      = 0;
+    uint16_t repeats        = 0;
+    bool     suspect        = true; // probe once before trusting a sensor
+
+    uint32_t reads  = 0;
+    uint32_t probes = 0;
+    uint32_t errors = 0;
+    uint32_t stuck  = 0;
+
+};
+
+#endif
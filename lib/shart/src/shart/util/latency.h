@@ -0,0 +1,39 @@
+// Running latency statistics, max and mean of whatever durations are fed in
+//
+// Cheap enough to update on every loop. The caller measures, this only keeps score.
+
+#ifndef SHART_LATENCY_H
+#define SHART_LATENCY_H
+
+#include <stdint.h>
+
+class LatencyStat {
+
+  public:
+
+    void add(uint32_t us) {
+      if (us > max) max = us;
+      total += us;
+      count++;
+    }
+
+    // start a new reporting window
+    void reset() {
+      max = 0;
+      total = 0;
+      count = 0;
+    }
+
+    uint32_t getMax()   const { return max; }
+    uint32_t getMean()  const { return count ? total / count : 0; }
+    uint32_t getCount() const { return count; }
+
+  private:
+
+    uint32_t max   = 0;
+    uint64_t total = 0;
+    uint32_t count = 0;
+
+};
+
+#endif
@@ -0,0 +1,92 @@
+// Per stage loop profiler, for DEBUG_MODE_DATARATE
+//
+// Stages are timed with the PROFILE() macro in debug.h, in ticks of profileCycles(): the DWT
+// cycle counter on the Teensy (one tick per CPU clock, reading it is a single load), a
+// nanosecond steady clock everywhere else. Every profile window the stats go out in a
+// profile_p (comms.h) instead of as text, so they cost the same few hundred bytes whatever
+// is in them and the python tools can plot them.
+//
+// One profiler per thread, add() is not safe against a fill() on another thread.
+
+#ifndef SHART_PROFILER_H
+#define SHART_PROFILER_H
+
+#include <stdint.h>
+#include <Arduino.h>
+#include <comms.h>
+
+#ifdef ARM_DWT_CYCCNT
+// the Teensy 4 startup code already turns the cycle counter on
+inline uint32_t profileCycles() { return ARM_DWT_CYCCNT; }
+inline uint32_t profileClockHz() { return F_CPU_ACTUAL; }
+#else
+#include <chrono>
+inline uint32_t profileCycles() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline uint32_t profileClockHz() { return 1000000000; }
+#endif
+
+class LoopProfiler {
+
+  public:
+
+    LoopProfiler() { reset(); }
+
+    void add(uint8_t stage, uint32_t ticks) {
+      Stage &s = stages[stage];
+      if (ticks < s.min) s.min = ticks;
+      if (ticks > s.max) s.max = ticks;
+      s.total += ticks;
+      s.count++;
+      uint16_t &bucket = s.hist[bucketOf(ticks)];
+      if (bucket != 0xFFFF) bucket++;
+    }
+
+    // the stats since the last fill() go into p (checksum not included), then a new window starts
+    void fill(profile_p &p, uint32_t us, unsigned char source) {
+      p.data.us       = us;
+      p.data.clock_hz = profileClockHz();
+      p.data.source   = source;
+      for (unsigned int i = 0; i < PROFILE_NUM_STAGES; i++) {
+        const Stage &s = stages[i];
+        profile_stage &out = p.data.stages[i];
+        out.count = s.count;
+        out.min   = s.count ? s.min : 0;
+        out.max   = s.max;
+        out.mean  = s.count ? s.total / s.count : 0;
+        memcpy(out.hist, s.hist, sizeof(out.hist));
+      }
+      reset();
+    }
+
+  private:
+
+    struct Stage {
+      uint32_t count;
+      uint32_t min;
+      uint32_t max;
+      uint64_t total;
+      uint16_t hist[PROFILE_BUCKETS];
+    };
+
+    void reset() {
+      for (Stage &s : stages) {
+        memset(&s, 0, sizeof(s));
+        s.min = UINT32_MAX;
+      }
+    }
+
+    // see profile_stage in comms.h
+    static unsigned int bucketOf(uint32_t ticks) {
+      if (ticks < 32) return 0;
+      unsigned int b = 31 - __builtin_clz(ticks) - 4; // floor(log2) - 4
+      return b < PROFILE_BUCKETS ? b : PROFILE_BUCKETS - 1;
+    }
+
+    Stage stages[PROFILE_NUM_STAGES];
+
+};
+
+#endif
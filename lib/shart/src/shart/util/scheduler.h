@@ -0,0 +1,160 @@
+// Sample scheduler, decides which sensors get read on a given pass through collect()
+//
+// Every sensor owns a slot. A slot is either edge driven (the sensor's DRDY/INT line
+// fires an interrupt and the ISR calls notify()) or period driven (no pin wired, we
+// read once every period_us). Either way a sensor is only read when it actually has
+// a new sample, so each one runs at its own ODR instead of at the speed of the loop.
+//
+// Edge driven slots also keep their period as a watchdog: if no edge shows up for
+// SCHEDULER_STALE_PERIODS periods the slot is served anyway, so a dead sensor still
+// gets its status checked instead of silently never being touched again.
+//
+// Every read also gets a sample time: the time of the DRDY edge it was served for, or the
+// time due() was called for period driven (and stale) reads, so call due() right before
+// the read with a fresh micros().
+//
+// The ISR side only ever stamps and increments a counter and the loop side only ever
+// reads them, so nothing here needs to mask interrupts. Nothing touches hardware except
+// attach(), which means the same code runs in the host simulation (see scheduler_sim.h).
+
+#ifndef SHART_SCHEDULER_H
+#define SHART_SCHEDULER_H
+
+#include <stdint.h>
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+#define NO_DRDY_PIN -1
+
+// how many missed periods before an edge driven slot is served without an edge
+#define SCHEDULER_STALE_PERIODS 4
+
+template <uint8_t N>
+class SampleScheduler {
+
+  static_assert(N <= 8, "attach() only has ISR thunks for 8 slots");
+
+  public:
+
+    // period driven slot, first read happens right away
+    void setPeriod(uint8_t slot, uint32_t period_us, uint32_t now_us) {
+      slots[slot].period   = period_us;
+      slots[slot].next_due = now_us;
+      slots[slot].edge     = false;
+    }
+
+    // edge driven slot, period is only used for the stale watchdog
+    void setInterrupt(uint8_t slot, uint32_t period_us, uint32_t now_us) {
+      setPeriod(slot, period_us, now_us + period_us * SCHEDULER_STALE_PERIODS);
+      slots[slot].edge     = true;
+      slots[slot].consumed = edges[slot];
+    }
+
+    // DRDY edge at now_us, this is the only thing the ISR does
+    void notify(uint8_t slot, uint32_t now_us) {
+      edge_us[slot] = now_us;
+      edges[slot]++;
+    }
+
+    // True if the slot should be read now. Consumes the pending edge(s) or period
+    bool due(uint8_t slot, uint32_t now_us) {
+
+      Slot &s = slots[slot];
+
+      if (s.edge) {
+        uint32_t e = edges[slot];
+        if (e != s.consumed) {
+          // more than one edge since the last read means we missed samples
+          s.overruns += e - s.consumed - 1;
+          s.consumed  = e;
+          s.sample    = edge_us[slot]; // after the count: if an edge sneaks in, its sample is the one we read
+          s.next_due  = now_us + s.period * SCHEDULER_STALE_PERIODS;
+          s.reads++;
+          return true;
+        }
+        if ((int32_t)(now_us - s.next_due) < 0) return false;
+        s.next_due = now_us + s.period * SCHEDULER_STALE_PERIODS;
+        s.sample   = now_us;
+        s.stale++;
+        s.reads++;
+        return true;
+      }
+
+      if ((int32_t)(now_us - s.next_due) < 0) return false;
+
+      // advance by whole periods so the rate doesn't drift with loop jitter,
+      // but don't try to catch up on periods we already slept through
+      s.next_due += s.period;
+      if ((int32_t)(now_us - s.next_due) >= 0) {
+        uint32_t behind = (now_us - s.next_due) / s.period + 1;
+        s.overruns += behind;
+        s.next_due += behind * s.period;
+      }
+      s.sample = now_us;
+      s.reads++;
+      return true;
+    }
+
+    // micros() of the sample the last due() returned true for, see above
+    uint32_t getSampleTime(uint8_t slot)   const { return slots[slot].sample; }
+
+    uint32_t getReadCount(uint8_t slot)    const { return slots[slot].reads; }
+    uint32_t getOverrunCount(uint8_t slot) const { return slots[slot].overruns; }
+    uint32_t getStaleCount(uint8_t slot)   const { return slots[slot].stale; }
+
+#ifdef ARDUINO
+    // Route a DRDY pin to a slot. Only one scheduler instance can own interrupts
+    void attach(uint8_t slot, int pin, uint32_t period_us, int mode = RISING) {
+      instance = this;
+      setInterrupt(slot, period_us, micros());
+      pinMode(pin, INPUT);
+      attachInterrupt(digitalPinToInterrupt(pin), thunk(slot), mode);
+    }
+#endif
+
+  private:
+
+    struct Slot {
+      uint32_t period   = 0;
+      uint32_t next_due = 0;
+      uint32_t consumed = 0;
+      uint32_t sample   = 0;
+      uint32_t reads    = 0;
+      uint32_t overruns = 0;
+      uint32_t stale    = 0;
+      bool     edge     = false;
+    };
+
+    Slot slots[N];
+    volatile uint32_t edges[N]   = {};
+    volatile uint32_t edge_us[N] = {};
+
+#ifdef ARDUINO
+    static SampleScheduler *instance;
+
+    template <uint8_t S>
+    static void isr() { instance->notify(S, micros()); }
+
+    static void (*thunk(uint8_t slot))() {
+      switch (slot) {
+        case 0:  return isr<0>;
+        case 1:  return isr<1>;
+        case 2:  return isr<2>;
+        case 3:  return isr<3>;
+        case 4:  return isr<4>;
+        case 5:  return isr<5>;
+        case 6:  return isr<6>;
+        default: return isr<7>;
+      }
+    }
+#endif
+
+};
+
+#ifdef ARDUINO
+template <uint8_t N>
+SampleScheduler<N> *SampleScheduler<N>::instance = nullptr;
+#endif
+
+#endif
@@ -0,0 +1,60 @@
+// Host-side stand-in for sensor DRDY lines
+//
+// Lets the scheduler be driven on Linux without a board attached. A SimulatedDrdy
+// produces edges at a sensor's ODR (plus optional jitter) and hands them to the
+// scheduler exactly like the ISR would. Step the simulated clock, call advanceTo()
+// on every source, then run the same due() checks collect() does, and compare
+// getReadCount() against edges to get the achieved rate and the number of dropped
+// samples for a given loop time.
+
+#ifndef SHART_SCHEDULER_SIM_H
+#define SHART_SCHEDULER_SIM_H
+
+#include <stdint.h>
+#include "scheduler.h"
+
+class SimulatedDrdy {
+
+  public:
+
+    // jitter_us is the peak deviation of each edge from its nominal time
+    SimulatedDrdy(uint8_t slot, uint32_t period_us, uint32_t phase_us = 0, uint32_t jitter_us = 0)
+      : slot(slot), period(period_us), jitter(jitter_us), next_edge(phase_us) {}
+
+    // fire every edge up to and including now_us
+    template <uint8_t N>
+    void advanceTo(uint32_t now_us, SampleScheduler<N> &scheduler) {
+      while ((int32_t)(now_us - (next_edge + offset())) >= 0) {
+        scheduler.notify(slot, next_edge + offset());
+        edges++;
+        next_edge += period;
+        step();
+      }
+    }
+
+    uint32_t getEdgeCount() const { return edges; }
+
+  private:
+
+    // small xorshift so runs are repeatable without pulling in <random>
+    int32_t offset() const {
+      if (jitter == 0) return 0;
+      return (int32_t)(rng % (2 * jitter + 1)) - (int32_t)jitter;
+    }
+
+    void step() {
+      rng ^= rng << 13;
+      rng ^= rng >> 17;
+      rng ^= rng << 5;
+    }
+
+    uint8_t  slot;
+    uint32_t period;
+    uint32_t jitter;
+    uint32_t next_edge;
+    uint32_t edges = 0;
+    uint32_t rng   = 0x6D656F77;
+
+};
+
+#endif
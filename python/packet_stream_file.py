@@ -13,15 +13,79 @@ SYNC_BYTE    : bytes = b'\xaa'
 TYPE_SENSOR  : bytes = b'\x0b'
 TYPE_GPS     : bytes = b'\xca'
 TYPE_COMMAND : bytes = b'\xa5'
+TYPE_IMU_BATCH   : bytes = b'\x1b'
+TYPE_HIGHG_BATCH : bytes = b'\x2b'
+TYPE_BARO_BATCH  : bytes = b'\x3b'
+TYPE_BARO_CALIB  : bytes = b'\x3c'
+TYPE_ICM_BATCH   : bytes = b'\x4b'
+TYPE_TIMESYNC    : bytes = b'\x5c'
+TYPE_DELTA       : bytes = b'\x0d'
+TYPE_PROFILE     : bytes = b'\x9f'
 
 # struct specifications following documentation at https://docs.python.org/3/library/struct.html
 # note that endian-ness matters
 # these structs are defined in comms.h in the Aerobing firmware folder
 PACKET_SPEC = {
-    TYPE_SENSOR : (44, '<I6h5f3h2B'), 
-    TYPE_GPS    : (52, '<I6i3Iif4B'),
+    TYPE_SENSOR : (56, '<2I6h5f3h4H2B'),
+    TYPE_GPS    : (56, '<2I6i3Iif4B'),
+    TYPE_PROFILE: (636, '<2I2BH' + '4I16H' * 13),
+    TYPE_BARO_CALIB: (24, '<21s3x'),
+    TYPE_TIMESYNC  : (28, '<3I2iIHbB'),
 }
 
+# sensor packet status bit (RAW_BARO): temp and pres are the BMP390's ADC words, see compensateBaro
+RAW_BARO_FLAG = 0x40
+
+# timesync packet flags, and the ns in a GPS week
+TIMESYNC_LOCKED = 0x01 # drift measured
+TIMESYNC_PPS    = 0x02 # from the receiver's PPS edges, otherwise off by its output latency
+TIMESYNC_LEAP   = 0x04 # leap seconds valid
+GPS_WEEK_NS = 604800 * 10**9
+
+# GPS ns (since 6 Jan 1980) at us on the flight computer's clock, from a timesync tuple
+def gpsTimeNs(timesync: tuple, us: int) -> int:
+    sync_us, sync_us_hi, tow_ms, tow_ns, drift_ppb, spread_ns, week, leap_s, flags = timesync
+    dt = us - (sync_us | sync_us_hi << 32)
+    return week * GPS_WEEK_NS + tow_ms * 10**6 + tow_ns + dt * 1000 - dt * drift_ppb // 10**6
+
+# batch packets are variable length: a fixed header (us of the first sample, count, bits 32-39 of us)
+# followed by count samples, each one starting with its dt in us from the previous sample
+BATCH_HEADER_SPEC = (6, '<IBB')
+BATCH_SAMPLE_SPEC = {
+    TYPE_IMU_BATCH   : (14, '<H6h'),
+    TYPE_HIGHG_BATCH : (8,  '<H3h'),
+    TYPE_BARO_BATCH  : (10, '<H2f'),
+    TYPE_ICM_BATCH   : (12, '<HBx4h'), # kind, then a Q14 quaternion (w x y z) or raw gyro/acc (x y z 0)
+}
+
+# kinds of ICM batch samples (ICM_FIFO)
+ICM_SAMPLE_QUAT = 0
+ICM_SAMPLE_GYRO = 1
+ICM_SAMPLE_ACC  = 2
+
+# field widths (bytes) of packets that can be delta compressed (COMPRESS_LOG), see delta.h in comms
+DELTA_FIELD_WIDTHS = {
+    TYPE_SENSOR : [4, 4, 2,2,2, 2,2,2, 4,4,4, 4, 4, 2,2,2, 2,2,2,2, 1, 1],
+    TYPE_GPS    : [4, 4, 4,4,4, 4,4,4, 4,4,4, 4, 4, 1,1,1,1],
+}
+
+# profile packets (DEBUG_MODE_DATARATE), stage names in the order of PROFILE_* in comms.h
+PROFILE_STAGES = ['reconnect', 'collect icm', 'collect lsm', 'collect bmp', 'collect adxl', 'collect gps',
+                  'status icm', 'status lsm', 'status bmp', 'status adxl', 'save', 'transmit',
+                  'log']
+
+# one line per stage that ran: runs, then min/mean/max in us, then the log2 histogram
+def formatProfile(packet: tuple) -> str:
+    us, clock_hz, source, _, batch_drops = packet[0:5]
+    lines = [f"{'storage thread' if source else 'sampling loop'} at {us} us" + (f", {batch_drops} batched samples dropped" if batch_drops else "")]
+    for i, name in enumerate(PROFILE_STAGES):
+        count, lo, hi, mean = packet[5 + 20 * i : 9 + 20 * i]
+        hist = packet[9 + 20 * i : 25 + 20 * i]
+        if count:
+            scale = 1e6 / clock_hz
+            lines.append(f"  {name:<13}{count:>8} runs {lo * scale:9.2f} {mean * scale:9.2f} {hi * scale:9.2f} us  {list(hist)}")
+    return "\n".join(lines)
+
 # Raw IMU processing taken from adafruit library (i.e. from LSM datasheet)
 def convertRawIMU(ax: int, ay: int, az: int, gx: int, gy: int, gz: int) -> tuple[float]:
 
@@ -35,40 +99,153 @@ def convertRawIMU(ax: int, ay: int, az: int, gx: int, gy: int, gz: int) -> tuple
 
     return c_ax, c_ay, c_az, c_gx, c_gy, c_gz
 
+# BMP390 compensation, baro.h in comms (the Bosch driver's double precision math, step for step)
+# python floats are doubles, f32() is the float rounding of the driver's pow_bmp3(), so the results
+# are bit for bit what the flight computer would have logged
+def f32(x: float) -> float:
+    return struct.unpack('<f', struct.pack('<f', x))[0]
+
+def baroPow(base: float, power: int) -> float:
+    out = 1.0
+    for _ in range(power):
+        out = f32(f32(base) * out)
+    return out
+
+def parseBaroCalib(nvm: bytes) -> tuple[float]:
+    t1, t2, t3, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11 = struct.unpack('<HHbhhbbHHbbhbb', nvm)
+    return (t1 / 2.0**-8, t2 / 2.0**30, t3 / 2.0**48,
+            (p1 - 16384) / 2.0**20, (p2 - 16384) / 2.0**29, p3 / 2.0**32, p4 / 2.0**37, p5 / 2.0**-3,
+            p6 / 2.0**6, p7 / 2.0**8, p8 / 2.0**15, p9 / 2.0**48, p10 / 2.0**48, p11 / 2.0**65)
+
+# raw temp and pres ADC words to C and Pa
+def compensateBaro(calib: tuple[float], raw_temp: int, raw_pres: int) -> tuple[float]:
+    t1, t2, t3, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11 = calib
+    d1 = raw_temp - t1
+    t_lin = d1 * t2 + (d1 * d1) * t3
+    out1 = p5 + p6 * t_lin + p7 * baroPow(t_lin, 2) + p8 * baroPow(t_lin, 3)
+    out2 = raw_pres * (p1 + p2 * t_lin + p3 * baroPow(t_lin, 2) + p4 * baroPow(t_lin, 3))
+    out3 = baroPow(raw_pres, 2) * (p9 + p10 * t_lin) + baroPow(raw_pres, 3) * p11
+    return t_lin, out1 + out2 + out3
+
 class PacketStream:
     def __init__(self, filename):
         self.filename = filename
         self.file = None
         self.error_state = 0
+        self.last_packet = {} # last good packet data of each type, what delta frames apply to
+        self.baro_calib = None # from the last calibration packet, for RAW_BARO sensor packets
+        self.timesync = None # the last timesync packet, see gps_time()
 
     def begin(self):
         self.file = open(self.filename, mode='rb')
 
-    # Function to calculate the checksum
-    def calculate_checksum(self, data: bytes) -> bytes:
-        checksum_a = 0
-        checksum_b = 0
+    # GPS time in ns of a packet's us (us | us_hi << 32), with the last timesync packet. None before one
+    def gps_time(self, us: int) -> int:
+        return gpsTimeNs(self.timesync, us) if self.timesync else None
+
+    # CRC-16/CCITT-FALSE over the packet data, same as CHECKSUM in comms.h
+    def calculate_checksum(self, data: bytes) -> int:
+        crc = 0xFFFF
         for byte in data:
-            checksum_a += byte
-            checksum_b += checksum_a
-        return bytes([checksum_a & 0xFF, checksum_b & 0xFF])
+            crc ^= byte << 8
+            for _ in range(8):
+                crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+                crc &= 0xFFFF
+        return crc
+
+    # delta frames are rebuilt from the last packet of the same type, then handled like that packet
+    def read_delta(self, received_checksum: int) -> tuple[int, tuple]:
+        packet_type_byte = self.file.read(1)
+        length = self.file.read(1)[0]
+        body = self.file.read(length)
+        if packet_type_byte not in self.last_packet:
+            return None, None # no keyframe yet
+
+        packet_data = bytearray(self.last_packet[packet_type_byte])
+        offset, i = 0, 0
+        for width in DELTA_FIELD_WIDTHS[packet_type_byte]:
+            z, shift = 0, 0
+            while True:
+                if i >= len(body):
+                    return self.delta_failed(packet_type_byte)
+                byte = body[i]
+                i += 1
+                z |= (byte & 0x7F) << shift
+                shift += 7
+                if not byte & 0x80:
+                    break
+            delta = (z >> 1) ^ -(z & 1)
+            field = int.from_bytes(packet_data[offset:offset + width], 'little')
+            packet_data[offset:offset + width] = ((field + delta) % (1 << (8 * width))).to_bytes(width, 'little')
+            offset += width
+
+        if i != len(body) or self.calculate_checksum(packet_data) != received_checksum:
+            return self.delta_failed(packet_type_byte)
+        self.last_packet[packet_type_byte] = bytes(packet_data)
+        return packet_type_byte, self.unpack(packet_type_byte, packet_data)
+
+    # a bad delta breaks the chain, wait for the next keyframe
+    def delta_failed(self, packet_type_byte: bytes) -> tuple[int, tuple]:
+        print("Checksum failed!")
+        del self.last_packet[packet_type_byte]
+        self.error_state = 1
+        return None, None
+
+    # sensor packets with raw baro words get them compensated, with the last calibration packet.
+    # Without one yet, temp and pres are left as the raw words
+    def unpack(self, packet_type_byte: bytes, packet_data: bytes) -> tuple:
+        packet = struct.unpack(PACKET_SPEC[packet_type_byte][1], packet_data)
+        if packet_type_byte == TYPE_BARO_CALIB:
+            self.baro_calib = parseBaroCalib(packet[0])
+        elif packet_type_byte == TYPE_TIMESYNC:
+            self.timesync = packet
+        elif packet_type_byte == TYPE_SENSOR and packet[-2] & RAW_BARO_FLAG:
+            raw_temp, raw_pres = struct.unpack_from('<2I', packet_data, 32)
+            baro = compensateBaro(self.baro_calib, raw_temp, raw_pres) if self.baro_calib else (raw_temp, raw_pres)
+            packet = packet[:11] + baro + packet[13:]
+        return packet
+
+    # batch packets come back as (us, [(t, sample...), ...]) with t the absolute time of each sample
+    def read_batch(self, packet_type_byte: bytes, received_checksum: int) -> tuple[int, tuple]:
+        header = self.file.read(BATCH_HEADER_SPEC[0])
+        us, count, us_hi = struct.unpack(BATCH_HEADER_SPEC[1], header)
+        us |= us_hi << 32
+        sample_size, sample_format = BATCH_SAMPLE_SPEC[packet_type_byte]
+        body = self.file.read(count * sample_size)
+
+        if self.calculate_checksum(header + body) != received_checksum:
+            print("Checksum failed!")
+            self.error_state = 1
+            return None, None
+
+        samples = []
+        t = us
+        for i in range(count):
+            sample = struct.unpack_from(sample_format, body, i * sample_size)
+            t += sample[0]
+            samples.append((t,) + sample[1:])
+        return packet_type_byte, (us, samples)
 
     # Function to read data from serial and process packets
     def read_packet(self) -> tuple[int, tuple]:
         if (self.file.read(1) == SYNC_BYTE):
                 # Found sync byte, read packet type
                 packet_type_byte = self.file.read(1)
-                if packet_type_byte in PACKET_SPEC:
-                    received_checksum_a, received_checksum_b = struct.unpack('<BB', self.file.read(2))
+                if packet_type_byte == TYPE_DELTA:
+                    received_checksum, = struct.unpack('<H', self.file.read(2))
+                    return self.read_delta(received_checksum)
+                elif packet_type_byte in BATCH_SAMPLE_SPEC:
+                    received_checksum, = struct.unpack('<H', self.file.read(2))
+                    return self.read_batch(packet_type_byte, received_checksum)
+                elif packet_type_byte in PACKET_SPEC:
+                    received_checksum, = struct.unpack('<H', self.file.read(2))
                     packet_info = PACKET_SPEC[packet_type_byte]
                     packet_size = packet_info[0]
                     packet_data = self.file.read(packet_size)
-                        
-                    calculated_checksum_a, calculated_checksum_b = self.calculate_checksum(packet_data)
 
-                    if (received_checksum_a, received_checksum_b) == (calculated_checksum_a, calculated_checksum_b):
-                        packet_format = packet_info[1]
-                        return packet_type_byte, struct.unpack(packet_format, packet_data)
+                    if received_checksum == self.calculate_checksum(packet_data):
+                        self.last_packet[packet_type_byte] = packet_data
+                        return packet_type_byte, self.unpack(packet_type_byte, packet_data)
                     else:
                         print("Checksum failed!")
                         self.error_state = 1
@@ -79,7 +256,10 @@ class PacketStream:
             self.error_state = 3 # error state 2 if we are at eof
         return None, None
     
-# note to Julie: barometer data is stored in the last 2 spots of the sensor tuple (temp in C and pressure in Pa)
+# sensor tuples: us and us_hi (the packet's time is us | us_hi << 32), then lsm, mag, temp in C and pressure in Pa,
+# adxl, then the age in us of the lsm/icm/bmp/adxl data (65535 if it is older than that, or there is none)
+# gps tuples also start with us and us_hi
+# timesync tuples too, then the GPS time at that us and the drift, gps_time() maps any packet's us with the last one
 if __name__ == "__main__":
     packet_reader = PacketStream(FILE_NAME)
     packet_reader.begin()
@@ -91,6 +271,22 @@ if __name__ == "__main__":
             print("[SENSOR] " + str(packet))
         elif packet_type == TYPE_GPS:
             print("[GPS] " + str(packet))
+        elif packet_type == TYPE_PROFILE:
+            print("[PROFILE] " + formatProfile(packet))
+        elif packet_type == TYPE_IMU_BATCH:
+            print("[IMU BATCH] " + str(len(packet[1])) + " samples from " + str(packet[0]))
+        elif packet_type == TYPE_HIGHG_BATCH:
+            print("[HIGH-G BATCH] " + str(len(packet[1])) + " samples from " + str(packet[0]))
+        elif packet_type == TYPE_BARO_BATCH:
+            print("[BARO BATCH] " + str(len(packet[1])) + " samples from " + str(packet[0]))
+        elif packet_type == TYPE_ICM_BATCH:
+            quats = sum(1 for s in packet[1] if s[1] == ICM_SAMPLE_QUAT)
+            print("[ICM BATCH] " + str(len(packet[1])) + " samples (" + str(quats) + " quaternions) from " + str(packet[0]))
+        elif packet_type == TYPE_BARO_CALIB:
+            print("[BARO CALIB] " + packet[0].hex())
+        elif packet_type == TYPE_TIMESYNC:
+            print("[TIMESYNC] week " + str(packet[6]) + " tow " + str(packet[2] / 1e3 + packet[3] / 1e9) + " s at " + str(packet[0] | packet[1] << 32)
+                  + " us, drift " + str(packet[4]) + " ppb, flags " + hex(packet[8]))
         else:
             continue
     
@@ -10,6 +10,8 @@ SYNC_BYTE    : bytes = b'\xaa'
 TYPE_SENSOR  : bytes = b'\x0b'
 TYPE_GPS     : bytes = b'\xca'
 TYPE_COMMAND : bytes = b'\xa5'
+TYPE_PROFILE : bytes = b'\x9f'
+TYPE_TIMESYNC: bytes = b'\x5c'
 
 # shart-defined command codes
 START_COMMAND : int = 0x6D656F77
@@ -21,14 +23,33 @@ FILENAME = 'python/out.poop'
 # struct specifications following documentation at https://docs.python.org/3/library/struct.html
 # defined in shart comms.h
 PACKET_SPEC = {
-    TYPE_SENSOR  : (44, '<I6h5f3h2B'), 
-    TYPE_GPS     : (52, '<I6i3Iif4B'),
+    TYPE_SENSOR  : (56, '<2I6h5f3h4H2B'),
+    TYPE_GPS     : (56, '<2I6i3Iif4B'),
     TYPE_COMMAND : (4,  '<i'),
+    TYPE_PROFILE : (636, '<2I2BH' + '4I16H' * 13),
+    TYPE_TIMESYNC: (28, '<3I2iIHbB'), # GPS time at us, see packet_stream_file.py
 }
 
 #NUM_PACKETS_TO_READ = 1000 # set very high or infinity if u dont want a limit
 NUM_PACKETS_TO_READ = float('inf')
 
+# profile packets (DEBUG_MODE_DATARATE), stage names in the order of PROFILE_* in comms.h
+PROFILE_STAGES = ['reconnect', 'collect icm', 'collect lsm', 'collect bmp', 'collect adxl', 'collect gps',
+                  'status icm', 'status lsm', 'status bmp', 'status adxl', 'save', 'transmit',
+                  'log']
+
+# one line per stage that ran: runs, then min/mean/max in us, then the log2 histogram
+def formatProfile(packet: tuple) -> str:
+    us, clock_hz, source, _, batch_drops = packet[0:5]
+    lines = [f"{'storage thread' if source else 'sampling loop'} at {us} us" + (f", {batch_drops} batched samples dropped" if batch_drops else "")]
+    for i, name in enumerate(PROFILE_STAGES):
+        count, lo, hi, mean = packet[5 + 20 * i : 9 + 20 * i]
+        hist = packet[9 + 20 * i : 25 + 20 * i]
+        if count:
+            scale = 1e6 / clock_hz
+            lines.append(f"  {name:<13}{count:>8} runs {lo * scale:9.2f} {mean * scale:9.2f} {hi * scale:9.2f} us  {list(hist)}")
+    return "\n".join(lines)
+
 # Raw IMU processing taken from adafruit library (i.e. from LSM datasheet)
 def convertRawIMU(ax: int, ay: int, az: int, gx: int, gy: int, gz: int) -> tuple[float]:
 
@@ -67,14 +88,15 @@ class PacketStream:
                 break
         print(" Done!", flush=True)
 
-    # Function to calculate the checksum
+    # CRC-16/CCITT-FALSE over the packet data, same as CHECKSUM in comms.h, little endian on the wire
     def __calculate_checksum(self, data: bytes) -> bytes:
-        checksum_a = 0
-        checksum_b = 0
+        crc = 0xFFFF
         for byte in data:
-            checksum_a += byte
-            checksum_b += checksum_a
-        return bytes([checksum_a & 0xFF, checksum_b & 0xFF])
+            crc ^= byte << 8
+            for _ in range(8):
+                crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+                crc &= 0xFFFF
+        return crc.to_bytes(2, 'little')
 
     # Function to read data from serial and process packets
     def read_packet(self) -> tuple[int, tuple]:
@@ -85,7 +107,7 @@ class PacketStream:
                 # Found sync byte, read packet type
                 packet_type_byte = self.serial_bus.read(1)
                 if packet_type_byte in PACKET_SPEC:
-                    received_checksums = bytes(struct.unpack('<BB', self.serial_bus.read(2)))
+                    received_checksums = self.serial_bus.read(2)
                     packet_info = PACKET_SPEC[packet_type_byte]
                     packet_size = packet_info[0]
                     packet_data = self.serial_bus.read(packet_size)
@@ -155,6 +177,10 @@ if __name__ == "__main__":
             #print(convertRawIMU(*packet[1:7]))
         elif packet_type == TYPE_GPS:
             print("[GPS] " + str(packet))
+        elif packet_type == TYPE_PROFILE:
+            print("[PROFILE] " + formatProfile(packet))
+        elif packet_type == TYPE_TIMESYNC:
+            print("[TIMESYNC] " + str(packet))
         else:
             continue
         #"""
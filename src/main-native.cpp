@@ -0,0 +1,194 @@
+/*******************************************************************************
+* File Name: main-native.cpp
+*
+* Description:
+*   The shart logger built for a PC (pio run -e native). Same setup() and loop()
+*   as main-shartlogger.cpp, but the sensors, GPS and SD card are the models in
+*   lib/native. Runs the whole collect/send pipeline, so it can be profiled with
+*   perf or run under sanitizers without a flight board.
+*
+*   usage: program [seconds] [--stepped us] [--out dir] [--usb file]
+*                  [--replay file [--fast]]
+*     seconds       how long to log for, 10 by default
+*     --stepped us  simulated clock moving us per loop instead of real time
+*     --out dir     where the SD card's files are saved, "native_sd" by default
+*     --usb file    copy of everything written to the USB serial port
+*     --replay file feed a recorded dataN.poop through send() instead of
+*                   reading the sensors, at the speed it was recorded
+*     --fast        replay as fast as possible, the clock jumps straight to
+*                   each packet's recorded time (repeatable, like --stepped)
+*
+* Author: AeroBing!
+*
+*******************************************************************************/
+#include <chrono>
+#include <Arduino.h>
+#include <shart.h>
+#include <native_hal.h>
+#include <native_models.h>
+#include <log_replay.h>
+#include <TeensyThreads.h>
+
+Shart *shart;
+
+void setup() {
+
+  shart = new Shart();
+
+  shart->init();
+
+}
+
+void loop() {
+
+  shart->reconnect();
+  shart->collect();
+  shart->send();
+  shart->maybeFinish();
+
+}
+
+// one loop of a replay, the packets are already in from Shart::replay()
+static void replayLoop() {
+
+  shart->send();
+  shart->maybeFinish();
+
+}
+
+// Replay the whole log. Packets recorded in the same loop go out in the same send()
+static uint64_t replayLog(hal::LogReplay &log, bool fast, uint32_t step_us) {
+
+  uint64_t start = hal::now();
+  uint64_t loop_time = UINT64_MAX;
+  uint64_t loops = 0;
+  size_t len;
+  while (const unsigned char *packet = log.next(len)) {
+    uint64_t t;
+    if (log.time(t) && t != loop_time) {
+      replayLoop();
+      loops++;
+      uint64_t due = start + t;
+      if (fast) {
+        if (hal::now() < due) hal::advance(due - hal::now());
+      } else {
+        while (hal::now() < due) {
+          replayLoop();
+          loops++;
+          if (step_us) hal::advance(step_us);
+        }
+      }
+      loop_time = t;
+    }
+    shart->replay(packet, len);
+  }
+  replayLoop();
+  return loops + 1;
+
+}
+
+// what the ground station sends
+static void sendCommand(int32_t command) {
+  command_p packet;
+  packet.data.command = command;
+  CHECKSUM(packet)
+  MAIN_SERIAL_PORT.feed(&packet, sizeof(packet));
+}
+
+int main(int argc, char **argv) {
+
+  double seconds = 10;
+  uint32_t step_us = 0;
+  const char *out_dir = "native_sd";
+  FILE *usb = nullptr;
+  hal::LogReplay log;
+  bool replaying = false;
+  bool fast = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--stepped") && i + 1 < argc) step_us = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--out") && i + 1 < argc) out_dir = argv[++i];
+    else if (!strcmp(argv[i], "--usb") && i + 1 < argc) {
+      usb = fopen(argv[++i], "wb");
+      if (!usb) {
+        perror(argv[i]);
+        return 1;
+      }
+    }
+    else if (!strcmp(argv[i], "--replay") && i + 1 < argc) {
+      replaying = true;
+      if (!log.open(argv[++i])) {
+        perror(argv[i]);
+        return 1;
+      }
+    }
+    else if (!strcmp(argv[i], "--fast")) fast = true;
+    else if (argv[i][0] != '-') seconds = atof(argv[i]);
+    else {
+      fprintf(stderr, "usage: %s [seconds] [--stepped us] [--out dir] [--usb file] [--replay file [--fast]]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  // the same wiring shart.h describes
+  hal::attachSpi(BMP_SPI_BUS, BMP_CS, &hal::bmp390);
+  hal::attachSpi(ADXL_SPI_BUS, ADXL_CS, &hal::adxl375);
+  hal::attachI2c(LSM_I2C_ADDR, &hal::lsm6dso32);
+  hal::attachSerial(GPS_SERIAL_PORT, &hal::ublox);
+  hal::ublox.pps_pin = GPS_PPS_PIN; // NO_DRDY_PIN is -1, no pin
+  USB_SERIAL_PORT.setOutput(usb);
+
+  if (replaying && fast && !step_us) step_us = 1000; // only used once the log is over
+  if (step_us) hal::setClockMode(hal::STEPPED);
+
+  #ifndef START_ON_POWERUP
+  sendCommand(START_COMMAND);
+  #endif
+  setup();
+
+  uint64_t start = hal::now();
+  uint64_t end   = start + (uint64_t) (seconds * 1e6);
+  uint64_t loops = 0;
+  auto wall = std::chrono::steady_clock::now();
+  if (replaying) {
+    loops = replayLog(log, fast, step_us);
+    end = hal::now();
+  }
+  while (hal::now() < end) {
+    loop();
+    hal::runTimers(); // between passes is as good a place as any for the interrupts to land
+    loops++;
+    if (step_us) hal::advance(step_us);
+  }
+
+  // close the log like the ground station would, and give the stop command a moment
+  sendCommand(STOP_COMMAND);
+  for (uint64_t stop = hal::now() + 100000; hal::now() < stop; ) {
+    if (replaying) replayLoop();
+    else loop();
+    hal::runTimers();
+    if (step_us) hal::advance(step_us);
+  }
+  #ifdef STORAGE_THREAD
+  threads.stop();
+  #endif
+  double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall).count();
+
+  const FlushPolicy &flush = shart->getFlushStats();
+  fprintf(stderr, "%.2f s logged in %.2f s: %llu loops, %.2f us per loop\n",
+          (end - start) / 1e6, wall_s, (unsigned long long) loops, wall_s * 1e6 / loops);
+  fprintf(stderr, "gps frames %u, usb tx %llu B, sd sectors %u, ring buffer max %u B, stalls %u\n",
+          hal::ublox.getFrameCount(), (unsigned long long) USB_SERIAL_PORT.getTxCount(),
+          flush.getSectorCount(), (unsigned) flush.getMaxUsed(), flush.getStallCount());
+  if (replaying) {
+    fprintf(stderr, "replayed %u packets, skipped %u bytes\n", log.getPacketCount(), log.getSkippedBytes());
+  }
+
+  if (!hal::SdCard::instance().save(out_dir)) {
+    fprintf(stderr, "couldn't save the SD card to %s\n", out_dir);
+    return 1;
+  }
+  if (usb) fclose(usb);
+  return 0;
+
+}
@@ -11,6 +11,44 @@
 #define LSM_MOSI 26
 
 Adafruit_LSM6DSO32 dso32;
+
+// How long a getRaw() holds up the loop at each I2C clock, against the CPU time of
+// startRaw() + finishRaw() at 1 MHz (what the shart's collect() pays with ASYNC_I2C,
+// the transfer itself runs from the LPI2C interrupt while other sensors are read)
+#define TIMING_READS 1000
+
+static float cyclesToUs(uint32_t cycles) {
+  return cycles / (F_CPU_ACTUAL / 1000000.0f) / TIMING_READS;
+}
+
+void timeReads() {
+  const uint32_t clocks[] = {100000, 400000, 1000000};
+  for (uint32_t clock : clocks) {
+    Wire.setClock(clock);
+    uint32_t start = ARM_DWT_CYCCNT;
+    for (int i = 0; i < TIMING_READS; i++)
+      dso32.getRaw();
+    Serial.printf("getRaw() at %lu Hz: %.1f us per read\n", clock,
+                  cyclesToUs(ARM_DWT_CYCCNT - start));
+  }
+
+  uint32_t cpu = 0, start = ARM_DWT_CYCCNT;
+  bool ok = true;
+  for (int i = 0; i < TIMING_READS; i++) {
+    uint32_t t = ARM_DWT_CYCCNT;
+    ok &= dso32.startRaw();
+    cpu += ARM_DWT_CYCCNT - t;
+    delayMicroseconds(300); // other work, longer than the transfer
+    t = ARM_DWT_CYCCNT;
+    ok &= dso32.finishRaw();
+    cpu += ARM_DWT_CYCCNT - t;
+  }
+  uint32_t total = ARM_DWT_CYCCNT - start;
+  Serial.printf("startRaw() + finishRaw() at 1000000 Hz: %.1f us per read of CPU "
+                "(%.1f us with the 300 us in between)%s\n",
+                cyclesToUs(cpu), cyclesToUs(total), ok ? "" : ", SOME FAILED");
+}
+
 void setup(void) {
   Serial.begin(115200);
   while (!Serial)
@@ -144,6 +182,8 @@ void setup(void) {
     Serial.println("6.66 KHz");
     break;
   }
+
+  timeReads();
 }
 
 void loop() {
@@ -11,56 +11,65 @@
 #define DATETIME_FORMAT "%04d.%02d.%02d %02d:%02d:%02d"
 #define DATETIME_LENGTH 20
 
-UbloxGps<NavPvtPacket> gps(Serial2);
+UbloxGps gps(Serial2);
+UbxGpsConfig config(gps);
 
 char datetime[DATETIME_LENGTH];
 
+// every NAV-PVT the parser finds, in its buffer
+void printNavPvt(const UbxFrame &frame, void *context)
+{
+    const NavPvtPacket *pvt = frame.as<NavPvtPacket>();
+    if (!pvt)
+    {
+        return;
+    }
+    const NavPvtPacket &packet = *pvt;
+
+    snprintf(datetime, DATETIME_LENGTH, DATETIME_FORMAT, packet.year, packet.month, packet.day, packet.hour, packet.min, packet.sec);
+    
+    Serial.print(datetime);
+    Serial.print(',');
+    Serial.print(packet.lon / 10000000.0, 7);
+    Serial.print(',');
+    Serial.print(packet.lat / 10000000.0, 7);
+    Serial.print(',');
+    Serial.print(packet.alt / 1000.0, 3);
+    Serial.print(',');
+    Serial.print(packet.velN);
+    Serial.print(',');
+    Serial.print(packet.velE);
+    Serial.print(',');
+    Serial.print(packet.velD);
+    Serial.print(',');
+    Serial.print(packet.gSpeed * 0.0036, 5);
+    Serial.print(',');
+    Serial.print(packet.heading / 100000.0, 5);
+    Serial.print(',');
+    Serial.print(packet.fixType);
+    Serial.print(',');
+    Serial.println(packet.numSV);
+}
+
 void setup()
 {
     Serial.begin(COMPUTER_BAUDRATE);
-    UbxGpsConfig<HardwareSerial, usb_serial_class> *ubxGpsConfig = new UbxGpsConfig<HardwareSerial, usb_serial_class>(Serial2, Serial);
-    ubxGpsConfig->setBaudrate(GPS_BAUDRATE);
-    ubxGpsConfig->setMessage(UbxGpsConfigMessage::NavPvt);
-    ubxGpsConfig->setRate(100);
-    ubxGpsConfig->configure();
-    //delete ubxGpsConfig;
-
-    gps.begin(GPS_BAUDRATE);
+
+    // as fast as it goes, reported once every command has been ACKed (or not)
+    const uint32_t bauds[] = {460800, 230400, 115200, 38400, GPS_BAUDRATE};
+    const uint16_t rates[] = {50, 100, 200, 1000};
+    config.setBauds(bauds, sizeof(bauds) / sizeof(*bauds));
+    config.setRates(rates, sizeof(rates) / sizeof(*rates));
+    config.start();
+    while (!config.update());
+    config.report(Serial);
+
+    gps.on(UBX_CLASS_NAV, UBX_NAV_PVT, printNavPvt);
 }
 
 void loop()
 {
     gps.update();
-    if (gps.isReady())
-    {
-        const NavPvtPacket &packet = gps.getPacket();
-    
-        
-        snprintf(datetime, DATETIME_LENGTH, DATETIME_FORMAT, packet.year, packet.month, packet.day, packet.hour, packet.min, packet.sec);
-        
-        Serial.print(datetime);
-        Serial.print(',');
-        Serial.print(packet.lon / 10000000.0, 7);
-        Serial.print(',');
-        Serial.print(packet.lat / 10000000.0, 7);
-        Serial.print(',');
-        Serial.print(packet.alt / 1000.0, 3);
-        Serial.print(',');
-        Serial.print(packet.velN);
-        Serial.print(',');
-        Serial.print(packet.velE);
-        Serial.print(',');
-        Serial.print(packet.velD);
-        Serial.print(',');
-        Serial.print(packet.gSpeed * 0.0036, 5);
-        Serial.print(',');
-        Serial.print(packet.heading / 100000.0, 5);
-        Serial.print(',');
-        Serial.print(packet.fixType);
-        Serial.print(',');
-        Serial.println(packet.numSV);
-        
-    }
 }
 
 #else
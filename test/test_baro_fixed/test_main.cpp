@@ -0,0 +1,158 @@
+// Fixed point BMP390 compensation and table altitude (util/baro_fixed.h, FIXED_BARO) against
+// the driver's double compensation (baro.h does bmp3.c's math) and readAltitude()'s pow()
+//
+// pio test -e native -f test_baro_fixed -v   (-v shows the benchmark output)
+//
+// Host times only say which is cheaper, on the Teensy DEBUG_MODE_DATARATE's "collect bmp"
+// stage has the real cost
+
+#include <stdio.h>
+#include <chrono>
+#include <unity.h>
+#include <baro.h>
+#include <shart/util/baro_fixed.h>
+
+#define CALIBRATIONS 2000
+#define SAMPLES      256
+
+struct raw_sample {
+  uint32_t raw_temp, raw_pres;
+};
+
+static uint32_t seed;
+static uint32_t next() {
+  seed = seed * 1664525 + 1013904223;
+  return seed >> 8;
+}
+
+void setUp() {
+  seed = 0x42415230;
+}
+
+void tearDown() {}
+
+// Random calibrations, like a real part's in par_p5 and par_p6, see util/baro_fixed.h
+static void randomCalibration(unsigned char nvm[BARO_CALIB_LENGTH]) {
+  for (int i = 0; i < BARO_CALIB_LENGTH; i++) nvm[i] = next();
+  nvm[12] &= 0x7F;
+  nvm[14] &= 0x7F;
+}
+
+// Random raw words, kept to those that compensate to -40..85 C and the altitude table's pressures
+static int randomSamples(const baro_calib &calib, raw_sample *samples) {
+  int n = 0;
+  for (int tries = 0; n < SAMPLES && tries < 100 * SAMPLES; tries++) {
+    raw_sample s = {next() & 0xFFFFFF, next() & 0xFFFFFF};
+    double temp, pres;
+    baroCompensate(calib, s.raw_temp, s.raw_pres, temp, pres);
+    if (temp > -40 && temp < 85 && pres > BARO_ALT_MIN_PA && pres < 120000) samples[n++] = s;
+  }
+  return n;
+}
+
+static double formulaCm(double pa) {
+  return BARO_ALT_TOP_CM * (1.0 - pow(pa / BARO_ALT_STD_PA, 0.1903));
+}
+
+// within 0.03 Pa and 0.01 C (the integer's resolution, a hair over with the double's rounding)
+// of the double compensation, over every calibration
+void test_compensation() {
+  static raw_sample samples[SAMPLES];
+  double max_pres = 0, max_temp = 0;
+  long count = 0;
+  for (int k = 0; k < CALIBRATIONS; k++) {
+    unsigned char nvm[BARO_CALIB_LENGTH];
+    randomCalibration(nvm);
+    baro_calib calib = baroCalib(nvm);
+    BaroFixed fixed;
+    fixed.setCalibration(nvm);
+
+    int n = randomSamples(calib, samples);
+    for (int i = 0; i < n; i++) {
+      double temp, pres;
+      baroCompensate(calib, samples[i].raw_temp, samples[i].raw_pres, temp, pres);
+      int32_t fixed_temp;
+      uint32_t fixed_pres;
+      fixed.compensate(samples[i].raw_temp, samples[i].raw_pres, fixed_temp, fixed_pres);
+      max_pres = fmax(max_pres, fabs(fixed_pres * 0.01 - pres));
+      max_temp = fmax(max_temp, fabs(fixed_temp * 0.01 - temp));
+    }
+    count += n;
+  }
+  TEST_ASSERT_GREATER_THAN(CALIBRATIONS * SAMPLES / 2, count);
+  TEST_ASSERT_TRUE(max_pres <= 0.03);
+  TEST_ASSERT_TRUE(max_temp <= 0.0105);
+}
+
+// Every 0.01 Pa step would take long, every 7.01 Pa walks through all parts of the table's
+// steps. 3.5 cm below 6 km, 16 cm up to the table's 13 km, with the cm the result is cut to
+void test_altitude_table() {
+  BaroAltitude altitude;
+  double max_low = 0, max_high = 0;
+  const double pa_6km = BARO_ALT_STD_PA * pow(1 - 600000.0 / BARO_ALT_TOP_CM, 1 / 0.1903);
+  for (uint32_t pres = BARO_ALT_MIN_PA * 100; pres < 120000 * 100; pres += 701) {
+    double err = fabs(altitude.altitudeCm(pres) - formulaCm(pres * 0.01));
+    if (pres * 0.01 >= pa_6km) max_low = fmax(max_low, err);
+    else max_high = fmax(max_high, err);
+  }
+  TEST_ASSERT_TRUE(max_low <= 3.5);
+  TEST_ASSERT_TRUE(max_high <= 16);
+
+  // outside the table it is clamped
+  TEST_ASSERT_EQUAL_INT32(altitude.altitudeCm(BARO_ALT_MIN_PA * 100), altitude.altitudeCm(1000 * 100));
+  TEST_ASSERT_EQUAL_INT32(altitude.altitudeCm(122880 * 100), altitude.altitudeCm(130000 * 100));
+
+  // another sea level pressure moves the whole table, like readAltitude()'s
+  altitude.setSeaLevel(102000);
+  double pa = 90000;
+  double expected = BARO_ALT_TOP_CM * (1.0 - pow(pa / 102000, 0.1903));
+  TEST_ASSERT_TRUE(fabs(altitude.altitudeCm(pa * 100) - expected) <= 3.5);
+}
+
+// ns per sample of each path, from raw words to temperature, pressure and altitude
+void test_bench_baro() {
+  static raw_sample samples[SAMPLES];
+  double double_ns = 0, fixed_ns = 0;
+  volatile double sink = 0;
+  long count = 0;
+  BaroAltitude altitude;
+  for (int k = 0; k < CALIBRATIONS; k++) {
+    unsigned char nvm[BARO_CALIB_LENGTH];
+    randomCalibration(nvm);
+    baro_calib calib = baroCalib(nvm);
+    BaroFixed fixed;
+    fixed.setCalibration(nvm);
+    int n = randomSamples(calib, samples);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) {
+      double temp, pres;
+      baroCompensate(calib, samples[i].raw_temp, samples[i].raw_pres, temp, pres);
+      sink = sink + temp + 44330.0 * (1.0 - pow(pres / BARO_ALT_STD_PA, 0.1903));
+    }
+    auto mid = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) {
+      int32_t temp;
+      uint32_t pres;
+      fixed.compensate(samples[i].raw_temp, samples[i].raw_pres, temp, pres);
+      sink = sink + temp + altitude.altitudeCm(pres);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double_ns += std::chrono::duration<double, std::nano>(mid - start).count();
+    fixed_ns  += std::chrono::duration<double, std::nano>(end - mid).count();
+    count += n;
+  }
+
+  char line[160];
+  snprintf(line, sizeof(line), "%ld samples over %d calibrations: double + pow() %.1f ns, fixed + table %.1f ns per sample",
+           count, CALIBRATIONS, double_ns / count, fixed_ns / count);
+  TEST_MESSAGE(line);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_compensation);
+  RUN_TEST(test_altitude_table);
+  RUN_TEST(test_bench_baro);
+  return UNITY_END();
+}
@@ -0,0 +1,223 @@
+// Batch packets (comms.h) and the batch ring (util/batch_buffer.h)
+//
+// pio test -e native -f test_batch -v   (-v shows the benchmark output)
+
+#include <stdio.h>
+#include <chrono>
+#include <unity.h>
+#include <comms.h>
+#include <shart/util/batch_buffer.h>
+
+void setUp() {}
+void tearDown() {}
+
+static imu_sample imuSample(int i) {
+  imu_sample s = {};
+  s.acc_x = i;
+  s.acc_y = -i;
+  s.acc_z = 2048 + i;
+  s.gyr_x = 3 * i;
+  s.gyr_y = -3 * i;
+  s.gyr_z = i ^ 0x55;
+  return s;
+}
+
+// encode, checksum, decode from the bytes and get the same samples and times back
+void test_round_trip() {
+  imu_batch_p batch;
+  uint64_t t0 = 0x12'3456'7890ull;
+  for (int i = 0; i < BATCH_MAX_SAMPLES; i++) TEST_ASSERT_TRUE(batchAdd(batch, t0 + 1201ull * i + (i & 3), imuSample(i)));
+  TEST_ASSERT_FALSE(batchAdd(batch, t0 + 1201ull * BATCH_MAX_SAMPLES, imuSample(0)));
+  BATCH_CHECKSUM(batch)
+
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&batch);
+  size_t len = batchLength(batch);
+  TEST_ASSERT_EQUAL(len, packetLength(bytes, len));
+
+  imu_batch_p decoded;
+  TEST_ASSERT_EQUAL(len, batchDecode(bytes, len, decoded));
+  TEST_ASSERT_EQUAL(BATCH_MAX_SAMPLES, decoded.data.count);
+  for (int i = 0; i < BATCH_MAX_SAMPLES; i++) {
+    imu_sample e = imuSample(i);
+    TEST_ASSERT_EQUAL_UINT64(t0 + 1201ull * i + (i & 3), batchSampleTime(decoded, i));
+    TEST_ASSERT_EQUAL_MEMORY(&e.acc_x, &decoded.data.samples[i].acc_x, sizeof(e) - sizeof(e.dt));
+  }
+}
+
+// every other batch type, partly filled, so only count samples go on the wire
+void test_round_trip_types() {
+  highg_batch_p highg;
+  baro_batch_p  baro;
+  icm_batch_p   icm;
+  for (int i = 0; i < 5; i++) {
+    highg_sample h = {0, (int16_t) i, (int16_t) -i, (int16_t) (100 + i)};
+    baro_sample  b = {};
+    float pres = 101325.0f - i;
+    memcpy(b.pres, &pres, sizeof(pres));
+    icm_sample   c = {0, (unsigned char) (i % 3), 0, {(int16_t) i, 1, 2, 3}};
+    TEST_ASSERT_TRUE(batchAdd(highg, 1000 + 312 * i, h));
+    TEST_ASSERT_TRUE(batchAdd(baro, 1000 + 5000 * i, b));
+    TEST_ASSERT_TRUE(batchAdd(icm, 1000 + 4444 * (i / 3), c)); // several outputs can share a time
+  }
+  BATCH_CHECKSUM(highg)
+  BATCH_CHECKSUM(baro)
+  BATCH_CHECKSUM(icm)
+
+  highg_batch_p highg_out;
+  baro_batch_p  baro_out;
+  icm_batch_p   icm_out;
+  TEST_ASSERT_EQUAL(batchHeaderLength(highg) + 5 * sizeof(highg_sample), batchLength(highg));
+  TEST_ASSERT_EQUAL(batchLength(highg), batchDecode((const unsigned char *) &highg, batchLength(highg), highg_out));
+  TEST_ASSERT_EQUAL(batchLength(baro), batchDecode((const unsigned char *) &baro, batchLength(baro), baro_out));
+  TEST_ASSERT_EQUAL(batchLength(icm), batchDecode((const unsigned char *) &icm, batchLength(icm), icm_out));
+  TEST_ASSERT_EQUAL_MEMORY(highg.data.samples, highg_out.data.samples, 5 * sizeof(highg_sample));
+  TEST_ASSERT_EQUAL_MEMORY(baro.data.samples, baro_out.data.samples, 5 * sizeof(baro_sample));
+  TEST_ASSERT_EQUAL_MEMORY(icm.data.samples, icm_out.data.samples, 5 * sizeof(icm_sample));
+  TEST_ASSERT_EQUAL_UINT64(1000 + 4444, batchSampleTime(icm_out, 4));
+
+  // a batch doesn't decode as another type
+  TEST_ASSERT_EQUAL(0, batchDecode((const unsigned char *) &highg, batchLength(highg), icm_out));
+}
+
+// truncated or corrupted bytes never decode
+void test_decode_rejects() {
+  imu_batch_p batch;
+  for (int i = 0; i < 10; i++) batchAdd(batch, 500 * i, imuSample(i));
+  BATCH_CHECKSUM(batch)
+  unsigned char bytes[sizeof(imu_batch_p)];
+  size_t len = batchLength(batch);
+  memcpy(bytes, &batch, len);
+
+  imu_batch_p out;
+  TEST_ASSERT_EQUAL(0, batchDecode(bytes, len - 1, out));
+  for (size_t i = HEADER_LENGTH; i < len; i++) {
+    bytes[i] ^= 0x10;
+    TEST_ASSERT_EQUAL(0, batchDecode(bytes, len, out));
+    bytes[i] ^= 0x10;
+  }
+  bytes[batchHeaderLength(batch) - 2] = BATCH_MAX_SAMPLES + 1;
+  TEST_ASSERT_EQUAL(0, batchDecode(bytes, sizeof(bytes), out));
+}
+
+// a sample more than 65535 us after the previous one starts a new batch
+void test_time_gap_splits() {
+  imu_batch_p batch;
+  TEST_ASSERT_TRUE(batchAdd(batch, 0, imuSample(0)));
+  TEST_ASSERT_TRUE(batchAdd(batch, 0xFFFF, imuSample(1)));
+  TEST_ASSERT_FALSE(batchAdd(batch, 2 * 0xFFFF + 1, imuSample(2)));
+}
+
+// Feed samples like a FIFO drain does and collect every batch send() would get
+static unsigned int drain(BatchBuffer<imu_batch_p> &buffer, uint64_t &next_us, int &next_i) {
+  unsigned int out = 0;
+  while (imu_batch_p *full = buffer.takeFull()) {
+    for (unsigned int j = 0; j < full->data.count; j++) {
+      TEST_ASSERT_EQUAL(next_i, full->data.samples[j].acc_x);
+      TEST_ASSERT_EQUAL_UINT64(next_us, batchSampleTime(*full, j));
+      next_i++;
+      next_us += 1200;
+    }
+    out += full->data.count;
+  }
+  return out;
+}
+
+// the largest burst room() allows goes through in order without a single drop
+void test_ring_burst() {
+  BatchBuffer<imu_batch_p> buffer;
+  TEST_ASSERT_EQUAL((BATCH_RING_SIZE - 1) * BATCH_MAX_SAMPLES, buffer.room());
+
+  unsigned int burst = buffer.room();
+  for (unsigned int i = 0; i < burst; i++) buffer.add(1200ull * i, imuSample(i));
+  TEST_ASSERT_EQUAL_UINT32(0, buffer.getDropCount());
+
+  // the last batch is still the active one
+  uint64_t next_us = 0;
+  int next_i = 0;
+  TEST_ASSERT_EQUAL(burst - BATCH_MAX_SAMPLES, drain(buffer, next_us, next_i));
+  TEST_ASSERT_NULL(buffer.takeFull());
+}
+
+// bursts with a send() in between never lose anything
+void test_ring_drained() {
+  BatchBuffer<imu_batch_p> buffer;
+  uint64_t next_us = 0;
+  int next_i = 0;
+  int n = 0;
+  unsigned int out = 0;
+  for (int loop = 0; loop < 50; loop++) {
+    unsigned int burst = loop % 2 ? buffer.room() : 7;
+    for (unsigned int i = 0; i < burst; i++, n++) buffer.add(1200ull * n, imuSample(n));
+    out += drain(buffer, next_us, next_i);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, buffer.getDropCount());
+  // all but the active batch came out
+  TEST_ASSERT_LESS_THAN(BATCH_MAX_SAMPLES + 1, n - out);
+  TEST_ASSERT_GREATER_THAN(0, n - out);
+}
+
+// with every buffer waiting, a full active batch is dropped and counted, the waiting
+// ones are untouched
+void test_ring_overrun() {
+  BatchBuffer<imu_batch_p> buffer;
+  int n = 0;
+  unsigned int total = (BATCH_RING_SIZE + 2) * BATCH_MAX_SAMPLES;
+  for (unsigned int i = 0; i < total; i++, n++) buffer.add(1200ull * n, imuSample(n));
+
+  // 8 full batches are waiting, the last 3 batches worth went through the active one
+  TEST_ASSERT_EQUAL_UINT32(2 * BATCH_MAX_SAMPLES, buffer.getDropCount());
+
+  uint64_t next_us = 0;
+  int next_i = 0;
+  TEST_ASSERT_EQUAL((BATCH_RING_SIZE - 1) * BATCH_MAX_SAMPLES, drain(buffer, next_us, next_i));
+  TEST_ASSERT_EQUAL((BATCH_RING_SIZE - 1) * BATCH_MAX_SAMPLES, buffer.room());
+}
+
+// Per sample cost of logging an IMU sample on its own in a sensor packet versus in a batch:
+// bytes on the wire and time to build and checksum
+void test_bench_batch() {
+
+  const int samples = 1 << 20;
+  volatile uint16_t sink = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  sensor_p single;
+  for (int i = 0; i < samples; i++) {
+    single.data.us = i;
+    single.data.acc_x = i;
+    CHECKSUM(single)
+    sink = sink + single.crc_16_ccitt_false;
+  }
+  double single_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / samples;
+
+  start = std::chrono::steady_clock::now();
+  imu_batch_p batch;
+  for (int i = 0; i < samples; i++) {
+    if (batchAdd(batch, 1200ull * i, imuSample(i))) continue;
+    BATCH_CHECKSUM(batch)
+    sink = sink + batch.crc_16_ccitt_false;
+    batchReset(batch);
+    batchAdd(batch, 1200ull * i, imuSample(i));
+  }
+  double batch_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / samples;
+
+  double batch_bytes = (double) batchLength(batch) / BATCH_MAX_SAMPLES;
+  char line[160];
+  snprintf(line, sizeof(line), "sensor packet per sample: %u bytes %.1f ns, %d sample batch: %.1f bytes %.1f ns",
+           (unsigned) sizeof(sensor_p), single_ns, BATCH_MAX_SAMPLES, batch_bytes, batch_ns);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_LESS_THAN(sizeof(sensor_p), batch_bytes);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_round_trip_types);
+  RUN_TEST(test_decode_rejects);
+  RUN_TEST(test_time_gap_splits);
+  RUN_TEST(test_ring_burst);
+  RUN_TEST(test_ring_drained);
+  RUN_TEST(test_ring_overrun);
+  RUN_TEST(test_bench_batch);
+  return UNITY_END();
+}
@@ -0,0 +1,112 @@
+// Slice-by-8 CRC-16 (crc16.h in comms) against a bitwise reference
+//
+// pio test -e native -f test_crc -v   (-v shows the benchmark output)
+
+#include <stdio.h>
+#include <chrono>
+#include <unity.h>
+#include <crc16.h>
+
+void setUp() {}
+void tearDown() {}
+
+// CRC-16/CCITT-FALSE straight from the definition, one bit at a time
+static uint16_t crcBitwise(uint16_t crc, const unsigned char *data, size_t len) {
+  while (len--) {
+    crc ^= (uint16_t) *data++ << 8;
+    for (int bit = 0; bit < 8; bit++) crc = (crc & 0x8000) ? (crc << 1) ^ CRC16_POLY : crc << 1;
+  }
+  return crc;
+}
+
+// what CHECKSUM used to do, one table lookup per byte
+static uint16_t crcBytewise(uint16_t crc, const unsigned char *data, size_t len) {
+  const uint16_t *t = crc16_engine<>::tables.table[0];
+  while (len--) crc = (crc << 8) ^ t[(crc >> 8) ^ *data++];
+  return crc;
+}
+
+static uint32_t rng = 0x6D656F77;
+static unsigned char randomByte() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+// the catalogue check value
+void test_check_value() {
+  TEST_ASSERT_EQUAL_HEX16(0x29B1, crc16("123456789", 9));
+  TEST_ASSERT_EQUAL_HEX16(CRC16_INIT, crc16("", 0));
+}
+
+// every length around the 8 byte slices, at every alignment
+void test_matches_bitwise() {
+  unsigned char buf[600];
+  for (size_t i = 0; i < sizeof(buf); i++) buf[i] = randomByte();
+  for (size_t offset = 0; offset < 8; offset++) {
+    for (size_t len = 0; len + offset <= sizeof(buf); len++) {
+      TEST_ASSERT_EQUAL_HEX16(crcBitwise(CRC16_INIT, buf + offset, len), crc16(buf + offset, len));
+    }
+  }
+}
+
+// crc16_update over any split is the crc of the whole
+void test_incremental() {
+  unsigned char buf[256];
+  for (size_t i = 0; i < sizeof(buf); i++) buf[i] = randomByte();
+  uint16_t whole = crc16(buf, sizeof(buf));
+  for (size_t split = 0; split <= sizeof(buf); split++) {
+    TEST_ASSERT_EQUAL_HEX16(whole, crc16_update(crc16_update(CRC16_INIT, buf, split), buf + split, sizeof(buf) - split));
+  }
+  uint16_t crc = CRC16_INIT;
+  for (size_t i = 0; i < sizeof(buf); i++) crc = crc16_update(crc, buf + i, 1);
+  TEST_ASSERT_EQUAL_HEX16(whole, crc);
+}
+
+// random buffers from every start value, against both references
+void test_random_buffers() {
+  unsigned char buf[128];
+  for (int run = 0; run < 20000; run++) {
+    size_t len = randomByte() % sizeof(buf);
+    uint16_t start = randomByte() << 8 | randomByte();
+    for (size_t i = 0; i < len; i++) buf[i] = randomByte();
+    uint16_t expected = crcBitwise(start, buf, len);
+    TEST_ASSERT_EQUAL_HEX16(expected, crcBytewise(start, buf, len));
+    TEST_ASSERT_EQUAL_HEX16(expected, crc16_update(start, buf, len));
+  }
+}
+
+template <typename Crc>
+static double nsPerByte(Crc crc, const unsigned char *data, size_t len) {
+  volatile uint16_t sink = 0;
+  size_t runs = (64 << 20) / len;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < runs; i++) sink = sink + crc(CRC16_INIT, data, len);
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (runs * len);
+}
+
+// ns per byte for the packet sizes we checksum, and a big buffer
+void test_bench_crc() {
+  static unsigned char buf[64 << 10];
+  for (size_t i = 0; i < sizeof(buf); i++) buf[i] = randomByte();
+  const size_t sizes[] = {56, 60, 454, sizeof(buf)};
+  for (size_t len : sizes) {
+    double bytewise = nsPerByte(crcBytewise, buf, len);
+    double sliced   = nsPerByte(crc16_update, buf, len);
+    char line[128];
+    snprintf(line, sizeof(line), "%6u B: byte-at-a-time %.2f ns/B, slice-by-8 %.2f ns/B",
+             (unsigned) len, bytewise, sliced);
+    TEST_MESSAGE(line);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_check_value);
+  RUN_TEST(test_matches_bitwise);
+  RUN_TEST(test_incremental);
+  RUN_TEST(test_random_buffers);
+  RUN_TEST(test_bench_crc);
+  return UNITY_END();
+}
@@ -0,0 +1,258 @@
+// Delta compression of the log stream (delta.h in comms)
+//
+// pio test -e native -f test_delta -v   (-v shows the benchmark output)
+//
+// The benchmark runs on a synthetic 10 minute log. To run it on a recorded one as well,
+// point DELTA_LOG at a dataN.poop written without COMPRESS_LOG
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include <unity.h>
+#include <comms.h>
+#include <delta.h>
+
+typedef std::vector<unsigned char> bytes_t;
+
+void setUp() {}
+void tearDown() {}
+
+// small xorshift so the logs are the same every run
+static uint32_t rng = 0x6D656F77;
+static int32_t noise(int32_t amplitude) {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return (int32_t) (rng % (2 * amplitude + 1)) - amplitude;
+}
+
+static void append(bytes_t &log, const void *p, size_t len) {
+  const unsigned char *b = (const unsigned char *) p;
+  log.insert(log.end(), b, b + len);
+}
+
+// Sensor packets at 208 Hz with a few LSBs of noise, gps at 5 Hz, an imu batch every 32
+// sensor packets. Plain packets, like a log written without COMPRESS_LOG
+static bytes_t syntheticLog(uint32_t seconds) {
+  bytes_t log;
+  sensor_p s;
+  gps_p    g;
+  imu_batch_p batch;
+  g.data.lat = 325000000;
+  g.data.lon = -1170000000;
+  g.data.nsats = 12;
+  g.data.fix_type = 3;
+  for (uint32_t i = 0; i < seconds * 208; i++) {
+    uint64_t us = 1000000ull + i * 4808ull;
+    s.data.us = us;
+    s.data.us_hi = us >> 32;
+    s.data.acc_x = noise(4);
+    s.data.acc_y = noise(4);
+    s.data.acc_z = 2048 + noise(4);
+    s.data.gyr_x = noise(8);
+    s.data.gyr_y = noise(8);
+    s.data.gyr_z = noise(8);
+    s.data.mag_x = 20.5f + noise(3) * 0.15f;
+    s.data.mag_y = -4.0f + noise(3) * 0.15f;
+    s.data.mag_z = 41.0f + noise(3) * 0.15f;
+    s.data.temp = 24.0f + noise(2) * 0.01f;
+    s.data.pres = 101325.0f + noise(20) * 0.1f;
+    s.data.adxl_acc_x = noise(2);
+    s.data.adxl_acc_y = noise(2);
+    s.data.adxl_acc_z = 20 + noise(2);
+    s.data.lsm_age = 200 + noise(100);
+    s.data.bmp_age = 2000 + noise(1000);
+    s.data.status = 0x0F;
+    CHECKSUM(s)
+    append(log, &s, sizeof(s));
+
+    if (batchAdd(batch, us, imu_sample{0, s.data.acc_x, s.data.acc_y, s.data.acc_z, s.data.gyr_x, s.data.gyr_y, s.data.gyr_z}) == false) {
+      BATCH_CHECKSUM(batch)
+      append(log, &batch, batchLength(batch));
+      batchReset(batch);
+      batchAdd(batch, us, imu_sample{});
+    }
+
+    if (i % 42 == 0) {
+      g.data.us = us;
+      g.data.lat += noise(30);
+      g.data.lon += noise(30);
+      g.data.alt = 100000 + noise(500);
+      g.data.veln = noise(50);
+      g.data.vele = noise(50);
+      g.data.veld = noise(50);
+      g.data.eph = 1500 + noise(100);
+      g.data.epv = 2500 + noise(100);
+      g.data.pdop = 1.2f;
+      CHECKSUM(g)
+      append(log, &g, sizeof(g));
+    }
+  }
+  return log;
+}
+
+// every packet of a plain log through the encoder, like logPacket() does
+static bytes_t encodeLog(const bytes_t &log, size_t *packets = nullptr) {
+  DeltaEncoder encoder;
+  bytes_t out;
+  out.reserve(log.size());
+  unsigned char frame[DELTA_MAX_PACKET];
+  size_t n = 0;
+  for (size_t pos = 0; pos < log.size();) {
+    size_t len = packetLength(&log[pos], log.size() - pos);
+    if (len == 0 || pos + len > log.size()) { pos++; continue; }
+    if (len <= DELTA_MAX_PACKET) append(out, frame, encoder.encode(&log[pos], len, frame));
+    else append(out, &log[pos], len);
+    pos += len;
+    n++;
+  }
+  if (packets) *packets = n;
+  return out;
+}
+
+// decode a compressed log back to plain packets, skipping bytes it can't make sense of
+static bytes_t decodeLog(const bytes_t &log, size_t *packets = nullptr) {
+  DeltaDecoder decoder;
+  bytes_t out;
+  out.reserve(2 * log.size());
+  unsigned char packet[1024]; // the biggest plain packet, a profile packet
+  size_t n = 0;
+  for (size_t pos = 0; pos < log.size();) {
+    size_t len;
+    size_t used = decoder.decode(&log[pos], log.size() - pos, packet, len);
+    if (used == 0) { pos++; continue; }
+    append(out, packet, len);
+    if (len) n++;
+    pos += used;
+  }
+  if (packets) *packets = n;
+  return out;
+}
+
+// compressed and back is byte for byte the log we started with
+void test_round_trip() {
+  bytes_t log = syntheticLog(20);
+  bytes_t compressed = encodeLog(log);
+  TEST_ASSERT_LESS_THAN(log.size(), compressed.size());
+  bytes_t decoded = decodeLog(compressed);
+  TEST_ASSERT_EQUAL(log.size(), decoded.size());
+  TEST_ASSERT_EQUAL_MEMORY(log.data(), decoded.data(), log.size());
+}
+
+// the first packet of a type and every DELTA_KEYFRAME_INTERVAL'th after it is plain
+void test_keyframes() {
+  DeltaEncoder encoder;
+  unsigned char frame[DELTA_MAX_PACKET];
+  sensor_p s;
+  for (int i = 0; i < 3 * (DELTA_KEYFRAME_INTERVAL + 1); i++) {
+    s.data.us = 4808 * i;
+    CHECKSUM(s)
+    size_t n = encoder.encode(s, frame);
+    if (i % (DELTA_KEYFRAME_INTERVAL + 1) == 0) {
+      TEST_ASSERT_EQUAL(sizeof(sensor_p), n);
+      TEST_ASSERT_EQUAL_MEMORY(&s, frame, n);
+    } else {
+      TEST_ASSERT_EQUAL_UINT8(TYPE_DELTA, frame[1]);
+      TEST_ASSERT_LESS_THAN(sizeof(sensor_p), n);
+    }
+  }
+}
+
+// fields that change by the most they can still round trip
+void test_extreme_deltas() {
+  DeltaEncoder encoder;
+  DeltaDecoder decoder;
+  unsigned char frame[DELTA_MAX_PACKET], out[DELTA_MAX_PACKET];
+  sensor_p s;
+  for (int i = 0; i < 8; i++) {
+    s.data.us = i & 1 ? 0xFFFFFFFF : 0;
+    s.data.acc_x = i & 1 ? INT16_MIN : INT16_MAX;
+    s.data.mag_x = i & 1 ? -1e30f : 1e-30f;
+    s.data.status = i & 1 ? 0xFF : 0;
+    CHECKSUM(s)
+    size_t n = encoder.encode(s, frame), len;
+    TEST_ASSERT_EQUAL(n, decoder.decode(frame, n, out, len));
+    TEST_ASSERT_EQUAL(sizeof(sensor_p), len);
+    TEST_ASSERT_EQUAL_MEMORY(&s, out, len);
+  }
+}
+
+// a damaged frame costs the packets up to the next keyframe, never a wrong packet
+void test_corruption() {
+  bytes_t log = syntheticLog(10);
+  size_t packets;
+  bytes_t compressed = encodeLog(log, &packets);
+  compressed[compressed.size() / 3] ^= 0x04;
+  compressed[2 * compressed.size() / 3] ^= 0x40;
+
+  size_t recovered;
+  bytes_t decoded = decodeLog(compressed, &recovered);
+  TEST_ASSERT_LESS_THAN(packets, recovered);
+  TEST_ASSERT_GREATER_THAN(packets - 4 * DELTA_KEYFRAME_INTERVAL, recovered);
+
+  // everything that came out is a packet of the original log
+  for (size_t pos = 0; pos < decoded.size();) {
+    size_t len = packetLength(&decoded[pos], decoded.size() - pos);
+    TEST_ASSERT_GREATER_THAN(0, len);
+    uint16_t crc = decoded[pos + 2] | (decoded[pos + 3] << 8);
+    TEST_ASSERT_EQUAL_HEX16(crc16(&decoded[pos + HEADER_LENGTH], len - HEADER_LENGTH), crc);
+    pos += len;
+  }
+}
+
+static void bench(const char *name, const bytes_t &log) {
+  auto start = std::chrono::steady_clock::now();
+  bytes_t compressed = encodeLog(log);
+  double encode_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  start = std::chrono::steady_clock::now();
+  bytes_t decoded = decodeLog(compressed);
+  double decode_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  char line[200];
+  snprintf(line, sizeof(line), "%s: %.2f MB -> %.2f MB, ratio %.2f, encode %.0f MB/s, decode %.0f MB/s",
+           name, log.size() / 1e6, compressed.size() / 1e6, (double) log.size() / compressed.size(),
+           log.size() / 1e6 / encode_s, log.size() / 1e6 / decode_s);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_EQUAL(log.size(), decoded.size());
+  TEST_ASSERT_EQUAL_MEMORY(log.data(), decoded.data(), log.size());
+}
+
+void test_bench_synthetic() {
+  bench("synthetic 10 min", syntheticLog(600));
+}
+
+void test_bench_recorded() {
+  const char *path = getenv("DELTA_LOG");
+  if (!path) TEST_IGNORE_MESSAGE("set DELTA_LOG to a recorded dataN.poop");
+  FILE *f = fopen(path, "rb");
+  TEST_ASSERT_NOT_NULL(f);
+  bytes_t log;
+  unsigned char buf[4096];
+  while (size_t n = fread(buf, 1, sizeof(buf), f)) append(log, buf, n);
+  fclose(f);
+
+  // only the packets, a log ends in unwritten space
+  bytes_t packets;
+  for (size_t pos = 0; pos < log.size();) {
+    size_t len = packetLength(&log[pos], log.size() - pos);
+    if (len == 0 || pos + len > log.size() || crc16(&log[pos + HEADER_LENGTH], len - HEADER_LENGTH) != (log[pos + 2] | (log[pos + 3] << 8))) {
+      pos++;
+      continue;
+    }
+    append(packets, &log[pos], len);
+    pos += len;
+  }
+  bench(path, packets);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_keyframes);
+  RUN_TEST(test_extreme_deltas);
+  RUN_TEST(test_corruption);
+  RUN_TEST(test_bench_synthetic);
+  RUN_TEST(test_bench_recorded);
+  return UNITY_END();
+}
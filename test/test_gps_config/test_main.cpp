@@ -0,0 +1,103 @@
+// UbxGpsConfig, initGTU7()'s configuration, against scripted receivers (UbloxModel in
+// lib/native) in every state we can think of, on the stepped clock
+//
+// pio test -e native -f test_gps_config -v   (-v shows what each receiver ended up at)
+
+#include <string>
+#include <unity.h>
+#include <shart.h>
+#include <native_hal.h>
+#include <native_models.h>
+
+// UbxGpsConfig::report() into a string for TEST_MESSAGE
+struct StringPrint : public Print {
+  std::string text;
+  size_t write(uint8_t b) override {
+    if (b != '\n' && b != '\r') text += (char) b;
+    return 1;
+  }
+};
+
+void setUp() {
+  hal::setClockMode(hal::STEPPED);
+  hal::attachSerial(GPS_SERIAL_PORT, &hal::ublox);
+  hal::ublox.reset();
+  while (GPS_SERIAL_PORT.read() >= 0) {} // whatever the last one left
+}
+
+void tearDown() {}
+
+// configure the receiver like initGTU7() does and check what it ends up at
+static void configure(UbxGpsConfig::Result result, uint32_t baud, uint16_t rate_ms) {
+  static const uint32_t bauds[] = {GPS_BAUD_RATES};
+  static const uint16_t rates[] = {GPS_RATES_MS};
+  UbloxGps     gps(GPS_SERIAL_PORT);
+  UbxGpsConfig config(gps);
+  config.setBauds(bauds, sizeof(bauds) / sizeof(*bauds));
+  config.setRates(rates, sizeof(rates) / sizeof(*rates));
+  config.start();
+  for (uint64_t give_up = hal::now() + 30000000; !config.update() && hal::now() < give_up; ) hal::advance(100);
+
+  StringPrint out;
+  config.report(out);
+  TEST_MESSAGE(out.text.c_str());
+  TEST_ASSERT_EQUAL(result, config.getResult());
+  TEST_ASSERT_EQUAL_UINT32(baud, config.getBaud());
+  TEST_ASSERT_EQUAL_UINT16(rate_ms, config.getRateMs());
+}
+
+void test_factory() {
+  configure(UbxGpsConfig::OK, 460800, 100);
+}
+
+void test_left_configured() {
+  hal::ublox.baud = 460800;
+  hal::ublox.nmea = false;
+  hal::ublox.pvt_on = true;
+  hal::ublox.period_us = 100000;
+  configure(UbxGpsConfig::OK, 460800, 100);
+}
+
+void test_garbled_over_115200() {
+  hal::ublox.link_max_baud = 115200;
+  configure(UbxGpsConfig::OK, 115200, 100);
+}
+
+void test_naks_over_38400() {
+  hal::ublox.max_baud = 38400;
+  configure(UbxGpsConfig::OK, 38400, 100);
+}
+
+// 10 Hz of NAV-PVT doesn't fit in 9600 baud
+void test_9600_only() {
+  hal::ublox.max_baud = 9600;
+  configure(UbxGpsConfig::OK, 9600, 200);
+}
+
+void test_5hz_at_most() {
+  hal::ublox.min_period_ms = 200;
+  configure(UbxGpsConfig::OK, 460800, 200);
+}
+
+void test_acks_lost() {
+  hal::ublox.drop_acks = 2;
+  configure(UbxGpsConfig::OK, 460800, 100);
+}
+
+void test_no_receiver() {
+  hal::ublox.present = false;
+  configure(UbxGpsConfig::NO_RECEIVER, 0, 0);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_factory);
+  RUN_TEST(test_left_configured);
+  RUN_TEST(test_garbled_over_115200);
+  RUN_TEST(test_naks_over_38400);
+  RUN_TEST(test_9600_only);
+  RUN_TEST(test_5hz_at_most);
+  RUN_TEST(test_acks_lost);
+  RUN_TEST(test_no_receiver);
+  return UNITY_END();
+}
@@ -0,0 +1,129 @@
+// SensorHealth unit tests, and the bus transaction benchmark behind the table in the
+// shart README
+//
+// pio test -e native -f test_health -v   (-v shows the benchmark output)
+
+#include <stdio.h>
+#include <unity.h>
+#include <shart.h>
+#include <shart/util/health.h>
+#include <shart/util/scheduler.h>
+
+#define BENCH_SECONDS 10
+#define BENCH_LOOP_US 50
+
+static SensorHealth health;
+
+void setUp() {
+  health = SensorHealth();
+  health.setProbeInterval(HEALTH_PROBE_INTERVAL_US);
+}
+
+void tearDown() {}
+
+// a new sensor gets probed once before it is trusted, then only on the budget
+void test_probe_budget() {
+  TEST_ASSERT_TRUE(health.probeDue(0));
+  health.reportProbe(0);
+
+  uint32_t sample = 0;
+  for (uint32_t now = 0; now < HEALTH_PROBE_INTERVAL_US; now += 1000) {
+    sample++;
+    health.reportRead(true, &sample, sizeof(sample));
+    TEST_ASSERT_FALSE(health.probeDue(now));
+  }
+  TEST_ASSERT_TRUE(health.probeDue(HEALTH_PROBE_INTERVAL_US));
+}
+
+// a bus error or a nonsense value asks for a probe right away
+void test_error_probes() {
+  health.reportProbe(0);
+
+  health.reportRead(false, nullptr, 0);
+  TEST_ASSERT_TRUE(health.probeDue(1));
+  health.reportProbe(1);
+  TEST_ASSERT_FALSE(health.probeDue(2));
+
+  health.reportInvalid();
+  TEST_ASSERT_TRUE(health.probeDue(3));
+  TEST_ASSERT_EQUAL_UINT32(2, health.getErrorCount());
+}
+
+// HEALTH_STUCK_LIMIT identical samples in a row make the sensor suspect
+void test_stuck_sample() {
+  health.reportProbe(0);
+
+  uint8_t dead[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  // the first read is the reference the repeats are counted against
+  for (int i = 0; i <= HEALTH_STUCK_LIMIT; i++) {
+    TEST_ASSERT_FALSE(health.probeDue(1));
+    health.reportRead(true, dead, sizeof(dead));
+  }
+  TEST_ASSERT_TRUE(health.probeDue(1));
+  TEST_ASSERT_EQUAL_UINT32(1, health.getStuckCount());
+
+  // a changing sample never does
+  health.reportProbe(1);
+  for (uint32_t i = 0; i < 10 * HEALTH_STUCK_LIMIT; i++) health.reportRead(true, &i, sizeof(i));
+  TEST_ASSERT_FALSE(health.probeDue(2));
+}
+
+// Every sensor on its period at the configured ODRs for BENCH_SECONDS, once probing the
+// chip ID before every read and once with the health monitor. Returns transactions/s
+static uint32_t benchTransactions(bool monitor) {
+
+  const uint32_t periods[NUM_SENSOR_SLOTS] = {LSM_PERIOD_US, ADXL_PERIOD_US, BMP_PERIOD_US, ICM_PERIOD_US};
+
+  SampleScheduler<NUM_SENSOR_SLOTS> scheduler;
+  SensorHealth monitors[NUM_SENSOR_SLOTS];
+  for (int i = 0; i < NUM_SENSOR_SLOTS; i++) {
+    scheduler.setPeriod(i, periods[i], 0);
+    monitors[i].setProbeInterval(HEALTH_PROBE_INTERVAL_US);
+  }
+
+  uint32_t transactions = 0;
+  for (uint32_t now = 0; now < BENCH_SECONDS * 1000000u; now += BENCH_LOOP_US) {
+    for (int i = 0; i < NUM_SENSOR_SLOTS; i++) {
+      if (!scheduler.due(i, now)) continue;
+      if (monitor) {
+        if (monitors[i].probeDue(now)) {
+          transactions++;
+          monitors[i].reportProbe(now);
+        }
+      } else {
+        transactions++;
+      }
+      transactions++;
+      monitors[i].reportRead(true, &now, sizeof(now));
+    }
+  }
+
+  return transactions / BENCH_SECONDS;
+}
+
+void test_bench_transactions() {
+
+  uint32_t every_read = benchTransactions(false);
+  uint32_t monitored  = benchTransactions(true);
+
+  char line[128];
+  snprintf(line, sizeof(line), "probe before every read: %u/s, health monitor: %u/s",
+           (unsigned) every_read, (unsigned) monitored);
+  TEST_MESSAGE(line);
+
+  // one read per sample plus one probe per sensor per budget
+  uint32_t samples = every_read / 2;
+  TEST_ASSERT_UINT32_WITHIN(NUM_SENSOR_SLOTS,
+                            samples + NUM_SENSOR_SLOTS * (1000000 / HEALTH_PROBE_INTERVAL_US),
+                            monitored);
+  TEST_ASSERT_LESS_THAN(every_read, monitored);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_probe_budget);
+  RUN_TEST(test_error_probes);
+  RUN_TEST(test_stuck_sample);
+  RUN_TEST(test_bench_transactions);
+  return UNITY_END();
+}
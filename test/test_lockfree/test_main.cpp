@@ -0,0 +1,242 @@
+// Lock-free queues (lockfree.h) under real threads: nothing lost, duplicated or reordered
+//
+// pio test -e native -f test_lockfree -v   (-v shows the benchmark output)
+
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <unity.h>
+#include <lockfree.h>
+
+#define ITEMS     200000 // per producer
+#define PRODUCERS 4
+
+void setUp() {}
+void tearDown() {}
+
+// who pushed it and its number in that producer's sequence
+struct item_t {
+  uint32_t producer;
+  uint32_t seq;
+};
+
+// one producer, one consumer, every item comes out once and in order
+void test_spsc_order() {
+  static SpscQueue<item_t, 64> q;
+  uint32_t full = 0;
+  std::thread producer([&]() {
+    for (uint32_t i = 0; i < ITEMS; i++) {
+      while (!q.push(item_t{0, i})) {
+        full++;
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  item_t item;
+  for (uint32_t expected = 0; expected < ITEMS;) {
+    if (!q.pop(item)) {
+      std::this_thread::yield();
+      continue;
+    }
+    TEST_ASSERT_EQUAL_UINT32(expected, item.seq);
+    expected++;
+  }
+  producer.join();
+  TEST_ASSERT_FALSE(q.pop(item));
+  TEST_ASSERT_EQUAL_UINT32(full, q.getDropCount());
+  TEST_ASSERT_LESS_OR_EQUAL(64, q.getMaxDepth());
+}
+
+// Several producers hammering one queue that is mostly full. Producers retry until their
+// item is in, so every item of every producer comes out exactly once, each producer's in
+// the order it pushed them
+void test_mpsc_stress() {
+  static MpscQueue<item_t, 64> q;
+  std::vector<std::thread> producers;
+  std::atomic<uint32_t> full{0};
+  for (uint32_t p = 0; p < PRODUCERS; p++) {
+    producers.emplace_back([&, p]() {
+      for (uint32_t i = 0; i < ITEMS; i++) {
+        while (!q.push(item_t{p, i})) {
+          full.fetch_add(1, std::memory_order_relaxed);
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  uint32_t next[PRODUCERS] = {};
+  item_t item;
+  for (uint32_t received = 0; received < PRODUCERS * ITEMS;) {
+    if (!q.pop(item)) {
+      std::this_thread::yield();
+      continue;
+    }
+    TEST_ASSERT_LESS_THAN(PRODUCERS, item.producer);
+    TEST_ASSERT_EQUAL_UINT32(next[item.producer], item.seq);
+    next[item.producer]++;
+    received++;
+  }
+  for (std::thread &t : producers) t.join();
+  TEST_ASSERT_FALSE(q.pop(item));
+  for (uint32_t p = 0; p < PRODUCERS; p++) TEST_ASSERT_EQUAL_UINT32(ITEMS, next[p]);
+  TEST_ASSERT_EQUAL_UINT32(full.load(), q.getDropCount());
+}
+
+// Producers that don't retry, like an ISR: whatever is refused is counted, and what gets
+// through still comes out once and in order
+void test_mpsc_drops() {
+  static MpscQueue<item_t, 16> q;
+  std::vector<std::thread> producers;
+  std::atomic<bool> done{false};
+  for (uint32_t p = 0; p < PRODUCERS; p++) {
+    producers.emplace_back([&, p]() {
+      for (uint32_t i = 0; i < ITEMS; i++) {
+        q.push(item_t{p, i});
+        if ((i & 63) == 0) std::this_thread::yield();
+      }
+    });
+  }
+  std::thread joiner([&]() {
+    for (std::thread &t : producers) t.join();
+    done = true;
+  });
+
+  int64_t last[PRODUCERS];
+  for (int64_t &l : last) l = -1;
+  uint32_t received = 0;
+  item_t item;
+  for (;;) {
+    bool finished = done; // read before the pop, so nothing pushed after it is missed
+    if (q.pop(item)) {
+      TEST_ASSERT_LESS_THAN(PRODUCERS, item.producer);
+      TEST_ASSERT_TRUE((int64_t) item.seq > last[item.producer]);
+      last[item.producer] = item.seq;
+      received++;
+    } else if (finished) {
+      break;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  joiner.join();
+  TEST_ASSERT_EQUAL_UINT32(PRODUCERS * ITEMS, received + q.getDropCount());
+  TEST_ASSERT_GREATER_THAN(0, received);
+}
+
+// Byte records of every length up to the largest packet, each one's bytes made from its
+// number, come out whole and in order across every wrap of the ring
+static unsigned char recordByte(uint32_t n, size_t i) { return (unsigned char) (n * 31 + i); }
+static size_t recordLength(uint32_t n) { return (n * 7) % 461; }
+
+void test_byte_queue_records() {
+  static SpscByteQueue<2048> q;
+  uint32_t full = 0;
+  std::thread producer([&]() {
+    for (uint32_t n = 0; n < ITEMS; n++) {
+      size_t len = recordLength(n);
+      unsigned char *p;
+      while (!(p = q.reserve(len))) {
+        full++;
+        std::this_thread::yield();
+      }
+      for (size_t i = 0; i < len; i++) p[i] = recordByte(n, i);
+      q.commit(len);
+    }
+  });
+
+  for (uint32_t n = 0; n < ITEMS;) {
+    size_t len;
+    const unsigned char *p = q.front(len);
+    if (!p) {
+      std::this_thread::yield();
+      continue;
+    }
+    TEST_ASSERT_EQUAL(recordLength(n), len);
+    for (size_t i = 0; i < len; i++) {
+      if (p[i] != recordByte(n, i)) TEST_FAIL_MESSAGE("record bytes don't match");
+    }
+    q.pop();
+    n++;
+  }
+  producer.join();
+  size_t len;
+  TEST_ASSERT_NULL(q.front(len));
+  TEST_ASSERT_EQUAL_UINT32(full, q.getDropCount());
+  TEST_ASSERT_EQUAL_UINT32(0, q.bytesUsed());
+}
+
+// Millions of items per second from producer threads to one consumer, the consumer
+// spinning and the producers retrying when the queue is full. On a single core this is
+// mostly the cost of switching between the threads
+template <typename Queue>
+static double throughput(Queue &q, uint32_t producers) {
+  const uint32_t items = 1 << 20;
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t p = 0; p < producers; p++) {
+    threads.emplace_back([&q, p, producers, items]() {
+      for (uint32_t i = 0; i < items / producers; i++) {
+        while (!q.push(item_t{p, i})) std::this_thread::yield();
+      }
+    });
+  }
+  item_t item;
+  for (uint32_t received = 0; received < items / producers * producers;) {
+    if (q.pop(item)) received++;
+    else std::this_thread::yield();
+  }
+  for (std::thread &t : threads) t.join();
+  return items / std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void test_bench_throughput() {
+  static SpscQueue<item_t, 1024> spsc;
+  static MpscQueue<item_t, 1024> mpsc1, mpsc4;
+  char line[160];
+  snprintf(line, sizeof(line), "%u hardware threads. SpscQueue 1 producer %.1f M/s, MpscQueue 1 producer %.1f M/s, %d producers %.1f M/s",
+           std::thread::hardware_concurrency(), throughput(spsc, 1), throughput(mpsc1, 1), PRODUCERS, throughput(mpsc4, PRODUCERS));
+  TEST_MESSAGE(line);
+
+  // and one thread pushing and popping, the cost of the queue operations alone
+  const uint32_t items = 1 << 22;
+  static SpscQueue<item_t, 1024> s;
+  static MpscQueue<item_t, 1024> m;
+  static SpscByteQueue<4096> b;
+  item_t item;
+  size_t len;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < items; i++) {
+    s.push(item_t{0, i});
+    s.pop(item);
+  }
+  double spsc_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / items;
+  start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < items; i++) {
+    m.push(item_t{0, i});
+    m.pop(item);
+  }
+  double mpsc_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / items;
+  start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < items; i++) {
+    b.push(&i, sizeof(i));
+    b.front(len);
+    b.pop();
+  }
+  double byte_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / items;
+  snprintf(line, sizeof(line), "push + pop on one thread: SpscQueue %.1f ns, MpscQueue %.1f ns, SpscByteQueue %.1f ns",
+           spsc_ns, mpsc_ns, byte_ns);
+  TEST_MESSAGE(line);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_spsc_order);
+  RUN_TEST(test_mpsc_stress);
+  RUN_TEST(test_mpsc_drops);
+  RUN_TEST(test_byte_queue_records);
+  RUN_TEST(test_bench_throughput);
+  return UNITY_END();
+}
@@ -0,0 +1,196 @@
+// RingBuf reserve/commit (SdFat's RingBuf.h)
+//
+// pio test -e native -f test_ringbuf -v   (-v shows the benchmark output)
+
+#include <stdio.h>
+#include <chrono>
+#include <new>
+#include <vector>
+#include <unity.h>
+#include <RingBuf.h>
+#include <comms.h>
+
+// everything writeOut() hands over, in order
+struct MemFile {
+  std::vector<uint8_t> data;
+  int write(const void *buf, size_t count) {
+    const uint8_t *b = (const uint8_t *) buf;
+    data.insert(data.end(), b, b + count);
+    return count;
+  }
+  int read(void *buf, size_t count) { (void) buf; (void) count; return 0; }
+};
+
+#define RB_SIZE 256
+
+static MemFile file;
+static RingBuf<MemFile, RB_SIZE> rb;
+
+void setUp() {
+  file.data.clear();
+  rb.begin(&file);
+}
+
+void tearDown() {}
+
+// a reservation is invisible until it is committed, and only what was committed goes out
+void test_reserve_commit() {
+  RingBuf<MemFile, RB_SIZE>::Span span = rb.reserve(10);
+  TEST_ASSERT_EQUAL(10, span.size());
+  TEST_ASSERT_TRUE(span.contiguous());
+  for (int i = 0; i < 10; i++) span[i] = i;
+  TEST_ASSERT_EQUAL(0, rb.bytesUsed());
+
+  TEST_ASSERT_EQUAL(6, rb.commit(6));
+  TEST_ASSERT_EQUAL(6, rb.bytesUsed());
+  TEST_ASSERT_EQUAL(6, rb.writeOut(RB_SIZE));
+  const uint8_t expected[] = {0, 1, 2, 3, 4, 5};
+  TEST_ASSERT_EQUAL(6, file.data.size());
+  TEST_ASSERT_EQUAL_MEMORY(expected, file.data.data(), 6);
+  TEST_ASSERT_FALSE(rb.getWriteError());
+}
+
+// free space that wraps comes back as two pieces from reserve(), and not at all from
+// reserveContiguous(), which doesn't count that as an error
+void test_wrap() {
+  uint8_t fill[RB_SIZE - 20] = {};
+  rb.write(fill, sizeof(fill));
+  rb.writeOut(sizeof(fill));
+  file.data.clear();
+
+  // head is 20 bytes from the end, the whole buffer is free
+  TEST_ASSERT_NULL(rb.reserveContiguous(32));
+  TEST_ASSERT_FALSE(rb.getWriteError());
+  TEST_ASSERT_NOT_NULL(rb.reserveContiguous(20));
+
+  RingBuf<MemFile, RB_SIZE>::Span span = rb.reserve(32);
+  TEST_ASSERT_EQUAL(20, span.firstLen);
+  TEST_ASSERT_EQUAL(12, span.secondLen);
+  uint8_t data[32];
+  for (int i = 0; i < 32; i++) data[i] = 100 + i;
+  span.copy(0, data, 16);
+  span.copy(16, data + 16, 16);
+  rb.commit(32);
+
+  TEST_ASSERT_EQUAL(32, rb.writeOut(RB_SIZE));
+  TEST_ASSERT_EQUAL_MEMORY(data, file.data.data(), 32);
+
+  // and the head is at the start again, in one piece
+  TEST_ASSERT_NOT_NULL(rb.reserveContiguous(RB_SIZE - 12));
+}
+
+// asking for more than is free is the only thing that sets the write error
+void test_full() {
+  uint8_t fill[RB_SIZE - 8] = {};
+  rb.write(fill, sizeof(fill));
+
+  TEST_ASSERT_NOT_NULL(rb.reserveContiguous(8));
+  TEST_ASSERT_EQUAL(8, rb.reserve(8).size());
+  TEST_ASSERT_FALSE(rb.getWriteError());
+
+  TEST_ASSERT_EQUAL(0, rb.reserve(9).size());
+  TEST_ASSERT_TRUE(rb.getWriteError());
+  rb.clearWriteError();
+  TEST_ASSERT_NULL(rb.reserveContiguous(9));
+  TEST_ASSERT_TRUE(rb.getWriteError());
+}
+
+// random writes, reservations and write outs come out as one unbroken stream
+void test_random_stream() {
+  std::vector<uint8_t> expected;
+  uint32_t rng = 0x6D656F77;
+  auto next = [&rng]() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+  };
+  uint8_t value = 0;
+
+  for (int op = 0; op < 100000; op++) {
+    size_t count = next() % 70;
+    switch (next() % 4) {
+      case 0: { // write()
+        uint8_t buf[70];
+        for (size_t i = 0; i < count; i++) buf[i] = value + i;
+        if (rb.write(buf, count) == count) {
+          for (size_t i = 0; i < count; i++) expected.push_back(value++);
+        }
+        break;
+      }
+      case 1: { // reserve() and commit part of it
+        RingBuf<MemFile, RB_SIZE>::Span span = rb.reserve(count);
+        if (span.size() != count) break;
+        size_t used = count ? next() % (count + 1) : 0;
+        for (size_t i = 0; i < used; i++) span[i] = value + i;
+        rb.commit(used);
+        for (size_t i = 0; i < used; i++) expected.push_back(value++);
+        break;
+      }
+      case 2: { // reserveContiguous(), nullptr near the wrap
+        uint8_t *p = rb.reserveContiguous(count);
+        if (!p) break;
+        for (size_t i = 0; i < count; i++) p[i] = value + i;
+        rb.commit(count);
+        for (size_t i = 0; i < count; i++) expected.push_back(value++);
+        break;
+      }
+      default:
+        rb.writeOut(next() % RB_SIZE);
+        break;
+    }
+    rb.clearWriteError();
+    TEST_ASSERT_LESS_OR_EQUAL(RB_SIZE, rb.bytesUsed());
+  }
+  rb.writeOut(RB_SIZE);
+
+  TEST_ASSERT_EQUAL(expected.size(), file.data.size());
+  TEST_ASSERT_EQUAL_MEMORY(expected.data(), file.data.data(), expected.size());
+}
+
+// Sensor packets into a 400 KiB ring like the logger's, built in the Shart object and
+// copied in with write(), against built straight into ring memory
+void test_bench_copy() {
+
+  static RingBuf<MemFile, 400 * 512> big;
+  MemFile sink;
+  big.begin(&sink);
+  const int packets = 1 << 22;
+
+  auto run = [&](bool in_place) {
+    sensor_p staged;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < packets; i++) {
+      sensor_p *p = in_place ? (sensor_p *) big.reserveContiguous(sizeof(sensor_p)) : nullptr;
+      sensor_p &s = p ? *p : staged;
+      if (p) new (p) sensor_p();
+      s.data.us = i;
+      s.data.acc_x = i;
+      s.data.pres = 101325.0f;
+      if (p) big.commit(sizeof(sensor_p));
+      else big.write(&staged, sizeof(sensor_p));
+      // the consumer keeps up, without the cost of a real file
+      if (big.bytesUsed() > 200 * 512) {
+        big.begin(&sink);
+      }
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / packets;
+  };
+
+  double copied = run(false);
+  double direct = run(true);
+  char line[128];
+  snprintf(line, sizeof(line), "%u byte packets: write() %.1f ns, reserve/commit %.1f ns per packet",
+           (unsigned) sizeof(sensor_p), copied, direct);
+  TEST_MESSAGE(line);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_reserve_commit);
+  RUN_TEST(test_wrap);
+  RUN_TEST(test_full);
+  RUN_TEST(test_random_stream);
+  RUN_TEST(test_bench_copy);
+  return UNITY_END();
+}
@@ -0,0 +1,176 @@
+// SampleScheduler driven by SimulatedDrdy, no board needed
+//
+// pio test -e native -f test_scheduler
+
+#include <unity.h>
+#include <shart/util/scheduler_sim.h>
+
+#define EDGE_SLOT   0
+#define PERIOD_SLOT 1
+
+static SampleScheduler<2> scheduler;
+
+void setUp() {
+  scheduler = SampleScheduler<2>();
+}
+
+void tearDown() {}
+
+// Step the clock by loop_us, fire edges and count what due() hands out for slot
+static uint32_t run(SimulatedDrdy &drdy, uint8_t slot, uint32_t start_us, uint32_t end_us, uint32_t loop_us) {
+  uint32_t reads = 0;
+  for (uint32_t now = start_us; now < end_us; now += loop_us) {
+    drdy.advanceTo(now, scheduler);
+    if (scheduler.due(slot, now)) reads++;
+  }
+  return reads;
+}
+
+// a fast loop reads every edge exactly once, stamped with the edge time
+void test_edges_read_once() {
+  SimulatedDrdy drdy(EDGE_SLOT, 1000, 500);
+  scheduler.setInterrupt(EDGE_SLOT, 1000, 0);
+
+  uint32_t last_sample = 0;
+  for (uint32_t now = 0; now < 100000; now += 50) {
+    drdy.advanceTo(now, scheduler);
+    if (scheduler.due(EDGE_SLOT, now)) {
+      TEST_ASSERT_EQUAL_UINT32(500, scheduler.getSampleTime(EDGE_SLOT) % 1000);
+      TEST_ASSERT_TRUE(scheduler.getSampleTime(EDGE_SLOT) > last_sample || last_sample == 0);
+      last_sample = scheduler.getSampleTime(EDGE_SLOT);
+    }
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(100, drdy.getEdgeCount());
+  TEST_ASSERT_EQUAL_UINT32(drdy.getEdgeCount(), scheduler.getReadCount(EDGE_SLOT));
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.getOverrunCount(EDGE_SLOT));
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.getStaleCount(EDGE_SLOT));
+}
+
+// jittered edges still get stamped with their own time, not the loop's
+void test_edges_jitter() {
+  SimulatedDrdy drdy(EDGE_SLOT, 2000, 1000, 200);
+  scheduler.setInterrupt(EDGE_SLOT, 2000, 0);
+
+  for (uint32_t now = 0; now < 200000; now += 10) {
+    drdy.advanceTo(now, scheduler);
+    if (scheduler.due(EDGE_SLOT, now)) {
+      // the loop checks every 10 us, so the edge can't be older than that
+      TEST_ASSERT_LESS_OR_EQUAL(10, now - scheduler.getSampleTime(EDGE_SLOT));
+    }
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(drdy.getEdgeCount(), scheduler.getReadCount(EDGE_SLOT));
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.getOverrunCount(EDGE_SLOT));
+}
+
+// a loop slower than the ODR misses edges, and every missed one is counted
+void test_edges_overrun() {
+  SimulatedDrdy drdy(EDGE_SLOT, 1000);
+  scheduler.setInterrupt(EDGE_SLOT, 1000, 0);
+
+  uint32_t reads = run(drdy, EDGE_SLOT, 0, 100000, 2500);
+
+  TEST_ASSERT_EQUAL_UINT32(reads, scheduler.getReadCount(EDGE_SLOT));
+  TEST_ASSERT_EQUAL_UINT32(drdy.getEdgeCount(),
+                           scheduler.getReadCount(EDGE_SLOT) + scheduler.getOverrunCount(EDGE_SLOT));
+  TEST_ASSERT_GREATER_THAN(0, scheduler.getOverrunCount(EDGE_SLOT));
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.getStaleCount(EDGE_SLOT));
+}
+
+// no pin wired: one read per period, first one right away, no drift from loop jitter
+void test_period_fallback() {
+  scheduler.setPeriod(PERIOD_SLOT, 1000, 0);
+
+  TEST_ASSERT_TRUE(scheduler.due(PERIOD_SLOT, 0));
+  TEST_ASSERT_FALSE(scheduler.due(PERIOD_SLOT, 1));
+
+  // loop time that doesn't divide the period
+  uint32_t reads = 1;
+  for (uint32_t now = 1; now < 100000; now += 37) {
+    if (scheduler.due(PERIOD_SLOT, now)) {
+      reads++;
+      TEST_ASSERT_EQUAL_UINT32(now, scheduler.getSampleTime(PERIOD_SLOT));
+    }
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(100, reads);
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.getOverrunCount(PERIOD_SLOT));
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.getStaleCount(PERIOD_SLOT));
+}
+
+// sleeping through periods counts them as overruns but doesn't read them all back to back
+void test_period_no_catch_up() {
+  scheduler.setPeriod(PERIOD_SLOT, 1000, 0);
+  TEST_ASSERT_TRUE(scheduler.due(PERIOD_SLOT, 0));
+
+  TEST_ASSERT_TRUE(scheduler.due(PERIOD_SLOT, 5500));
+  // 1000 through 4000 were slept through, 5000 is the one being read now
+  TEST_ASSERT_EQUAL_UINT32(4, scheduler.getOverrunCount(PERIOD_SLOT));
+  TEST_ASSERT_FALSE(scheduler.due(PERIOD_SLOT, 5600));
+  TEST_ASSERT_TRUE(scheduler.due(PERIOD_SLOT, 6000));
+  TEST_ASSERT_EQUAL_UINT32(3, scheduler.getReadCount(PERIOD_SLOT));
+}
+
+// an edge slot with a dead pin is still served every SCHEDULER_STALE_PERIODS periods
+void test_stale_reads() {
+  scheduler.setInterrupt(EDGE_SLOT, 1000, 0);
+
+  uint32_t reads = 0;
+  for (uint32_t now = 0; now < 40000; now += 10) {
+    if (scheduler.due(EDGE_SLOT, now)) {
+      reads++;
+      TEST_ASSERT_EQUAL_UINT32(now, scheduler.getSampleTime(EDGE_SLOT));
+    }
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(40000 / (1000 * SCHEDULER_STALE_PERIODS) - 1, reads);
+  TEST_ASSERT_EQUAL_UINT32(reads, scheduler.getStaleCount(EDGE_SLOT));
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.getOverrunCount(EDGE_SLOT));
+}
+
+// once edges come back the slot goes back to being edge driven
+void test_stale_recovers() {
+  scheduler.setInterrupt(EDGE_SLOT, 1000, 0);
+
+  for (uint32_t now = 0; now < 20000; now += 10) scheduler.due(EDGE_SLOT, now);
+  uint32_t stale = scheduler.getStaleCount(EDGE_SLOT);
+  TEST_ASSERT_GREATER_THAN(0, stale);
+
+  SimulatedDrdy drdy(EDGE_SLOT, 1000, 20000);
+  uint32_t reads = run(drdy, EDGE_SLOT, 20000, 60000, 10);
+
+  TEST_ASSERT_EQUAL_UINT32(drdy.getEdgeCount(), reads);
+  TEST_ASSERT_EQUAL_UINT32(stale, scheduler.getStaleCount(EDGE_SLOT));
+}
+
+// slots don't share edges or periods
+void test_slots_independent() {
+  SimulatedDrdy drdy(EDGE_SLOT, 1250);
+  scheduler.setInterrupt(EDGE_SLOT, 1250, 0);
+  scheduler.setPeriod(PERIOD_SLOT, 5000, 0);
+
+  for (uint32_t now = 0; now < 100000; now += 20) {
+    drdy.advanceTo(now, scheduler);
+    scheduler.due(EDGE_SLOT, now);
+    scheduler.due(PERIOD_SLOT, now);
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(drdy.getEdgeCount(), scheduler.getReadCount(EDGE_SLOT));
+  TEST_ASSERT_EQUAL_UINT32(20, scheduler.getReadCount(PERIOD_SLOT));
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.getOverrunCount(EDGE_SLOT));
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.getOverrunCount(PERIOD_SLOT));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_edges_read_once);
+  RUN_TEST(test_edges_jitter);
+  RUN_TEST(test_edges_overrun);
+  RUN_TEST(test_period_fallback);
+  RUN_TEST(test_period_no_catch_up);
+  RUN_TEST(test_stale_reads);
+  RUN_TEST(test_stale_recovers);
+  RUN_TEST(test_slots_independent);
+  return UNITY_END();
+}
@@ -0,0 +1,180 @@
+// UBX framing and dispatch (UbxParser.h in Ublox7GPS)
+//
+// pio test -e native -f test_ubx -v   (-v shows the benchmark output)
+//
+// The benchmark runs on a made up stream. To run it on the receiver's real bytes as well,
+// point UBX_CAPTURE at a capture (a u-center .ubx log)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include <unity.h>
+#include <UbloxGps.h>
+
+typedef std::vector<uint8_t> bytes_t;
+
+// frames handled per message, and the last NAV-PVT's time of week
+static uint32_t handled[3];
+static uint32_t last_itow;
+
+void setUp() {
+  memset(handled, 0, sizeof(handled));
+  last_itow = 0;
+}
+
+void tearDown() {}
+
+// a UBX frame with a good checksum on the end of out
+static void ubxFrame(bytes_t &out, uint8_t cls, uint8_t id, const void *payload, uint16_t len) {
+  size_t start = out.size();
+  uint8_t header[] = {UBX_SYNC_1, UBX_SYNC_2, cls, id, (uint8_t) len, (uint8_t) (len >> 8)};
+  out.insert(out.end(), header, header + sizeof(header));
+  out.insert(out.end(), (const uint8_t *) payload, (const uint8_t *) payload + len);
+  uint8_t a = 0, b = 0;
+  for (size_t i = start + 2; i < out.size(); i++) {
+    a += out[i];
+    b += a;
+  }
+  out.push_back(a);
+  out.push_back(b);
+}
+
+// 10 Hz epochs of NAV-PVT, NAV-TIMEGPS and a 24 satellite NAV-SAT, with an ACK and some NMEA
+// every 50th, and a corrupted NAV-SAT every 100th
+static bytes_t madeUpStream(int epochs) {
+  bytes_t stream;
+  NavPvtPacket pvt = {};
+  pvt.fixType = 3;
+  pvt.numSV = 12;
+  pvt.lat = 325000000;
+  pvt.lon = -1170000000;
+  NavTimeGpsPacket time = {};
+  uint8_t sat[sizeof(NavSatPacket) - sizeof(commonHeader) + 24 * sizeof(NavSatSv)] = {};
+  sat[5] = 24;
+  const char *nmea = "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n";
+  for (int epoch = 0; epoch < epochs; epoch++) {
+    pvt.iTOW += 100;
+    time.iTOW = pvt.iTOW;
+    memcpy(sat, &pvt.iTOW, 4);
+    ubxFrame(stream, UBX_CLASS_NAV, UBX_NAV_PVT, &pvt.iTOW, sizeof(pvt) - sizeof(commonHeader));
+    ubxFrame(stream, UBX_CLASS_NAV, UBX_NAV_TIMEGPS, &time.iTOW, sizeof(time) - sizeof(commonHeader));
+    ubxFrame(stream, UBX_CLASS_NAV, UBX_NAV_SAT, sat, sizeof(sat));
+    if (epoch % 50 == 0) {
+      uint8_t ack[] = {UBX_CLASS_CFG, 0x08};
+      ubxFrame(stream, UBX_CLASS_ACK, UBX_ACK_ACK, ack, sizeof(ack));
+      stream.insert(stream.end(), nmea, nmea + strlen(nmea));
+    }
+    if (epoch % 100 == 7) stream[stream.size() - 40] ^= 0x10; // bad checksum on the NAV-SAT
+  }
+  return stream;
+}
+
+static void countFrame(const UbxFrame &frame, void *context) {
+  handled[(intptr_t) context]++;
+  if (frame.id == UBX_NAV_PVT) {
+    const NavPvtPacket *pvt = frame.as<NavPvtPacket>();
+    TEST_ASSERT_NOT_NULL(pvt);
+    last_itow = pvt->iTOW;
+  }
+}
+
+static void registerNav(UbxParser<UBLOXGPS_MAX_PAYLOAD> &parser) {
+  const uint8_t ids[] = {UBX_NAV_PVT, UBX_NAV_TIMEGPS, UBX_NAV_SAT};
+  for (intptr_t i = 0; i < 3; i++) parser.on(UBX_CLASS_NAV, ids[i], countFrame, (void *) i);
+}
+
+// update()'s 64 byte chunks and a byte at a time find the same frames, and only the good ones
+void test_made_up_stream() {
+  bytes_t stream = madeUpStream(1000);
+  static UbxParser<UBLOXGPS_MAX_PAYLOAD> chunked, bytes;
+  registerNav(chunked);
+  registerNav(bytes);
+
+  for (size_t i = 0; i < stream.size(); i += 64) chunked.push(stream.data() + i, std::min((size_t) 64, stream.size() - i));
+  TEST_ASSERT_EQUAL_UINT32(1000, handled[0]);
+  TEST_ASSERT_EQUAL_UINT32(1000, handled[1]);
+  TEST_ASSERT_EQUAL_UINT32(990, handled[2]);
+  TEST_ASSERT_EQUAL_UINT32(100000, last_itow);
+  TEST_ASSERT_EQUAL_UINT32(20, chunked.getUnhandled());
+  TEST_ASSERT_EQUAL_UINT32(10, chunked.getChecksumErrors());
+  TEST_ASSERT_EQUAL_UINT32(1000 + 1000 + 990 + 20, chunked.getFrames());
+  TEST_ASSERT_EQUAL_UINT32(0, chunked.getOversize());
+
+  for (uint8_t b : stream) bytes.push(b);
+  TEST_ASSERT_EQUAL_UINT32(2000, handled[0]);
+  TEST_ASSERT_EQUAL_UINT32(chunked.getFrames(), bytes.getFrames());
+  TEST_ASSERT_EQUAL_UINT32(chunked.getChecksumErrors(), bytes.getChecksumErrors());
+}
+
+// a length over MaxPayload is a false sync, the frame right after it still comes through
+void test_false_sync() {
+  static UbxParser<UBLOXGPS_MAX_PAYLOAD> parser;
+  registerNav(parser);
+  bytes_t stream = {UBX_SYNC_1, UBX_SYNC_2, UBX_CLASS_NAV, UBX_NAV_PVT, 0xFF, 0xFF};
+  NavPvtPacket pvt = {};
+  pvt.iTOW = 1234;
+  ubxFrame(stream, UBX_CLASS_NAV, UBX_NAV_PVT, &pvt.iTOW, sizeof(pvt) - sizeof(commonHeader));
+  parser.push(stream.data(), stream.size());
+  TEST_ASSERT_EQUAL_UINT32(1, parser.getOversize());
+  TEST_ASSERT_EQUAL_UINT32(1, handled[0]);
+  TEST_ASSERT_EQUAL_UINT32(1234, last_itow);
+}
+
+// ns per byte in 64 byte chunks and a byte at a time
+static void bench(const char *name, const bytes_t &stream) {
+  static UbxParser<UBLOXGPS_MAX_PAYLOAD> chunked, bytes;
+  chunked = UbxParser<UBLOXGPS_MAX_PAYLOAD>();
+  bytes = UbxParser<UBLOXGPS_MAX_PAYLOAD>();
+  registerNav(chunked);
+  registerNav(bytes);
+
+  const int PASSES = 20;
+  auto start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < PASSES; pass++) {
+    for (size_t i = 0; i < stream.size(); i += 64) chunked.push(stream.data() + i, std::min((size_t) 64, stream.size() - i));
+  }
+  auto mid = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < PASSES; pass++) {
+    for (uint8_t b : stream) bytes.push(b);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double total = (double) stream.size() * PASSES;
+  double chunked_ns = std::chrono::duration<double, std::nano>(mid - start).count();
+  double bytes_ns   = std::chrono::duration<double, std::nano>(end - mid).count();
+  char line[200];
+  snprintf(line, sizeof(line), "%s, %zu bytes: %u frames, %u unhandled, %u bad checksums, %u too long",
+           name, stream.size(), chunked.getFrames() / PASSES, chunked.getUnhandled() / PASSES,
+           chunked.getChecksumErrors() / PASSES, chunked.getOversize() / PASSES);
+  TEST_MESSAGE(line);
+  snprintf(line, sizeof(line), "  64 byte chunks %.2f ns/B (%.1f MB/s), byte at a time %.2f ns/B (%.1f MB/s)",
+           chunked_ns / total, total / chunked_ns * 1000, bytes_ns / total, total / bytes_ns * 1000);
+  TEST_MESSAGE(line);
+}
+
+void test_bench_made_up() {
+  bench("made up", madeUpStream(10000));
+}
+
+void test_bench_capture() {
+  const char *path = getenv("UBX_CAPTURE");
+  if (!path) TEST_IGNORE_MESSAGE("set UBX_CAPTURE to a u-center .ubx log");
+  FILE *f = fopen(path, "rb");
+  TEST_ASSERT_NOT_NULL(f);
+  bytes_t stream;
+  uint8_t chunk[4096];
+  while (size_t n = fread(chunk, 1, sizeof(chunk), f)) stream.insert(stream.end(), chunk, chunk + n);
+  fclose(f);
+  bench(path, stream);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_made_up_stream);
+  RUN_TEST(test_false_sync);
+  RUN_TEST(test_bench_made_up);
+  RUN_TEST(test_bench_capture);
+  return UNITY_END();
+}